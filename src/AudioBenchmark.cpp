@@ -0,0 +1,378 @@
+#include "AudioBenchmark.h"
+
+#include "BlipBuffer.h"
+#include "FIRDecimator.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <numbers>
+#include <span>
+#include <vector>
+
+namespace NesEm
+{
+	namespace
+	{
+		constexpr double OUTPUT_RATE{ Config::AUDIO_SAMPLE_RATE };
+		// Every path starts from the APU, which changes its output on whole cycles of this clock
+		constexpr double CLOCK_RATE{ Config::CPU_CLOCK_RATE };
+
+		// The signal is fed as frames of this many cycles, like the emulator does, one second per pass
+		constexpr uint32_t FRAME_CLOCKS{ static_cast<uint32_t>(CLOCK_RATE / 50.0) };
+		constexpr uint32_t FRAMES_PER_PASS{ 50 };
+		constexpr uint32_t PASS_CLOCKS{ FRAME_CLOCKS * FRAMES_PER_PASS };
+
+		// Test square in APU cycles per half period, about 3 kHz like a high pulse note, every harmonic from the 9th up aliases
+		constexpr uint32_t SQUARE_HALF_PERIOD{ 277 };
+		constexpr double SQUARE_FREQUENCY{ CLOCK_RATE / (2.0 * SQUARE_HALF_PERIOD) };
+		constexpr int16_t AMPLITUDE{ 8000 };
+
+		// What belongs in the output, and the lowest frequency that may not fold back into it
+		constexpr double PASSBAND_EDGE{ 20000.0 };
+		constexpr double STOPBAND_EDGE{ OUTPUT_RATE - PASSBAND_EDGE };
+
+		// Outputs left out of quality measurements while the filters and the blip buffer's high pass settle
+		constexpr uint32_t SETTLE_SAMPLES{ Config::AUDIO_SAMPLE_RATE / 4 };
+
+		using Clock = std::chrono::steady_clock;
+
+		[[nodiscard]] double SecondsSince(Clock::time_point start) noexcept
+		{
+			return std::chrono::duration<double>(Clock::now() - start).count();
+		}
+
+		[[nodiscard]] double ToDb(double gain) noexcept
+		{
+			return 20.0 * std::log10(std::max(gain, 1e-12));
+		}
+
+		[[nodiscard]] char const* VectorizationName(FIRDecimator::Vectorization vectorization) noexcept
+		{
+			switch (vectorization)
+			{
+			case FIRDecimator::Vectorization::AVX2:
+				return "AVX2";
+			case FIRDecimator::Vectorization::SSE2:
+				return "SSE2";
+			default:
+				return "scalar";
+			}
+		}
+
+		// Return std::vector one pass of the test square, a sample for every APU cycle
+		[[nodiscard]] std::vector<int16_t> SquareAtClock()
+		{
+			std::vector<int16_t> samples(PASS_CLOCKS);
+			for (uint32_t cycle{ 0 }; cycle < PASS_CLOCKS; ++cycle)
+			{
+				samples[cycle] = ((cycle / SQUARE_HALF_PERIOD) & 1) ? -AMPLITUDE : AMPLITUDE;
+			}
+			return samples;
+		}
+
+		// Return std::vector one pass of a sine, a sample for every APU cycle
+		[[nodiscard]] std::vector<int16_t> SineAtClock(double frequency)
+		{
+			std::vector<int16_t> samples(PASS_CLOCKS);
+			for (uint32_t cycle{ 0 }; cycle < PASS_CLOCKS; ++cycle)
+			{
+				double const phase{ 2.0 * std::numbers::pi * frequency * cycle / CLOCK_RATE };
+				samples[cycle] = static_cast<int16_t>(std::lrint(AMPLITUDE * std::sin(phase)));
+			}
+			return samples;
+		}
+
+		// Picks the cycle closest before every output sample, what a naive emulator does
+		[[nodiscard]] std::vector<int16_t> NearestSample(std::span<int16_t const> input)
+		{
+			std::vector<int16_t> output{ };
+			for (double position{ 0.0 }; position < static_cast<double>(input.size()); position += CLOCK_RATE / OUTPUT_RATE)
+			{
+				output.push_back(input[static_cast<size_t>(position)]);
+			}
+			return output;
+		}
+
+		// Param std::span every cycle of the signal, goes in a frame at a time
+		[[nodiscard]] std::vector<int16_t> Decimate(FIRDecimator& decimator, std::span<int16_t const> input)
+		{
+			std::vector<int16_t> output{ };
+			for (size_t start{ 0 }; start < input.size(); start += FRAME_CLOCKS)
+			{
+				std::span<int16_t const> const frame{ input.subspan(start, std::min<size_t>(FRAME_CLOCKS, input.size() - start)) };
+
+				size_t const end{ output.size() };
+				output.resize(end + decimator.MaxOutput(static_cast<uint32_t>(frame.size())));
+				output.resize(end + decimator.Process(frame, std::span{ output }.subspan(end)));
+			}
+			return output;
+		}
+
+		// Param uint32_t rate of the blip buffer as a multiple of the output rate, above 1 a decimator brings it down
+		// Return std::vector one pass of the test square, only its edges go in
+		[[nodiscard]] std::vector<int16_t> BlipSquare(uint32_t oversampling)
+		{
+			double const blipRate{ OUTPUT_RATE * oversampling };
+			BlipBuffer blip{ CLOCK_RATE, blipRate, static_cast<uint32_t>(blipRate / 10.0) };
+			std::unique_ptr<FIRDecimator> const pDecimator{ oversampling > 1 ? std::make_unique<FIRDecimator>(blipRate, OUTPUT_RATE) : nullptr };
+
+			std::vector<int16_t> output{ };
+			std::vector<int16_t> frameSamples{ };
+			blip.AddDelta(0, AMPLITUDE);
+			for (uint32_t frame{ 0 }; frame < FRAMES_PER_PASS; ++frame)
+			{
+				uint32_t const frameStart{ frame * FRAME_CLOCKS };
+				uint32_t edge{ (frameStart + SQUARE_HALF_PERIOD - 1) / SQUARE_HALF_PERIOD * SQUARE_HALF_PERIOD };
+				for (edge = std::max(edge, SQUARE_HALF_PERIOD); edge < frameStart + FRAME_CLOCKS; edge += SQUARE_HALF_PERIOD)
+				{
+					// Falls on odd multiples of the half period, rises on even ones
+					int32_t const delta{ ((edge / SQUARE_HALF_PERIOD) & 1) ? -2 * AMPLITUDE : 2 * AMPLITUDE };
+					blip.AddDelta(edge - frameStart, delta);
+				}
+				blip.EndFrame(FRAME_CLOCKS);
+
+				frameSamples.resize(blip.SamplesAvailable());
+				blip.ReadSamples(frameSamples);
+				if (pDecimator)
+				{
+					size_t const end{ output.size() };
+					output.resize(end + pDecimator->MaxOutput(static_cast<uint32_t>(frameSamples.size())));
+					output.resize(end + pDecimator->Process(frameSamples, std::span{ output }.subspan(end)));
+				}
+				else
+				{
+					output.insert(output.end(), frameSamples.begin(), frameSamples.end());
+				}
+			}
+			return output;
+		}
+
+		// Least squares fit of DC and every harmonic of the fundamental below the limit, after the settle time
+		// Return double power of what the fit leaves (aliasing, noise) relative to the power of the fit, dB
+		[[nodiscard]] double ResidualDb(std::span<int16_t const> samples, double fundamental, double limit)
+		{
+			uint32_t const harmonics{ static_cast<uint32_t>(std::ceil(limit / fundamental)) - 1 };
+			size_t const terms{ 1 + 2 * static_cast<size_t>(std::max(harmonics, 1u)) };
+			if (samples.size() <= SETTLE_SAMPLES + terms)
+			{
+				return 0.0;
+			}
+			std::span<int16_t const> const measured{ samples.subspan(SETTLE_SAMPLES) };
+
+			auto const basis{ [&](size_t n, std::vector<double>& row)
+				{
+					row[0] = 1.0;
+					for (size_t harmonic{ 1 }; 2 * harmonic < terms; ++harmonic)
+					{
+						double const phase{ 2.0 * std::numbers::pi * fundamental * static_cast<double>(harmonic * n) / OUTPUT_RATE };
+						row[2 * harmonic - 1] = std::cos(phase);
+						row[2 * harmonic] = std::sin(phase);
+					}
+				} };
+
+			// Normal equations, augmented with the right hand side
+			std::vector<double> matrix(terms * (terms + 1), 0.0);
+			std::vector<double> row(terms);
+			for (size_t n{ 0 }; n < measured.size(); ++n)
+			{
+				basis(n, row);
+				for (size_t i{ 0 }; i < terms; ++i)
+				{
+					for (size_t j{ 0 }; j < terms; ++j)
+					{
+						matrix[i * (terms + 1) + j] += row[i] * row[j];
+					}
+					matrix[i * (terms + 1) + terms] += row[i] * measured[n];
+				}
+			}
+
+			// Gaussian elimination, the basis is close to orthogonal so this is well conditioned
+			for (size_t column{ 0 }; column < terms; ++column)
+			{
+				double const pivot{ matrix[column * (terms + 1) + column] };
+				for (size_t i{ 0 }; i < terms; ++i)
+				{
+					if (i == column)
+					{
+						continue;
+					}
+					double const factor{ matrix[i * (terms + 1) + column] / pivot };
+					for (size_t j{ column }; j <= terms; ++j)
+					{
+						matrix[i * (terms + 1) + j] -= factor * matrix[column * (terms + 1) + j];
+					}
+				}
+			}
+
+			double signal{ 0.0 };
+			double residual{ 0.0 };
+			for (size_t n{ 0 }; n < measured.size(); ++n)
+			{
+				basis(n, row);
+				double fit{ 0.0 };
+				for (size_t i{ 1 }; i < terms; ++i)
+				{
+					fit += row[i] * matrix[i * (terms + 1) + terms] / matrix[i * (terms + 1) + i];
+				}
+				double const dc{ matrix[terms] / matrix[0] };
+				double const error{ measured[n] - dc - fit };
+				signal += fit * fit;
+				residual += error * error;
+			}
+			return 10.0 * std::log10(std::max(residual, 1e-12) / std::max(signal, 1e-12));
+		}
+
+		// Return double gain of a pass of the signal in dB relative to its input level
+		[[nodiscard]] double LevelDb(std::span<int16_t const> samples) noexcept
+		{
+			if (samples.size() <= SETTLE_SAMPLES)
+			{
+				return 0.0;
+			}
+
+			double power{ 0.0 };
+			for (int16_t const sample : samples.subspan(SETTLE_SAMPLES))
+			{
+				power += static_cast<double>(sample) * sample;
+			}
+			double const rms{ std::sqrt(power / static_cast<double>(samples.size() - SETTLE_SAMPLES)) };
+			// Silence reads as ToDb's floor instead of -inf
+			return ToDb(rms / (AMPLITUDE / std::numbers::sqrt2));
+		}
+
+		void LogFilter(char const* pName, FIRDecimator const& decimator, double inputRate)
+		{
+			constexpr uint32_t PASSBAND_POINTS{ 1024 };
+			constexpr uint32_t STOPBAND_POINTS{ 16384 };
+
+			double lowest{ 1e9 };
+			double highest{ -1e9 };
+			for (uint32_t point{ 0 }; point <= PASSBAND_POINTS; ++point)
+			{
+				double const gain{ ToDb(decimator.Response(PASSBAND_EDGE * point / PASSBAND_POINTS)) };
+				lowest = std::min(lowest, gain);
+				highest = std::max(highest, gain);
+			}
+
+			double stopband{ -1e9 };
+			for (uint32_t point{ 0 }; point <= STOPBAND_POINTS; ++point)
+			{
+				double const frequency{ STOPBAND_EDGE + (inputRate / 2.0 - STOPBAND_EDGE) * point / STOPBAND_POINTS };
+				stopband = std::max(stopband, ToDb(decimator.Response(frequency)));
+			}
+
+			SDL_Log("Filter %s: %u taps x %u phases, passband (0 - %.0f Hz) ripple %.5f dB, stopband (from %.0f Hz) %.1f dB",
+				pName, decimator.TapCount(), decimator.PhaseCount(), PASSBAND_EDGE, highest - lowest, STOPBAND_EDGE, stopband);
+		}
+
+		[[nodiscard]] bool ParseSeconds(std::string_view text, uint32_t& seconds) noexcept
+		{
+			auto const [pEnd, error] { std::from_chars(text.data(), text.data() + text.size(), seconds) };
+			return error == std::errc{ } && pEnd == text.data() + text.size() && seconds > 0;
+		}
+	}
+
+	bool IsAudioBenchmarkRun(int argc, char* argv[]) noexcept
+	{
+		return argc >= 2 && std::string_view{ argv[1] } == BENCH_AUDIO_OPTION;
+	}
+
+	int RunAudioBenchmark(int argc, char* argv[])
+	{
+		uint32_t seconds{ 3 };
+		if (!IsAudioBenchmarkRun(argc, argv) || argc > 3 || (argc == 3 && !ParseSeconds(argv[2], seconds)))
+		{
+			SDL_Log("%s", "Usage: --bench-audio [seconds]");
+			return 1;
+		}
+
+		SDL_Log("Audio benchmark: %.0f Hz APU clock -> %.0f Hz, %u seconds of signal per throughput run", CLOCK_RATE, OUTPUT_RATE, seconds);
+
+		{
+			FIRDecimator const direct{ CLOCK_RATE, OUTPUT_RATE };
+			FIRDecimator const oversampled{ OUTPUT_RATE * 2.0, OUTPUT_RATE };
+			LogFilter("APU clock", direct, CLOCK_RATE);
+			LogFilter("2x output rate", oversampled, OUTPUT_RATE * 2.0);
+		}
+
+		// FIR decimator on every cycle, once per instruction set the CPU has, every one has to produce the same samples
+		std::vector<int16_t> const square{ SquareAtClock() };
+		std::vector<int16_t> reference{ };
+		bool isIdentical{ true };
+		for (uint8_t level{ 0 }; level <= static_cast<uint8_t>(FIRDecimator::BestVectorization()); ++level)
+		{
+			auto const vectorization{ static_cast<FIRDecimator::Vectorization>(level) };
+			FIRDecimator decimator{ CLOCK_RATE, OUTPUT_RATE, vectorization };
+
+			Clock::time_point const start{ Clock::now() };
+			std::vector<int16_t> output{ };
+			for (uint32_t pass{ 0 }; pass < seconds; ++pass)
+			{
+				std::vector<int16_t> const passOutput{ Decimate(decimator, square) };
+				if (pass == 0)
+				{
+					output = passOutput;
+				}
+			}
+			double const elapsed{ SecondsSince(start) };
+
+			if (reference.empty())
+			{
+				reference = output;
+			}
+			isIdentical = isIdentical && output == reference;
+
+			SDL_Log("Throughput FIR on every cycle, %s: %.1f M input samples/s, %.0fx real time", VectorizationName(vectorization),
+				static_cast<double>(PASS_CLOCKS) * seconds / elapsed / 1e6, seconds / elapsed);
+		}
+		SDL_Log("Instruction sets produce identical output: %s", isIdentical ? "yes" : "NO");
+
+		// Every path on the same square, time per second of signal
+		struct Path final
+		{
+			char const* pName;
+			std::vector<int16_t> output;
+			double seconds;
+		};
+		std::array<Path, 4> paths{ };
+
+		Clock::time_point start{ Clock::now() };
+		paths[0] = { "nearest sample", NearestSample(square), SecondsSince(start) };
+		start = Clock::now();
+		paths[1] = { "blip buffer", BlipSquare(1), SecondsSince(start) };
+		start = Clock::now();
+		paths[2] = { "blip buffer 2x + FIR", BlipSquare(2), SecondsSince(start) };
+		start = Clock::now();
+		{
+			FIRDecimator decimator{ CLOCK_RATE, OUTPUT_RATE };
+			paths[3] = { "FIR on every cycle", Decimate(decimator, square), SecondsSince(start) };
+		}
+
+		for (Path const& path : paths)
+		{
+			SDL_Log("Quality %.1f Hz square, %s: aliasing and noise %.1f dB, %.0fx real time", SQUARE_FREQUENCY, path.pName,
+				ResidualDb(path.output, SQUARE_FREQUENCY, OUTPUT_RATE / 2.0), 1.0 / std::max(path.seconds, 1e-9));
+		}
+
+		// The decimator has to keep what is below the passband clean and remove what is above the stopband
+		for (double const frequency : { 1000.0, 10000.0 })
+		{
+			FIRDecimator decimator{ CLOCK_RATE, OUTPUT_RATE };
+			std::vector<int16_t> const output{ Decimate(decimator, SineAtClock(frequency)) };
+			SDL_Log("Quality %.0f Hz sine, FIR on every cycle: noise and distortion %.1f dB, level %.3f dB",
+				frequency, ResidualDb(output, frequency, frequency * 1.5), LevelDb(output));
+		}
+		for (double const frequency : { 30000.0, 100000.0 })
+		{
+			FIRDecimator decimator{ CLOCK_RATE, OUTPUT_RATE };
+			SDL_Log("Quality %.0f Hz sine, FIR on every cycle: folds back at %.1f dB, nearest sample at %.1f dB",
+				frequency, LevelDb(Decimate(decimator, SineAtClock(frequency))), LevelDb(NearestSample(SineAtClock(frequency))));
+		}
+
+		return isIdentical ? 0 : 1;
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef NES_EMULATOR_AUDIO_BENCHMARK
+#define NES_EMULATOR_AUDIO_BENCHMARK
+
+#include <string_view>
+
+namespace NesEm
+{
+	// Measures the ways APU output can be brought down to Config::AUDIO_SAMPLE_RATE, no ROM or window needed
+	//
+	// Command line: --bench-audio [seconds]
+	//
+	// Filter: FIR decimator taps and phases, passband ripple and worst stopband gain
+	// Throughput: input samples per second of the FIR decimator on every APU cycle, per instruction set
+	// Quality: what is left of an APU square wave (or sine) after fitting the harmonics that belong in the output,
+	// aliasing and noise relative to the signal in dB (lower is better), for every path:
+	//   nearest sample, blip buffer, blip buffer at 2x + FIR decimator, FIR decimator on every cycle
+	constexpr std::string_view BENCH_AUDIO_OPTION{ "--bench-audio" };
+
+	// Return bool does the command line ask for the audio benchmark
+	[[nodiscard]] bool IsAudioBenchmarkRun(int argc, char* argv[]) noexcept;
+
+	// Return int exit code for main
+	[[nodiscard]] int RunAudioBenchmark(int argc, char* argv[]);
+}
+
+#endif
@@ -0,0 +1,168 @@
+#include "EmulationThread.h"
+
+#include "AudioOutput.h"
+#include "Emulator.h"
+#include "Timer.h"
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+namespace NesEm
+{
+	EmulationThread::EmulationThread(Emulator& emulator, AudioOutput& audioOutput, Settings const& settings):
+		m_Emulator{ emulator },
+		m_AudioOutput{ audioOutput },
+		m_Settings{ settings },
+		m_IsAudioPaced{ settings.pacing == Pacing::Audio && audioOutput.IsOpen() }
+	{
+		m_Thread = std::thread{ &EmulationThread::Run, this };
+	}
+
+	EmulationThread::~EmulationThread()
+	{
+		m_IsRunning.store(false, std::memory_order_relaxed);
+		m_Thread.join();
+	}
+
+	void EmulationThread::SubmitInput(std::array<uint8_t, 2> const& buttons) noexcept
+	{
+		m_Input.store(static_cast<uint16_t>(buttons[0] | (buttons[1] << 8)), std::memory_order_relaxed);
+	}
+
+	void EmulationThread::Run() noexcept
+	{
+		ApplySettings();
+
+		GameTime& time{ GameTime::GetInstance() };
+		time.SetFrameRate(Config::FRAME_RATE_NUMERATOR, Config::FRAME_RATE_DENOMINATOR);
+
+		// Rounded up, the APU makes one sample more or less depending on where the frame ends
+		uint32_t const frameSamples{ static_cast<uint32_t>((uint64_t{ Config::AUDIO_SAMPLE_RATE } * Config::FRAME_RATE_DENOMINATOR
+			+ Config::FRAME_RATE_NUMERATOR - 1) / Config::FRAME_RATE_NUMERATOR) };
+
+		uint64_t statisticsStart{ SDL_GetTicksNS() };
+		uint64_t statisticsFrames{ 0 };
+
+		while (m_IsRunning.load(std::memory_order_relaxed))
+		{
+			uint16_t const input{ m_Input.load(std::memory_order_relaxed) };
+			m_Emulator.SetControllerButtons(0, static_cast<uint8_t>(input));
+			m_Emulator.SetControllerButtons(1, static_cast<uint8_t>(input >> 8));
+
+			if (m_IsAudioPaced)
+			{
+				m_AudioOutput.WaitForSpace(frameSamples);
+
+				// Less than a frame of sound left means we are a full frame behind
+				m_Emulator.RunFrame(m_AudioOutput.QueuedSamples() < frameSamples);
+				// No rate control, the samples per frame have to stay exact for the device to run emulation at the right speed
+				m_AudioOutput.QueueSamples(m_Emulator.AudioSamples());
+			}
+			else
+			{
+				time.Update();
+
+				m_Emulator.RunFrame(time.IsBehind());
+				m_AudioOutput.QueueSamples(m_Emulator.AudioSamples());
+				// Dynamic rate control, keeps the audio queue half full whatever the host's clocks
+				m_Emulator.SetAudioRateRatio(m_AudioOutput.RateRatio());
+			}
+
+			PublishFrame();
+
+			++statisticsFrames;
+			if (m_Settings.logStatistics)
+			{
+				uint64_t const now{ SDL_GetTicksNS() };
+				if (now - statisticsStart >= 1'000'000'000)
+				{
+					LogStatistics(statisticsFrames, static_cast<double>(now - statisticsStart) / 1'000'000'000.0);
+					statisticsStart = now;
+					statisticsFrames = 0;
+				}
+			}
+
+			//Cap FPS, audio pacing already waited
+			if (!m_IsAudioPaced)
+			{
+				time.WaitForNextFrame();
+			}
+		}
+	}
+
+	void EmulationThread::ApplySettings() const noexcept
+	{
+		if (m_Settings.priority != SDL_THREAD_PRIORITY_NORMAL && !SDL_SetCurrentThreadPriority(m_Settings.priority))
+		{
+			SDL_Log("Could not set the emulation thread's priority: %s", SDL_GetError());
+		}
+
+		if (m_Settings.cpu < 0)
+		{
+			return;
+		}
+
+#if defined(_WIN32)
+		if (SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << m_Settings.cpu) == 0)
+		{
+			SDL_Log("Could not pin the emulation thread to CPU %d", m_Settings.cpu);
+		}
+#elif defined(__linux__)
+		cpu_set_t cpus{ };
+		CPU_ZERO(&cpus);
+		CPU_SET(static_cast<size_t>(m_Settings.cpu), &cpus);
+		if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+		{
+			SDL_Log("Could not pin the emulation thread to CPU %d", m_Settings.cpu);
+		}
+#else
+		SDL_Log("%s", "Pinning the emulation thread to a CPU is not supported on this platform");
+#endif
+	}
+
+	void EmulationThread::PublishFrame() noexcept
+	{
+		Frame& frame{ m_Frames.Back() };
+
+		// The back buffer still holds whatever was published in it a few frames ago, often the same picture
+		if (frame.sequence != m_Emulator.FrameSequence())
+		{
+			std::span<uint8_t const> const indices{ m_Emulator.FrameIndices() };
+			std::span<uint8_t const> const emphasis{ m_Emulator.FrameEmphasis() };
+			std::span<uint8_t const> const phases{ m_Emulator.FramePhases() };
+			frame.indices.assign(indices.begin(), indices.end());
+			frame.emphasis.assign(emphasis.begin(), emphasis.end());
+			frame.phases.assign(phases.begin(), phases.end());
+			frame.sequence = m_Emulator.FrameSequence();
+		}
+
+		m_Frames.Publish();
+		m_Frames.Notify();
+	}
+
+	void EmulationThread::LogStatistics(uint64_t frames, double seconds) noexcept
+	{
+		SDL_Log("Emulation: %.1f FPS", static_cast<double>(frames) / seconds);
+		if (!m_IsAudioPaced)
+		{
+			GameTime& time{ GameTime::GetInstance() };
+			GameTime::FrameStatistics const frameStats{ time.FrameStats() };
+			SDL_Log("Frame time: %.3f ms (%.3f - %.3f), jitter: %.3f ms, drift: %.3f ms (max %.3f), resyncs: %llu", frameStats.average, frameStats.min, frameStats.max,
+				frameStats.jitter, frameStats.drift, frameStats.maxDrift, static_cast<unsigned long long>(time.ResyncCount()));
+			time.ResetFrameStats();
+		}
+		SDL_Log("Unchanged frames skipped: %llu", static_cast<unsigned long long>(m_Emulator.SkippedFrameCount()));
+		SDL_Log("Frames dropped: %llu", static_cast<unsigned long long>(m_Emulator.DroppedFrameCount()));
+		SDL_Log("Audio queued: %.1f ms, underruns: %llu, overruns: %llu", 1000.0 * m_AudioOutput.QueuedSamples() / m_AudioOutput.SampleRate(),
+			static_cast<unsigned long long>(m_AudioOutput.UnderrunCount()), static_cast<unsigned long long>(m_AudioOutput.OverrunCount()));
+		AudioOutput::FillStatistics const& fill{ m_AudioOutput.FillStats() };
+		SDL_Log("Audio fill: %.0f%% (%.0f%% - %.0f%%), rate ratio: %.5f", fill.average * 100.f, fill.min * 100.f, fill.max * 100.f, m_AudioOutput.RateRatio());
+		m_AudioOutput.ResetFillStats();
+	}
+}
@@ -0,0 +1,107 @@
+#ifndef NES_EMULATOR_EMULATION_THREAD
+#define NES_EMULATOR_EMULATION_THREAD
+
+#include "TripleBuffer.h"
+
+#pragma warning (push)
+#pragma warning (disable: 4820)
+#pragma warning (disable: 4514)
+#pragma warning (disable: 4548)
+	#include <SDL3/SDL.h>
+#pragma warning (pop)
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace NesEm
+{
+	class Emulator;
+	class AudioOutput;
+
+	// Runs the emulator on its own thread, so window events, presenting and filters on the render thread never stall it
+	// Input comes in through an atomic mailbox holding the latest controller state, frames go out through a triple buffer
+	// Neither side ever waits for the other: the emulation keeps its own pace, the render thread always gets the newest frame
+	//
+	// The thread also feeds the audio output and paces itself, on GameTime's frame clock or on the audio device's clock
+	class EmulationThread final
+	{
+	public:
+		enum class Pacing : uint8_t
+		{
+			Timer, // GameTime's frame clock, dynamic rate control keeps the audio queue half full
+			Audio // Blocks until the audio queue has room for the next frame (see AudioOutput::WaitForSpace), timer without a device
+		};
+
+		struct Settings final
+		{
+			Pacing pacing{ Pacing::Timer };
+			// Logical CPU the thread is pinned to, -1 leaves it to the OS (no pinning on Apple platforms)
+			int32_t cpu{ -1 };
+			SDL_ThreadPriority priority{ SDL_THREAD_PRIORITY_NORMAL };
+			// Logs the emulation's statistics once a second
+			bool logStatistics{ false };
+		};
+
+		// A completed frame, copied out of the emulator
+		struct Frame final
+		{
+			// Palette indices, SCREEN_WIDTH x SCREEN_HEIGHT
+			std::vector<uint8_t> indices{ };
+			// Emphasis bits and colour subcarrier phase of every scanline, see Emulator::FrameEmphasis / FramePhases
+			std::vector<uint8_t> emphasis{ };
+			std::vector<uint8_t> phases{ };
+			// Emulator::FrameSequence of the picture, only changes when the picture does
+			uint64_t sequence{ UINT64_MAX };
+		};
+
+		// Param Emulator only used by the thread until it's destroyed
+		// Param AudioOutput the thread queues the audio on, the only producer until it's destroyed
+		// Param Settings pacing, affinity and priority
+		EmulationThread(Emulator& emulator, AudioOutput& audioOutput, Settings const& settings);
+		// Stops the thread after its current frame
+		~EmulationThread();
+
+		EmulationThread(EmulationThread const&) = delete;
+		EmulationThread(EmulationThread&&) = delete;
+		EmulationThread& operator=(EmulationThread const&) = delete;
+		EmulationThread& operator=(EmulationThread&&) = delete;
+
+		// Return bool does the audio device pace the emulation
+		[[nodiscard]] bool IsAudioPaced() const noexcept { return m_IsAudioPaced; }
+
+		// Param std::array held buttons of both controllers, see Controller::Button, used from the next frame on
+		void SubmitInput(std::array<uint8_t, 2> const& buttons) noexcept;
+
+		// Render thread side
+		// Return Frame const* the newest frame when one came in since the last call, nullptr otherwise
+		// Stays valid (and unchanged) until the next call that returns a frame
+		[[nodiscard]] Frame const* FetchFrame() noexcept { return m_Frames.Fetch() ? &m_Frames.Front() : nullptr; }
+		// Render thread side, blocks until a frame came in that wasn't fetched yet
+		void WaitForFrame() const noexcept { m_Frames.WaitForPublish(); }
+
+	private:
+		Emulator& m_Emulator;
+		AudioOutput& m_AudioOutput;
+		Settings const m_Settings;
+		bool const m_IsAudioPaced;
+
+		// Controller 1 in the low byte, controller 2 in the high byte
+		std::atomic<uint16_t> m_Input{ 0 };
+		TripleBuffer<Frame> m_Frames{ };
+
+		std::atomic<bool> m_IsRunning{ true };
+		std::thread m_Thread{ };
+
+		void Run() noexcept;
+		// Pins and prioritises the calling thread as the settings ask
+		void ApplySettings() const noexcept;
+		void PublishFrame() noexcept;
+		// Param uint64_t frames emulated since the last log, param double seconds since then
+		void LogStatistics(uint64_t frames, double seconds) noexcept;
+	};
+}
+
+#endif
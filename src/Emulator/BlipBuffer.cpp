@@ -0,0 +1,139 @@
+#include "BlipBuffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+namespace NesEm
+{
+	namespace
+	{
+		// Fraction of the Nyquist frequency the steps are band-limited to, leaves the sinc room to roll off
+		constexpr double CUTOFF{ 0.9 };
+	}
+
+	BlipBuffer::Kernel BlipBuffer::MakeKernel() noexcept
+	{
+		Kernel kernel{ };
+		double const halfWidth{ KERNEL_WIDTH / 2.0 };
+
+		for (uint32_t phase{ 0 }; phase < PHASE_COUNT; ++phase)
+		{
+			std::array<double, KERNEL_WIDTH> taps{ };
+			double sum{ 0.0 };
+			for (uint32_t tap{ 0 }; tap < KERNEL_WIDTH; ++tap)
+			{
+				// Distance in samples from the step, centred between tap 7 and 8 at phase 0.5
+				double const x{ tap - (halfWidth - 1.0) - static_cast<double>(phase) / PHASE_COUNT };
+				double const angle{ std::numbers::pi * CUTOFF * x };
+				double const sinc{ x == 0.0 ? 1.0 : std::sin(angle) / angle };
+				double const w{ std::numbers::pi * x / halfWidth };
+				double const window{ std::abs(x) >= halfWidth ? 0.0 : 0.42 + 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w) };
+
+				taps[tap] = sinc * window;
+				sum += taps[tap];
+			}
+
+			// Normalise so a step always ends exactly at its full height, rounding errors go to the largest tap
+			int32_t total{ 0 };
+			for (uint32_t tap{ 0 }; tap < KERNEL_WIDTH; ++tap)
+			{
+				kernel[phase][tap] = static_cast<int16_t>(std::lround(taps[tap] / sum * (1 << KERNEL_BITS)));
+				total += kernel[phase][tap];
+			}
+			auto const largest{ std::max_element(kernel[phase].begin(), kernel[phase].end()) };
+			*largest = static_cast<int16_t>(*largest + (1 << KERNEL_BITS) - total);
+		}
+		return kernel;
+	}
+
+	BlipBuffer::Kernel const& BlipBuffer::StepKernel() noexcept
+	{
+		static Kernel const KERNEL{ MakeKernel() };
+		return KERNEL;
+	}
+
+	BlipBuffer::BlipBuffer(double clockRate, double sampleRate, uint32_t capacity):
+		m_Capacity{ capacity }
+	{
+		// Room for the tail of the kernel of a delta at the very end of a full buffer
+		m_Deltas.resize(static_cast<size_t>(capacity) + KERNEL_WIDTH + 1);
+		SetRates(clockRate, sampleRate);
+
+		// Build the shared kernel now instead of on the first delta, which runs in the middle of emulation
+		(void)StepKernel();
+	}
+
+	void BlipBuffer::SetRates(double clockRate, double sampleRate) noexcept
+	{
+		assert(clockRate > 0.0 && sampleRate > 0.0 && sampleRate < clockRate);
+		m_Factor = static_cast<uint64_t>(std::llround(sampleRate / clockRate * static_cast<double>(1ull << TIME_BITS)));
+	}
+
+	void BlipBuffer::AddDelta(uint32_t time, int32_t delta) noexcept
+	{
+		// Rounded to the nearest phase, may carry into the next sample
+		uint64_t const position{ m_Offset + time * m_Factor + (1ull << (TIME_BITS - PHASE_BITS - 1)) };
+		size_t const index{ static_cast<size_t>(position >> TIME_BITS) };
+		uint32_t const phase{ static_cast<uint32_t>(position >> (TIME_BITS - PHASE_BITS)) & (PHASE_COUNT - 1) };
+		assert(index + KERNEL_WIDTH <= m_Deltas.size());
+
+		std::array<int16_t, KERNEL_WIDTH> const& kernel{ StepKernel()[phase] };
+		int32_t* const pDeltas{ m_Deltas.data() + index };
+		for (uint32_t tap{ 0 }; tap < KERNEL_WIDTH; ++tap)
+		{
+			pDeltas[tap] += kernel[tap] * delta;
+		}
+	}
+
+	void BlipBuffer::EndFrame(uint32_t clocks) noexcept
+	{
+		m_Offset += clocks * m_Factor;
+		assert(SamplesAvailable() <= m_Capacity);
+	}
+
+	uint32_t BlipBuffer::ClocksNeeded(uint32_t samples) const noexcept
+	{
+		uint64_t const needed{ static_cast<uint64_t>(samples) << TIME_BITS };
+		if (needed <= m_Offset)
+		{
+			return 0;
+		}
+		return static_cast<uint32_t>((needed - m_Offset + m_Factor - 1) / m_Factor);
+	}
+
+	uint32_t BlipBuffer::ReadSamples(std::span<int16_t> samples) noexcept
+	{
+		uint32_t const available{ SamplesAvailable() };
+		uint32_t const count{ static_cast<uint32_t>(std::min<size_t>(samples.size(), available)) };
+
+		int32_t integrator{ m_Integrator };
+		for (uint32_t i{ 0 }; i < count; ++i)
+		{
+			integrator += m_Deltas[i];
+
+			int32_t const sample{ std::clamp(integrator >> KERNEL_BITS, -32768, 32767) };
+			samples[i] = static_cast<int16_t>(sample);
+
+			// Leak a little of the output back out of the sum, pulls any DC offset towards 0
+			integrator -= sample << (KERNEL_BITS - BASS_SHIFT);
+		}
+		m_Integrator = integrator;
+
+		// Move what is left (unread samples and kernel tails reaching past the frame) to the front
+		size_t const remaining{ m_Deltas.size() - count };
+		std::copy_n(m_Deltas.begin() + count, remaining, m_Deltas.begin());
+		std::fill(m_Deltas.begin() + remaining, m_Deltas.end(), 0);
+		m_Offset -= static_cast<uint64_t>(count) << TIME_BITS;
+
+		return count;
+	}
+
+	void BlipBuffer::Clear() noexcept
+	{
+		std::fill(m_Deltas.begin(), m_Deltas.end(), 0);
+		m_Offset = 0;
+		m_Integrator = 0;
+	}
+}
@@ -0,0 +1,93 @@
+#ifndef NES_EMULATOR_BLIP_BUFFER
+#define NES_EMULATOR_BLIP_BUFFER
+
+#include "emulator_pch.h"
+
+#include <array>
+#include <span>
+#include <vector>
+
+/* Sources used during development of the blip buffer:
+ * http://www.slack.net/~ant/bl-synth/
+ * https://github.com/mgba-emu/blip_buf
+ */
+
+namespace NesEm
+{
+	// Band-limited step synthesis: instead of producing a sample every clock, the source only reports when its output changes
+	// Every change (delta) adds a windowed sinc step to the samples around its exact time, so square waves come out without aliasing
+	// and the cost depends on how often the output changes, not on the clock rate
+	//
+	// Usage per frame: AddDelta for every change (time in clocks since the start of the frame), EndFrame, then ReadSamples
+	class BlipBuffer final
+	{
+	public:
+		// Param double rate of the clock the delta times are in, Hz
+		// Param double rate of the samples that come out, Hz
+		// Param uint32_t most samples the buffer holds before they have to be read
+		BlipBuffer(double clockRate, double sampleRate, uint32_t capacity);
+		~BlipBuffer() = default;
+
+		BlipBuffer(BlipBuffer const&) = delete;
+		BlipBuffer(BlipBuffer&&) = delete;
+		BlipBuffer& operator=(BlipBuffer const&) = delete;
+		BlipBuffer& operator=(BlipBuffer&&) = delete;
+
+		// Param double, double clock and sample rate, takes effect for the deltas of the next frame
+		void SetRates(double clockRate, double sampleRate) noexcept;
+
+		// Param uint32_t clocks since the start of the frame
+		// Param int32_t change of the output in sample units, stay within the int16_t range
+		void AddDelta(uint32_t time, int32_t delta) noexcept;
+
+		// Param uint32_t length of the frame in clocks, every delta of the frame must lie before it
+		// Makes the samples up to the end of the frame available for reading
+		void EndFrame(uint32_t clocks) noexcept;
+
+		// Return uint32_t samples that can be read
+		[[nodiscard]] uint32_t SamplesAvailable() const noexcept { return static_cast<uint32_t>(m_Offset >> TIME_BITS); }
+
+		// Param uint32_t samples wanted
+		// Return uint32_t clocks a frame has to last for that many samples to become available
+		[[nodiscard]] uint32_t ClocksNeeded(uint32_t samples) const noexcept;
+
+		// Param std::span where to write the samples, reads at most its size
+		// Return uint32_t samples written
+		uint32_t ReadSamples(std::span<int16_t> samples) noexcept;
+
+		// Drops every sample and delta and resets the filters
+		void Clear() noexcept;
+
+	private:
+		// Fraction bits of the sample position, a delta's time is converted with a 64 bit multiply
+		static constexpr uint32_t TIME_BITS{ 32 };
+		// Sub sample positions the step kernel is precomputed for
+		static constexpr uint32_t PHASE_BITS{ 6 };
+		static constexpr uint32_t PHASE_COUNT{ 1 << PHASE_BITS };
+		// Samples a single step is spread over, half before and half after its time
+		static constexpr uint32_t KERNEL_WIDTH{ 16 };
+		// Fixed point precision of the kernel, every phase sums to exactly 1 << KERNEL_BITS
+		static constexpr uint32_t KERNEL_BITS{ 15 };
+		// High pass applied while integrating, removes DC with a corner of about sample rate / (2 pi 2^BASS_SHIFT) (15 Hz at 48 kHz)
+		static constexpr uint32_t BASS_SHIFT{ 9 };
+
+		uint32_t const m_Capacity;
+
+		// Sample positions per clock, fixed point with TIME_BITS fraction bits
+		uint64_t m_Factor{ 0 };
+		// Position of the start of the current frame, fixed point, the integer part are the samples that can be read
+		uint64_t m_Offset{ 0 };
+
+		// Differences between samples, the samples are their running sum
+		std::vector<int32_t> m_Deltas{ };
+		int32_t m_Integrator{ 0 };
+
+		// Impulse (the difference of a band-limited step) for every sub sample phase
+		using Kernel = std::array<std::array<int16_t, KERNEL_WIDTH>, PHASE_COUNT>;
+		// Blackman windowed sinc, built on first use and shared by every buffer
+		[[nodiscard]] static Kernel MakeKernel() noexcept;
+		[[nodiscard]] static Kernel const& StepKernel() noexcept;
+	};
+}
+
+#endif
@@ -1,66 +1,87 @@
 #include "Emulator.h"
 #include "EmulatorSettings.h"
+#include "Hash.h"
+
+#include <algorithm>
 
 namespace NesEm
 {
-	Emulator::Emulator():
+	Emulator::Emulator(std::filesystem::path const& romPath):
 	// We should load the cartridge first (or make a function in the CPU, ... where initialize / load the cartridge).
-	m_Cartridge{ "Resources/test.nes" },
-	m_PPU{ },
-	m_CPU{ m_PPU, m_Cartridge }
+	m_Cartridge{ romPath },
+	m_PPU{ m_Cartridge },
+	m_APU{ m_Cartridge },
+	m_CPU{ m_PPU, m_APU, m_Cartridge }
 	{
 
 	}
-	void Emulator::Run() noexcept
+
+	void Emulator::RunFrame(bool isBehind) noexcept
 	{
-		//TODO how many clocks per frame
-		//constexpr int SPEED{ 50 };
-		//while (m_MasterClock < SPEED)
+		bool output{ true };
+		switch (m_FrameSkip)
 		{
-			// Run the PPU
-			m_PPU.Clock();
+		case FrameSkip::Ratio:
+			output = m_FramesSkippedInRow >= m_FrameSkipFrames;
+			break;
+		case FrameSkip::Adaptive:
+			// Always output a frame once in a while, even when the frontend never catches up
+			output = !isBehind || m_FramesSkippedInRow >= m_FrameSkipFrames;
+			break;
+		default: break;
+		}
 
-			switch (Config::MODE)
-			{
-			case Config::NES_MODE::PAL:
-			{
-				// 5 master clocks pet PPU dot
-				if (m_MasterClock % 4 == 0)
-				{
-					// Run the CPU
-					m_CPU.Clock();
-				}
-			}break;
+		m_FramesSkippedInRow = output ? 0 : m_FramesSkippedInRow + 1;
+		m_PPU.SetPixelOutput(output);
 
-			case Config::NES_MODE::NTSC:
-			{
-				// 4 master clocks pet PPU dot
-				if (m_MasterClock % 3 == 0)
-				{
-					// Run the CPU
-					m_CPU.Clock();
-				}
+		m_PPU.ClearFrameComplete();
 
-			}break;
+		// The CPU runs ahead to the next point the PPU or APU needs it (vblank NMI, frame end, APU IRQ) without syncing
+		// Register accesses catch the units up themselves and status flags are scheduled, so nothing in between is missed
+		while (!m_PPU.IsFrameComplete())
+		{
+			// Lockstep runs a single instruction at a time
+			m_CPU.UpdateAPUSync();
+			m_CPU.RunUntil(m_IsAPULockstep ? m_CPU.TotalCycles() + 1 : m_PPU.NextSyncCPUCycle());
+			m_PPU.CatchUp(m_CPU.TotalCycles());
 
-			default: break;
+			// The APU only runs when observed, here its IRQ is due and the CPU checks it before its next instruction
+			// The deadline is the CPU's, APU writes during the segment may have brought it forward
+			if (m_IsAPULockstep || m_CPU.TotalCycles() >= m_CPU.APUSyncCycle())
+			{
+				m_APU.CatchUp(m_CPU.TotalCycles());
 			}
 
-			++m_MasterClock;
+			if (m_PPU.PollNMI())
+			{
+				m_CPU.RequestNMI();
+			}
 		}
 
-		//m_MasterClock = 0;
+		// The frontend needs this frame's samples
+		m_APU.CatchUp(m_CPU.TotalCycles());
+		m_APU.EndFrame();
+		m_AudioSamples.resize(m_APU.SamplesAvailable());
+		m_APU.ReadSamples(m_AudioSamples);
 	}
 
 	void Emulator::Reset() noexcept
 	{
 		m_CPU.Reset();
+	}
 
-		m_MasterClock = 0;
+	void Emulator::Render(uint32_t* pPixels, int pitch) const noexcept
+	{
+		m_PPU.Render(pPixels, pitch);
+	}
+
+	uint64_t Emulator::FrameHash() const noexcept
+	{
+		return Hash64(m_PPU.FrameIndices(), Hash64(m_PPU.FrameEmphasis()));
 	}
 
-	void Emulator::Render() const noexcept
+	uint64_t Emulator::RAMHash() const noexcept
 	{
-		m_PPU.Render();
+		return Hash64(m_CPU.RAM());
 	}
 }
\ No newline at end of file
@@ -5,8 +5,11 @@
 
 #include "NESCPU.h"
 #include "NESPPU.h"
+#include "NESAPU.h"
 #include "NESCartridge.h"
 
+#include <filesystem>
+#include <vector>
 
 /* Various sources used during development of the Emulator class of our emulator:
  * https://www.nesdev.org/wiki/Cycle_reference_chart
@@ -18,14 +21,94 @@ namespace NesEm
 	class Emulator final
 	{
 	public:
-		Emulator();
+		// Param std::filesystem::path iNES file to run, relative paths start at the executable's directory
+		explicit Emulator(std::filesystem::path const& romPath = "Resources/test.nes");
 		~Emulator() = default;
 
-		void Run() noexcept;
+		// How frames the frontend will not display are chosen, those run all PPU logic but produce no pixels
+		enum class FrameSkip : uint8_t
+		{
+			Off, // Every frame is output
+			Ratio, // Output one frame, then skip a fixed amount of frames
+			Adaptive // Skip while the frontend reports it is running behind, up to an amount of frames in a row
+		};
+
+		// Param FrameSkip mode
+		// Param uint8_t frames skipped after each output frame (Ratio) or max frames skipped in a row (Adaptive)
+		void SetFrameSkip(FrameSkip mode, uint8_t frames = 0) noexcept
+		{
+			m_FrameSkip = mode;
+			m_FrameSkipFrames = frames;
+			m_FramesSkippedInRow = 0;
+		}
+
+		// Keep running the system until the PPU completed a full frame
+		// Param bool is the frontend behind schedule, only used by adaptive frame skip
+		void RunFrame(bool isBehind = false) noexcept;
 
 		void Reset() noexcept;
 
-		void Render() const noexcept;
+		// Param uint8_t controller port (0 or 1)
+		// Param uint8_t held buttons, see Controller::Button
+		void SetControllerButtons(uint8_t port, uint8_t buttons) noexcept { m_CPU.SetControllerButtons(port, buttons); }
+
+		// Return bool did the last RunFrame call complete a new frame
+		[[nodiscard]] bool IsFrameComplete() const noexcept { return m_PPU.IsFrameComplete(); }
+		// Return bool does the completed frame differ from the previous one, when false there's nothing to upload or present
+		[[nodiscard]] bool HasNewPicture() const noexcept { return m_PPU.HasNewPicture(); }
+		// Return uint64_t sequence number of the picture the last completed frame shows, only changes when the picture does
+		// Frontends compare it to what they uploaded / presented last to skip redundant work
+		[[nodiscard]] uint64_t FrameSequence() const noexcept { return m_PPU.PictureSequence(); }
+		// Return uint64_t how many frames reused the previous output
+		[[nodiscard]] uint64_t SkippedFrameCount() const noexcept { return m_PPU.SkippedFrameCount(); }
+		// Return uint64_t how many frames were not output because of frame skip
+		[[nodiscard]] uint64_t DroppedFrameCount() const noexcept { return m_PPU.DroppedFrameCount(); }
+
+		// Param uint32_t* pixel memory the completed frame is converted into (ARGB8888)
+		// Param int pitch, length of one row of the destination in bytes
+		void Render(uint32_t* pPixels, int pitch) const noexcept;
+		// Param std::span palette indices of a frame copied out of FrameIndices, e.g. on another thread
+		static void Render(std::span<uint8_t const> indices, uint32_t* pPixels, int pitch) noexcept { PPU::Render(indices, pPixels, pitch); }
+
+		// The completed frame without copies, for headless frontends, tests, embedding hosts and filters that do their own colour conversion (e.g. NTSC)
+		// All of these are only valid until the next RunFrame call
+		// Return std::span palette indices, SCREEN_WIDTH x SCREEN_HEIGHT
+		[[nodiscard]] std::span<uint8_t const> FrameIndices() const noexcept { return m_PPU.FrameIndices(); }
+		// Return std::span ARGB8888 colours, SCREEN_WIDTH x SCREEN_HEIGHT, converted once per new picture
+		[[nodiscard]] std::span<uint32_t const> FramePixels() const noexcept { return m_PPU.FramePixels(); }
+		// Return std::span emphasis bits of every scanline (red, green, blue -> bit 0, 1, 2)
+		[[nodiscard]] std::span<uint8_t const> FrameEmphasis() const noexcept { return m_PPU.FrameEmphasis(); }
+		// Return std::span colour subcarrier phase of the first pixel of every scanline, in 1/12ths of a cycle
+		[[nodiscard]] std::span<uint8_t const> FramePhases() const noexcept { return m_PPU.FramePhases(); }
+
+		// Return std::span audio of the last RunFrame call, Config::AUDIO_SAMPLE_RATE mono, about a frame's worth
+		// Only valid until the next RunFrame call
+		[[nodiscard]] std::span<int16_t const> AudioSamples() const noexcept { return m_AudioSamples; }
+		// Param double factor the audio sample rate is scaled by, e.g. AudioOutput::RateRatio, takes effect from the next frame
+		// Lets the frontend pace frames to the display while keeping its audio queue from running dry or overflowing
+		void SetAudioRateRatio(double ratio) noexcept { m_APU.SetSampleRateRatio(ratio); }
+		// Param bool also keep the APU's mixed output of every cycle, before it is resampled, from the next frame on
+		void SetRawAudioCapture(bool isEnabled) noexcept { m_APU.SetRawOutputCapture(isEnabled); }
+		// Return std::span APU output of every cycle of the last RunFrame call, Config::CPU_CLOCK_RATE mono, empty without raw audio capture
+		// Only valid until the next RunFrame call
+		[[nodiscard]] std::span<int16_t const> RawAudioSamples() const noexcept { return m_APU.RawOutput(); }
+		// Param bool catch the APU up after every instruction instead of only when it is observed or its IRQ is due,
+		// and have it clock every channel on every cycle (APU::SetPerCycleReference), call before the first frame (slow)
+		// The reference the lazy, event driven APU is compared against, see --verify-apu
+		void SetAPULockstep(bool isLockstep) noexcept
+		{
+			m_IsAPULockstep = isLockstep;
+			m_APU.SetPerCycleReference(isLockstep);
+		}
+
+		// Return std::span ARGB8888 colour of every palette index, the conversion Render and FramePixels use
+		[[nodiscard]] static constexpr std::span<uint32_t const, 64> SystemPalette() noexcept { return PPU::SystemPalette(); }
+
+		// Hashes to compare runs with, e.g. against a log of a known good build
+		// Return uint64_t hash of the completed frame's palette indices and emphasis bits
+		[[nodiscard]] uint64_t FrameHash() const noexcept;
+		// Return uint64_t hash of the 2KB internal RAM
+		[[nodiscard]] uint64_t RAMHash() const noexcept;
 
 		Emulator(Emulator const&) = delete;
 		Emulator(Emulator&&) = delete;
@@ -35,9 +118,16 @@ namespace NesEm
 	private:
 		Cartridge m_Cartridge;
 		PPU m_PPU;
+		APU m_APU;
 		CPU m_CPU;
 
-		uint64_t m_MasterClock{ 0 };
+		std::vector<int16_t> m_AudioSamples{ };
+
+		FrameSkip m_FrameSkip{ FrameSkip::Off };
+		uint8_t m_FrameSkipFrames{ 0 };
+		uint8_t m_FramesSkippedInRow{ 0 };
+
+		bool m_IsAPULockstep{ false };
 	};
 }
 
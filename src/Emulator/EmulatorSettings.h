@@ -14,6 +14,36 @@ namespace NesEm
 		};
 
 		constexpr NES_MODE MODE{ NES_MODE::PAL };
+
+		// PPU dots per CPU cycle, the CPU is clocked every 4th (PAL) or 3rd (NTSC) dot
+		constexpr uint32_t DOTS_PER_CPU_CYCLE{ MODE == NES_MODE::PAL ? 4u : 3u };
+
+		// Frames the console outputs per second as an exact fraction, PAL ~50.007, NTSC ~60.099
+		// PPU clock / dots per frame, NTSC frames alternate between 89342 and 89341 dots
+		constexpr uint32_t FRAME_RATE_NUMERATOR{ MODE == NES_MODE::PAL ? 3325214u : 39375000u };
+		constexpr uint32_t FRAME_RATE_DENOMINATOR{ MODE == NES_MODE::PAL ? 66495u : 655171u };
+
+		// The APU counts real CPU cycles, 3.2 dots each on PAL where the CPU core approximates it with 4 and runs fewer cycles per frame
+		// APU cycles = CPU cycles * APU_CYCLES_NUMERATOR / APU_CYCLES_DENOMINATOR, keeps the pitch right and both in step over a frame
+		constexpr uint32_t APU_CYCLES_NUMERATOR{ MODE == NES_MODE::PAL ? DOTS_PER_CPU_CYCLE * 5u : DOTS_PER_CPU_CYCLE };
+		constexpr uint32_t APU_CYCLES_DENOMINATOR{ MODE == NES_MODE::PAL ? 16u : 3u };
+
+		// Real CPU clock in Hz, the rate APU cycles run at: PAL 26.6017125 MHz / 16, NTSC 236.25 / 11 MHz / 12
+		constexpr double CPU_CLOCK_RATE{ MODE == NES_MODE::PAL ? 26601712.5 / 16.0 : 236250000.0 / 11.0 / 12.0 };
+
+		// Rate of the samples the APU outputs, mono
+		constexpr uint32_t AUDIO_SAMPLE_RATE{ 48000 };
+		// Rate the APU synthesizes at as a multiple of AUDIO_SAMPLE_RATE, above 1 a FIR decimator brings it down
+		// Trades a little work per sample for a sharp cut at 20 kHz instead of the blip kernel's slower roll off
+		constexpr uint32_t AUDIO_OVERSAMPLING{ 1 };
+
+		// Visible picture the PPU outputs each frame, in pixels
+		constexpr uint32_t SCREEN_WIDTH{ 256 };
+		constexpr uint32_t SCREEN_HEIGHT{ 240 };
+
+		// Compose scanlines on a render worker thread that replays the PPU's writes
+		// The emulation thread only keeps what the CPU can observe (vblank, sprite 0 hit, sprite overflow)
+		constexpr bool DEFERRED_RENDERING{ true };
 	}
 }
 
@@ -0,0 +1,271 @@
+#include "FIRDecimator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <numbers>
+
+#pragma warning (push)
+#pragma warning (disable: 4820)
+#pragma warning (disable: 4514)
+#pragma warning (disable: 4548)
+	#include <SDL3/SDL.h>
+#pragma warning (pop)
+
+#if NES_EM_SSE2
+	#include <immintrin.h>
+#endif
+
+namespace NesEm
+{
+	namespace
+	{
+		// Modified Bessel function of the first kind, order 0, the series converges quickly for the arguments a Kaiser window uses
+		[[nodiscard]] double BesselI0(double x) noexcept
+		{
+			double sum{ 1.0 };
+			double term{ 1.0 };
+			for (int k{ 1 }; k < 50; ++k)
+			{
+				double const factor{ x / (2.0 * k) };
+				term *= factor * factor;
+				sum += term;
+				if (term < sum * 1e-17)
+				{
+					break;
+				}
+			}
+			return sum;
+		}
+
+		// Lanes every dot product is summed in, the scalar and SSE2 versions keep the same order as AVX2 so they round the same
+		constexpr uint32_t LANES{ 16 };
+	}
+
+	FIRDecimator::Vectorization FIRDecimator::BestVectorization() noexcept
+	{
+		if (NES_EM_SSE2 && SDL_HasAVX2())
+		{
+			return Vectorization::AVX2;
+		}
+		return NES_EM_SSE2 ? Vectorization::SSE2 : Vectorization::Scalar;
+	}
+
+	FIRDecimator::FIRDecimator(double inputRate, double outputRate, Vectorization vectorization) :
+		m_InputRate{ inputRate },
+		m_Vectorization{ std::min(vectorization, BestVectorization()) }
+	{
+		assert(outputRate > 0.0 && outputRate < inputRate);
+
+		double const ratio{ inputRate / outputRate };
+		m_Step = static_cast<uint64_t>(std::llround(ratio * static_cast<double>(1ull << POSITION_BITS)));
+		// Every output then lands on the same phase
+		m_PhaseCount = ((m_Step & ((1ull << POSITION_BITS) - 1)) == 0) ? 1 : 1u << PHASE_BITS;
+
+		GenerateCoefficients(outputRate);
+		Clear();
+	}
+
+	void FIRDecimator::GenerateCoefficients(double outputRate)
+	{
+		// Kaiser's estimates for the length and shape that reach the attenuation over the transition band
+		double const transition{ (STOPBAND - PASSBAND) * outputRate / m_InputRate };
+		double const length{ (ATTENUATION_DB - 7.95) / (2.285 * 2.0 * std::numbers::pi * transition) + 1.0 };
+		double const beta{ 0.1102 * (ATTENUATION_DB - 8.7) };
+
+		m_TapCount = (static_cast<uint32_t>(std::ceil(length)) + TAP_ALIGNMENT - 1) / TAP_ALIGNMENT * TAP_ALIGNMENT;
+
+		// Cutoff in the middle of the transition band, in cycles per input sample
+		double const cutoff{ (PASSBAND + STOPBAND) / 2.0 * outputRate / m_InputRate };
+		double const halfWidth{ m_TapCount / 2.0 };
+		double const windowScale{ 1.0 / BesselI0(beta) };
+
+		m_Coefficients.assign(static_cast<size_t>(m_PhaseCount + 1) * m_TapCount, 0.f);
+		std::vector<double> taps(m_TapCount);
+		for (uint32_t phase{ 0 }; phase <= m_PhaseCount; ++phase)
+		{
+			double sum{ 0.0 };
+			for (uint32_t tap{ 0 }; tap < m_TapCount; ++tap)
+			{
+				// Distance in input samples from the output to this tap's input, the output lies between tap halfWidth - 1 and halfWidth
+				double const x{ static_cast<double>(phase) / m_PhaseCount + halfWidth - 1.0 - tap };
+				double const angle{ 2.0 * std::numbers::pi * cutoff * x };
+				double const sinc{ x == 0.0 ? 1.0 : std::sin(angle) / angle };
+				double const edge{ x / halfWidth };
+				double const window{ std::abs(edge) >= 1.0 ? windowScale : BesselI0(beta * std::sqrt(1.0 - edge * edge)) * windowScale };
+
+				taps[tap] = sinc * window;
+				sum += taps[tap];
+			}
+
+			// Normalise every phase so a constant input comes out at exactly its own level
+			float* const pRow{ m_Coefficients.data() + static_cast<size_t>(phase) * m_TapCount };
+			for (uint32_t tap{ 0 }; tap < m_TapCount; ++tap)
+			{
+				pRow[tap] = static_cast<float>(taps[tap] / sum);
+			}
+		}
+	}
+
+	uint32_t FIRDecimator::Process(std::span<int16_t const> input, std::span<int16_t> output)
+	{
+		size_t const start{ m_History.size() };
+		m_History.resize(start + input.size());
+		std::transform(input.begin(), input.end(), m_History.begin() + start, [](int16_t sample) { return static_cast<float>(sample); });
+
+		uint32_t written{ 0 };
+		while (written < output.size())
+		{
+			size_t const first{ static_cast<size_t>(m_Position >> POSITION_BITS) };
+			if (first + m_TapCount > m_History.size())
+			{
+				break;
+			}
+
+			float const* const pInput{ m_History.data() + first };
+			float value{ };
+			if (m_PhaseCount == 1)
+			{
+				value = Dot(pInput, m_Coefficients.data());
+			}
+			else
+			{
+				// Phase and how far towards the next one, from the fraction of the position
+				uint64_t const phasePosition{ (m_Position & ((1ull << POSITION_BITS) - 1)) * m_PhaseCount };
+				uint32_t const phase{ static_cast<uint32_t>(phasePosition >> POSITION_BITS) };
+				float const blend{ static_cast<float>(static_cast<uint32_t>(phasePosition)) * (1.f / 4294967296.f) };
+
+				float const* const pRow{ m_Coefficients.data() + static_cast<size_t>(phase) * m_TapCount };
+				float const current{ Dot(pInput, pRow) };
+				float const next{ Dot(pInput, pRow + m_TapCount) };
+				value = current + (next - current) * blend;
+			}
+
+			output[written++] = static_cast<int16_t>(std::clamp(std::lrint(value), -32768l, 32767l));
+			m_Position += m_Step;
+		}
+
+		// Input before the next window isn't needed anymore
+		size_t const consumed{ std::min(static_cast<size_t>(m_Position >> POSITION_BITS), m_History.size()) };
+		m_History.erase(m_History.begin(), m_History.begin() + consumed);
+		m_Position -= static_cast<uint64_t>(consumed) << POSITION_BITS;
+
+		return written;
+	}
+
+	uint32_t FIRDecimator::MaxOutput(uint32_t inputSamples) const noexcept
+	{
+		uint64_t const available{ m_History.size() + inputSamples };
+		if (available < m_TapCount)
+		{
+			return 0;
+		}
+
+		uint64_t const lastStart{ (available - m_TapCount) << POSITION_BITS };
+		return (lastStart < m_Position) ? 0 : static_cast<uint32_t>((lastStart - m_Position) / m_Step + 1);
+	}
+
+	double FIRDecimator::Response(double frequency) const noexcept
+	{
+		double const omega{ 2.0 * std::numbers::pi * frequency / m_InputRate };
+
+		std::complex<double> sum{ };
+		for (uint32_t tap{ 0 }; tap < m_TapCount; ++tap)
+		{
+			sum += static_cast<double>(m_Coefficients[tap]) * std::polar(1.0, -omega * tap);
+		}
+		return std::abs(sum);
+	}
+
+	void FIRDecimator::Clear() noexcept
+	{
+		// Silence before the first input, so the first output is centred on the first input sample
+		m_History.assign(m_TapCount / 2 - 1, 0.f);
+		m_Position = 0;
+	}
+
+	float FIRDecimator::Dot(float const* pInput, float const* pCoefficients) const noexcept
+	{
+		switch (m_Vectorization)
+		{
+		case Vectorization::AVX2:
+			return DotAVX2(pInput, pCoefficients);
+		case Vectorization::SSE2:
+			return DotSSE2(pInput, pCoefficients);
+		default:
+			return DotScalar(pInput, pCoefficients);
+		}
+	}
+
+	float FIRDecimator::DotScalar(float const* pInput, float const* pCoefficients) const noexcept
+	{
+		std::array<float, LANES> sum{ };
+		for (uint32_t tap{ 0 }; tap < m_TapCount; tap += LANES)
+		{
+			for (uint32_t lane{ 0 }; lane < LANES; ++lane)
+			{
+				float const product{ pInput[tap + lane] * pCoefficients[tap + lane] };
+				sum[lane] += product;
+			}
+		}
+
+		// Halves down to 4 lanes, then pairs, then the last two, like the horizontal sum of the vector versions
+		std::array<float, 8> eighth{ };
+		for (uint32_t lane{ 0 }; lane < 8; ++lane)
+		{
+			eighth[lane] = sum[lane] + sum[lane + 8];
+		}
+		std::array<float, 4> quarter{ };
+		for (uint32_t lane{ 0 }; lane < 4; ++lane)
+		{
+			quarter[lane] = eighth[lane] + eighth[lane + 4];
+		}
+		return (quarter[0] + quarter[2]) + (quarter[1] + quarter[3]);
+	}
+
+	float FIRDecimator::DotSSE2(float const* pInput, float const* pCoefficients) const noexcept
+	{
+#if NES_EM_SSE2
+		// Lanes 0 - 3, 4 - 7, 8 - 11 and 12 - 15
+		__m128 sum0{ _mm_setzero_ps() };
+		__m128 sum1{ _mm_setzero_ps() };
+		__m128 sum2{ _mm_setzero_ps() };
+		__m128 sum3{ _mm_setzero_ps() };
+		for (uint32_t tap{ 0 }; tap < m_TapCount; tap += LANES)
+		{
+			sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(pInput + tap), _mm_loadu_ps(pCoefficients + tap)));
+			sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(pInput + tap + 4), _mm_loadu_ps(pCoefficients + tap + 4)));
+			sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(pInput + tap + 8), _mm_loadu_ps(pCoefficients + tap + 8)));
+			sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(pInput + tap + 12), _mm_loadu_ps(pCoefficients + tap + 12)));
+		}
+
+		__m128 const half{ _mm_add_ps(_mm_add_ps(sum0, sum2), _mm_add_ps(sum1, sum3)) };
+		__m128 const pairs{ _mm_add_ps(half, _mm_movehl_ps(half, half)) };
+		return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+#else
+		return DotScalar(pInput, pCoefficients);
+#endif
+	}
+
+	NES_EM_TARGET_AVX2 float FIRDecimator::DotAVX2(float const* pInput, float const* pCoefficients) const noexcept
+	{
+#if NES_EM_SSE2
+		// No FMA, it would round differently from the other versions
+		__m256 low{ _mm256_setzero_ps() };
+		__m256 high{ _mm256_setzero_ps() };
+		for (uint32_t tap{ 0 }; tap < m_TapCount; tap += LANES)
+		{
+			low = _mm256_add_ps(low, _mm256_mul_ps(_mm256_loadu_ps(pInput + tap), _mm256_loadu_ps(pCoefficients + tap)));
+			high = _mm256_add_ps(high, _mm256_mul_ps(_mm256_loadu_ps(pInput + tap + 8), _mm256_loadu_ps(pCoefficients + tap + 8)));
+		}
+
+		__m256 const sum{ _mm256_add_ps(low, high) };
+		__m128 const half{ _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)) };
+		__m128 const pairs{ _mm_add_ps(half, _mm_movehl_ps(half, half)) };
+		return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+#else
+		return DotScalar(pInput, pCoefficients);
+#endif
+	}
+}
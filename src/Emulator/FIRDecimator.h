@@ -0,0 +1,107 @@
+#ifndef NES_EMULATOR_FIR_DECIMATOR
+#define NES_EMULATOR_FIR_DECIMATOR
+
+#include "emulator_pch.h"
+
+#include <span>
+#include <vector>
+
+/* Sources used during development of the decimator:
+ * https://ccrma.stanford.edu/~jos/resample/
+ * https://en.wikipedia.org/wiki/Kaiser_window#Kaiser%E2%80%93Bessel_filter_design
+ */
+
+namespace NesEm
+{
+	// Brings samples down to a lower rate through a low pass FIR filter, only computing the outputs that are kept
+	// The filter is precomputed for a set of sub sample phases (polyphase), an output between two phases blends their results
+	// so any ratio works, an integer ratio only needs the one phase
+	//
+	// Works on its own, e.g. on the APU output of every cycle, or behind the blip buffer running at a multiple of the output rate
+	// The blip buffer's short kernel rolls off slowly below the output Nyquist frequency, the decimator cuts off sharply instead
+	class FIRDecimator final
+	{
+	public:
+		// Instruction set the filter runs on, every one produces the exact same output
+		enum class Vectorization : uint8_t
+		{
+			Scalar = 0,
+			SSE2 = 1,
+			AVX2 = 2
+		};
+
+		// Return Vectorization fastest this CPU supports
+		[[nodiscard]] static Vectorization BestVectorization() noexcept;
+
+		// Param double rate of the input samples, Hz
+		// Param double rate of the output samples, Hz, lower than the input rate
+		// Param Vectorization instruction set to use, limited to what the CPU supports
+		FIRDecimator(double inputRate, double outputRate, Vectorization vectorization = BestVectorization());
+		~FIRDecimator() = default;
+
+		FIRDecimator(FIRDecimator const&) = delete;
+		FIRDecimator(FIRDecimator&&) = delete;
+		FIRDecimator& operator=(FIRDecimator const&) = delete;
+		FIRDecimator& operator=(FIRDecimator&&) = delete;
+
+		// Param std::span input samples, all of them are taken
+		// Param std::span where to write the output, outputs that don't fit wait for the next call
+		// Return uint32_t samples written
+		uint32_t Process(std::span<int16_t const> input, std::span<int16_t> output);
+
+		// Return uint32_t output samples the next Process call makes at most for that much more input
+		[[nodiscard]] uint32_t MaxOutput(uint32_t inputSamples) const noexcept;
+
+		// Return double gain of the filter at a frequency in Hz, 1 passes it unchanged
+		[[nodiscard]] double Response(double frequency) const noexcept;
+
+		// Return uint32_t input samples every output is computed from
+		[[nodiscard]] uint32_t TapCount() const noexcept { return m_TapCount; }
+		// Return uint32_t sub sample phases the coefficients are stored for
+		[[nodiscard]] uint32_t PhaseCount() const noexcept { return m_PhaseCount; }
+		[[nodiscard]] Vectorization GetVectorization() const noexcept { return m_Vectorization; }
+
+		// Drops the buffered input
+		void Clear() noexcept;
+
+	private:
+		// Edges of the transition band relative to the output rate, 20.2 - 27.8 kHz at 48 kHz
+		// Above the stopband edge is cut, what lies in the transition band only folds back above the passband
+		static constexpr double PASSBAND{ 0.42 };
+		static constexpr double STOPBAND{ 0.58 };
+		// Stopband attenuation the Kaiser window is designed for, about what 16 bit output resolves
+		static constexpr double ATTENUATION_DB{ 90.0 };
+		// Phases for ratios that aren't an integer, blending neighbouring phases keeps the error well below the attenuation
+		static constexpr uint32_t PHASE_BITS{ 6 };
+		// Fraction bits of the input position
+		static constexpr uint32_t POSITION_BITS{ 32 };
+		// Taps are padded to two AVX registers, the sums run in that many lanes so no add waits on the one before it
+		static constexpr uint32_t TAP_ALIGNMENT{ 16 };
+
+		double const m_InputRate;
+		Vectorization const m_Vectorization;
+		uint32_t m_TapCount{ 0 };
+		uint32_t m_PhaseCount{ 0 };
+
+		// PhaseCount + 1 rows of TapCount coefficients, the last one is the first shifted by a whole sample to blend towards
+		std::vector<float> m_Coefficients{ };
+
+		// Input samples per output, fixed point with POSITION_BITS fraction bits
+		uint64_t m_Step{ 0 };
+		// Where the window of the next output starts in the history, fixed point
+		uint64_t m_Position{ 0 };
+		// Input that later outputs still need
+		std::vector<float> m_History{ };
+
+		void GenerateCoefficients(double outputRate);
+
+		// Param float const* TapCount input samples
+		// Param float const* TapCount coefficients
+		[[nodiscard]] float Dot(float const* pInput, float const* pCoefficients) const noexcept;
+		[[nodiscard]] float DotScalar(float const* pInput, float const* pCoefficients) const noexcept;
+		[[nodiscard]] float DotSSE2(float const* pInput, float const* pCoefficients) const noexcept;
+		[[nodiscard]] float DotAVX2(float const* pInput, float const* pCoefficients) const noexcept;
+	};
+}
+
+#endif
@@ -0,0 +1,194 @@
+#include "Hash.h"
+
+#include <array>
+#include <cstring>
+
+#if NES_EM_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace NesEm
+{
+	namespace
+	{
+		constexpr uint64_t PRIME32_1{ 0x9E3779B1u };
+		constexpr uint64_t PRIME32_2{ 0x85EBCA77u };
+		constexpr uint64_t PRIME32_3{ 0xC2B2AE3Du };
+		constexpr uint64_t PRIME64_1{ 0x9E3779B185EBCA87ull };
+		constexpr uint64_t PRIME64_2{ 0xC2B2AE3D27D4EB4Full };
+		constexpr uint64_t PRIME64_3{ 0x165667B19E3779F9ull };
+		constexpr uint64_t PRIME64_4{ 0x85EBCA77C2B2AE63ull };
+		constexpr uint64_t PRIME64_5{ 0x27D4EB2F165667C5ull };
+
+		constexpr size_t LANES{ 8 };
+		constexpr size_t STRIPE_SIZE{ LANES * sizeof(uint64_t) };
+		// Stripes accumulated before the accumulators are scrambled, every stripe of a block uses the key shifted by one more lane
+		constexpr size_t STRIPES_PER_BLOCK{ 16 };
+		constexpr size_t BLOCK_SIZE{ STRIPE_SIZE * STRIPES_PER_BLOCK };
+
+		// Keys of the stripes, followed by the key of the scramble and the one of the final merge
+		constexpr size_t STRIPE_KEY_LANES{ STRIPES_PER_BLOCK - 1 + LANES };
+		constexpr size_t SCRAMBLE_KEY{ STRIPE_KEY_LANES };
+		constexpr size_t MERGE_KEY{ SCRAMBLE_KEY + LANES };
+		constexpr size_t KEY_LANES{ MERGE_KEY + LANES };
+
+		using Key = std::array<uint64_t, KEY_LANES>;
+
+		// https://prng.di.unimi.it/splitmix64.c
+		[[nodiscard]] constexpr Key GenerateKey() noexcept
+		{
+			Key key{ };
+			uint64_t state{ PRIME64_5 };
+			for (auto& lane : key)
+			{
+				state += 0x9E3779B97F4A7C15ull;
+				uint64_t z{ state };
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				lane = z ^ (z >> 31);
+			}
+			return key;
+		}
+
+		constexpr Key BASE_KEY{ GenerateKey() };
+
+		using Accumulators = std::array<uint64_t, LANES>;
+
+		[[nodiscard]] inline uint64_t Load64(uint8_t const* pData) noexcept
+		{
+			uint64_t value;
+			std::memcpy(&value, pData, sizeof(value));
+			return value;
+		}
+
+		// Low and high half of the 128 bit product folded together
+		[[nodiscard]] constexpr uint64_t Mul128Fold64(uint64_t lhs, uint64_t rhs) noexcept
+		{
+			uint64_t const loLo{ (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF) };
+			uint64_t const hiLo{ (lhs >> 32) * (rhs & 0xFFFFFFFF) };
+			uint64_t const loHi{ (lhs & 0xFFFFFFFF) * (rhs >> 32) };
+			uint64_t const hiHi{ (lhs >> 32) * (rhs >> 32) };
+
+			uint64_t const cross{ (loLo >> 32) + (hiLo & 0xFFFFFFFF) + loHi };
+			uint64_t const upper{ (hiLo >> 32) + (cross >> 32) + hiHi };
+			uint64_t const lower{ (cross << 32) | (loLo & 0xFFFFFFFF) };
+			return upper ^ lower;
+		}
+
+		[[nodiscard]] constexpr uint64_t Avalanche(uint64_t hash) noexcept
+		{
+			hash ^= hash >> 37;
+			hash *= 0x165667919E3779F9ull;
+			hash ^= hash >> 32;
+			return hash;
+		}
+
+		// Param uint64_t const* the LANES key lanes of this stripe
+		void AccumulateStripe(Accumulators& acc, uint8_t const* pStripe, uint64_t const* pKey) noexcept
+		{
+#if NES_EM_SSE2
+			for (size_t lane{ 0 }; lane < LANES; lane += 2)
+			{
+				__m128i const data{ _mm_loadu_si128(reinterpret_cast<__m128i const*>(pStripe + lane * sizeof(uint64_t))) };
+				__m128i const key{ _mm_loadu_si128(reinterpret_cast<__m128i const*>(pKey + lane)) };
+				__m128i const keyed{ _mm_xor_si128(data, key) };
+
+				// Low 32 bits of every lane times its high 32 bits
+				__m128i const product{ _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1))) };
+				// The raw data goes into the neighbouring lane, so no input bits are lost when a product is 0
+				__m128i const swapped{ _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)) };
+
+				__m128i* const pAcc{ reinterpret_cast<__m128i*>(acc.data() + lane) };
+				_mm_storeu_si128(pAcc, _mm_add_epi64(_mm_loadu_si128(pAcc), _mm_add_epi64(product, swapped)));
+			}
+#else
+			for (size_t lane{ 0 }; lane < LANES; ++lane)
+			{
+				uint64_t const data{ Load64(pStripe + lane * sizeof(uint64_t)) };
+				uint64_t const keyed{ data ^ pKey[lane] };
+
+				acc[lane ^ 1] += data;
+				acc[lane] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+			}
+#endif
+		}
+
+		void Scramble(Accumulators& acc, uint64_t const* pKey) noexcept
+		{
+#if NES_EM_SSE2
+			__m128i const prime{ _mm_set1_epi32(static_cast<int>(PRIME32_1)) };
+			for (size_t lane{ 0 }; lane < LANES; lane += 2)
+			{
+				__m128i* const pAcc{ reinterpret_cast<__m128i*>(acc.data() + lane) };
+				__m128i value{ _mm_loadu_si128(pAcc) };
+				value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+				value = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<__m128i const*>(pKey + lane)));
+
+				// 64 x 32 bit multiply out of two 32 x 32 bit ones
+				__m128i const low{ _mm_mul_epu32(value, prime) };
+				__m128i const high{ _mm_mul_epu32(_mm_srli_epi64(value, 32), prime) };
+				_mm_storeu_si128(pAcc, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+			}
+#else
+			for (size_t lane{ 0 }; lane < LANES; ++lane)
+			{
+				uint64_t value{ acc[lane] };
+				value ^= value >> 47;
+				value ^= pKey[lane];
+				acc[lane] = value * PRIME32_1;
+			}
+#endif
+		}
+	}
+
+	uint64_t Hash64(std::span<uint8_t const> data, uint64_t seed) noexcept
+	{
+		// Seeding changes every key lane, the same way for both code paths
+		Key key{ BASE_KEY };
+		if (seed)
+		{
+			for (size_t lane{ 0 }; lane < KEY_LANES; ++lane)
+			{
+				key[lane] += (lane & 1) ? 0 - seed : seed;
+			}
+		}
+
+		Accumulators acc{ PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1 };
+
+		uint8_t const* pData{ data.data() };
+		size_t const size{ data.size() };
+
+		size_t const blocks{ size / BLOCK_SIZE };
+		for (size_t block{ 0 }; block < blocks; ++block)
+		{
+			uint8_t const* const pBlock{ pData + block * BLOCK_SIZE };
+			for (size_t stripe{ 0 }; stripe < STRIPES_PER_BLOCK; ++stripe)
+			{
+				AccumulateStripe(acc, pBlock + stripe * STRIPE_SIZE, key.data() + stripe);
+			}
+			Scramble(acc, key.data() + SCRAMBLE_KEY);
+		}
+
+		size_t offset{ blocks * BLOCK_SIZE };
+		size_t stripe{ 0 };
+		for (; offset + STRIPE_SIZE <= size; offset += STRIPE_SIZE, ++stripe)
+		{
+			AccumulateStripe(acc, pData + offset, key.data() + stripe);
+		}
+
+		// Zero padded, the length mixed in below keeps padded inputs apart from ones that really end in zeroes
+		if (offset < size)
+		{
+			std::array<uint8_t, STRIPE_SIZE> last{ };
+			std::memcpy(last.data(), pData + offset, size - offset);
+			AccumulateStripe(acc, last.data(), key.data() + stripe);
+		}
+
+		uint64_t result{ size * PRIME64_1 + seed };
+		for (size_t lane{ 0 }; lane < LANES; lane += 2)
+		{
+			result += Mul128Fold64(acc[lane] ^ key[MERGE_KEY + lane], acc[lane + 1] ^ key[MERGE_KEY + lane + 1]);
+		}
+		return Avalanche(result);
+	}
+}
@@ -0,0 +1,23 @@
+#ifndef NES_EMULATOR_HASH
+#define NES_EMULATOR_HASH
+
+#include "emulator_pch.h"
+
+#include <span>
+
+/* Sources used during development of the hash:
+ * https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+ */
+
+namespace NesEm
+{
+	// Fast non cryptographic 64 bit hash for comparing frames and memory between runs (regression logs, golden files)
+	// Built like XXH3's long input path: 8 lanes of 64 bit accumulators over 64 byte stripes, SSE2 when available
+	// The SIMD and scalar paths give the same results, but the values are not the ones the xxHash library produces
+	// Param std::span bytes to hash
+	// Param uint64_t seed, chaining hashes of several buffers is done by passing the previous hash
+	// Return uint64_t hash
+	[[nodiscard]] uint64_t Hash64(std::span<uint8_t const> data, uint64_t seed = 0) noexcept;
+}
+
+#endif
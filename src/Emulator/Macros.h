@@ -5,6 +5,8 @@
 // Configuration
 #define NES_EM_USE_STATIC_CONSTEXPR_TABLE 1
 #define NES_EM_DEBUG_MODE 1
+// Log every opcode the CPU fetches, floods the console once full frames are emulated
+#define NES_EM_LOG_CPU_INSTRUCTIONS 0
 
 // Defines required when in debug or other config modes
 #if NES_EM_DEBUG_MODE
@@ -23,6 +25,21 @@
 	#define FORCE_INLINE inline
 #endif
 
+// SSE2 is part of every x86-64 target, 32 bit MSVC only reports it through _M_IX86_FP
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define NES_EM_SSE2 1
+#else
+	#define NES_EM_SSE2 0
+#endif
+
+// Lets a single function use AVX2 without building everything for it, callers check the CPU first (SDL_HasAVX2)
+// MSVC accepts AVX2 intrinsics in any function
+#if NES_EM_SSE2 && (defined(__GNUC__) || defined(__clang__))
+	#define NES_EM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define NES_EM_TARGET_AVX2
+#endif
+
 // Allow swapping between static and non static tables
 #if NES_EM_USE_STATIC_CONSTEXPR_TABLE
 	#define NES_EM_TABLE static constexpr
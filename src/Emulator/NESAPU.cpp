@@ -0,0 +1,757 @@
+#include "NESAPU.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace NesEm
+{
+	APU::APU(Cartridge& cart):
+		m_Cartridge{ cart },
+		m_Blip{ Config::CPU_CLOCK_RATE, Config::AUDIO_SAMPLE_RATE * Config::AUDIO_OVERSAMPLING, SAMPLE_CAPACITY }
+	{
+		m_Pulse[0].isFirst = true;
+
+		if constexpr (Config::AUDIO_OVERSAMPLING > 1)
+		{
+			m_pDecimator = std::make_unique<FIRDecimator>(Config::AUDIO_SAMPLE_RATE * Config::AUDIO_OVERSAMPLING, Config::AUDIO_SAMPLE_RATE);
+		}
+	}
+
+	void APU::CatchUp(uint64_t cpuCycle) noexcept
+	{
+		uint64_t const target{ cpuCycle * Config::APU_CYCLES_NUMERATOR / Config::APU_CYCLES_DENOMINATOR };
+
+		if (m_IsPerCycleReference)
+		{
+			while (m_Cycle < target)
+			{
+				ClockReference();
+			}
+			return;
+		}
+
+		// Nothing changes between events, so only those have to run
+		for (uint64_t next{ NextClock() }; next < target; next = NextClock())
+		{
+			Clock(next);
+		}
+		m_Cycle = std::max(m_Cycle, target);
+	}
+
+	uint64_t APU::NextSyncCPUCycle() const noexcept
+	{
+		uint64_t next{ std::numeric_limits<uint64_t>::max() };
+
+		// Clocks the frame counter still needs before it sets the flag on its last step
+		// Catching up runs the cycles before the target, so the target is 1 past the cycle the flag is set at
+		if (!m_IsFiveStep && !m_IsFrameIRQInhibited && !m_FrameIRQ)
+		{
+			next = m_FrameCounterStart + FOUR_STEP_TABLE.back();
+		}
+
+		// The flag is set when the last byte of the sample is fetched, the fetch follows the output unit emptying the buffer
+		if (m_DMC.irqEnabled && !m_DMC.loop && !m_DMC.irq && m_DMC.bytesRemaining > 0)
+		{
+			uint64_t fetch{ m_DMC.nextClock };
+			if (m_DMC.hasSample)
+			{
+				fetch += static_cast<uint64_t>(m_DMC.bitsRemaining - 1) * m_DMC.rate;
+			}
+			fetch += static_cast<uint64_t>(m_DMC.bytesRemaining - 1) * 8 * m_DMC.rate;
+
+			next = std::min(next, fetch + 1);
+		}
+
+		if (next == std::numeric_limits<uint64_t>::max())
+		{
+			return next;
+		}
+
+		// First CPU cycle that converts to at least that APU cycle
+		return (next * Config::APU_CYCLES_DENOMINATOR + Config::APU_CYCLES_NUMERATOR - 1) / Config::APU_CYCLES_NUMERATOR;
+	}
+
+	void APU::Write(uint16_t address, uint8_t value) noexcept
+	{
+		SkipIdleChannels();
+
+		switch (address)
+		{
+		case 0x4000:
+		case 0x4004:
+		{
+			Pulse& pulse{ m_Pulse[(address - 0x4000) / 4] };
+			pulse.duty = value >> 6;
+			pulse.envelope.loop = value & 0x20;
+			pulse.envelope.isConstant = value & 0x10;
+			pulse.envelope.period = value & 0x0F;
+		}break;
+
+		case 0x4001:
+		case 0x4005:
+		{
+			Pulse& pulse{ m_Pulse[(address - 0x4000) / 4] };
+			pulse.sweepEnabled = value & 0x80;
+			pulse.sweepPeriod = (value >> 4) & 0x07;
+			pulse.sweepNegate = value & 0x08;
+			pulse.sweepShift = value & 0x07;
+			pulse.sweepReload = true;
+		}break;
+
+		case 0x4002:
+		case 0x4006:
+		{
+			Pulse& pulse{ m_Pulse[(address - 0x4000) / 4] };
+			pulse.period = static_cast<uint16_t>((pulse.period & 0x0700) | value);
+		}break;
+
+		case 0x4003:
+		case 0x4007:
+		{
+			Pulse& pulse{ m_Pulse[(address - 0x4000) / 4] };
+			pulse.period = static_cast<uint16_t>((pulse.period & 0x00FF) | ((value & 0x07) << 8));
+			if (pulse.isEnabled)
+			{
+				pulse.length = LENGTH_TABLE[value >> 3];
+			}
+			pulse.step = 0;
+			pulse.envelope.start = true;
+		}break;
+
+		case 0x4008:
+			m_Triangle.control = value & 0x80;
+			m_Triangle.linearReloadValue = value & 0x7F;
+			break;
+
+		case 0x400A:
+			m_Triangle.period = static_cast<uint16_t>((m_Triangle.period & 0x0700) | value);
+			break;
+
+		case 0x400B:
+			m_Triangle.period = static_cast<uint16_t>((m_Triangle.period & 0x00FF) | ((value & 0x07) << 8));
+			if (m_Triangle.isEnabled)
+			{
+				m_Triangle.length = LENGTH_TABLE[value >> 3];
+			}
+			m_Triangle.linearReload = true;
+			break;
+
+		case 0x400C:
+			m_Noise.envelope.loop = value & 0x20;
+			m_Noise.envelope.isConstant = value & 0x10;
+			m_Noise.envelope.period = value & 0x0F;
+			break;
+
+		case 0x400E:
+			m_Noise.isShortMode = value & 0x80;
+			m_Noise.period = NOISE_PERIOD_TABLE[value & 0x0F];
+			break;
+
+		case 0x400F:
+			if (m_Noise.isEnabled)
+			{
+				m_Noise.length = LENGTH_TABLE[value >> 3];
+			}
+			m_Noise.envelope.start = true;
+			break;
+
+		case 0x4010:
+			m_DMC.irqEnabled = value & 0x80;
+			m_DMC.loop = value & 0x40;
+			m_DMC.rate = DMC_RATE_TABLE[value & 0x0F];
+			if (!m_DMC.irqEnabled)
+			{
+				m_DMC.irq = false;
+			}
+			break;
+
+		case 0x4011:
+			// Direct load, how games play PCM without the sample unit
+			m_DMC.level = value & 0x7F;
+			break;
+
+		case 0x4012:
+			m_DMC.sampleAddress = static_cast<uint16_t>(0xC000 | (value << 6));
+			break;
+
+		case 0x4013:
+			m_DMC.sampleLength = static_cast<uint16_t>((value << 4) | 1);
+			break;
+
+		case STATUS_ADDRESS:
+		{
+			m_Pulse[0].isEnabled = value & 0x01;
+			m_Pulse[1].isEnabled = value & 0x02;
+			m_Triangle.isEnabled = value & 0x04;
+			m_Noise.isEnabled = value & 0x08;
+
+			// Disabling a channel silences it right away
+			for (Pulse& pulse : m_Pulse)
+			{
+				pulse.length = pulse.isEnabled ? pulse.length : 0;
+			}
+			m_Triangle.length = m_Triangle.isEnabled ? m_Triangle.length : 0;
+			m_Noise.length = m_Noise.isEnabled ? m_Noise.length : 0;
+
+			m_DMC.irq = false;
+			if (!(value & 0x10))
+			{
+				m_DMC.bytesRemaining = 0;
+			}
+			else if (m_DMC.bytesRemaining == 0)
+			{
+				RestartDMC();
+				FetchDMCSample();
+			}
+		}break;
+
+		case FRAME_COUNTER_ADDRESS:
+			m_IsFiveStep = value & 0x80;
+			m_IsFrameIRQInhibited = value & 0x40;
+			if (m_IsFrameIRQInhibited)
+			{
+				m_FrameIRQ = false;
+			}
+
+			// The sequencer restarts (a few cycles later on hardware), 5 step mode clocks all units straight away
+			ResetFrameCounter(m_Cycle);
+			if (m_IsFiveStep)
+			{
+				ClockQuarterFrame();
+				ClockHalfFrame();
+			}
+			break;
+
+		default: break;
+		}
+
+		UpdateOutput();
+	}
+
+	uint8_t APU::ReadStatus() noexcept
+	{
+		uint8_t status{ 0 };
+		status |= (m_Pulse[0].length > 0) ? 0x01 : 0x00;
+		status |= (m_Pulse[1].length > 0) ? 0x02 : 0x00;
+		status |= (m_Triangle.length > 0) ? 0x04 : 0x00;
+		status |= (m_Noise.length > 0) ? 0x08 : 0x00;
+		status |= (m_DMC.bytesRemaining > 0) ? 0x10 : 0x00;
+		status |= m_FrameIRQ ? 0x40 : 0x00;
+		status |= m_DMC.irq ? 0x80 : 0x00;
+
+		m_FrameIRQ = false;
+		return status;
+	}
+
+	void APU::EndFrame() noexcept
+	{
+		if (m_IsCapturingRaw)
+		{
+			CaptureRawOutput();
+			m_RawFrame.swap(m_RawOutput);
+			m_RawOutput.clear();
+		}
+
+		m_Blip.EndFrame(static_cast<uint32_t>(m_Cycle - m_FrameStartCycle));
+		m_FrameStartCycle = m_Cycle;
+
+		if (m_SampleRateRatio != m_AppliedSampleRateRatio)
+		{
+			m_Blip.SetRates(Config::CPU_CLOCK_RATE, Config::AUDIO_SAMPLE_RATE * Config::AUDIO_OVERSAMPLING * m_SampleRateRatio);
+			m_AppliedSampleRateRatio = m_SampleRateRatio;
+		}
+
+		if (m_pDecimator)
+		{
+			m_Oversampled.resize(m_Blip.SamplesAvailable());
+			m_Blip.ReadSamples(m_Oversampled);
+
+			size_t const start{ m_Decimated.size() };
+			m_Decimated.resize(start + m_pDecimator->MaxOutput(static_cast<uint32_t>(m_Oversampled.size())));
+			uint32_t const written{ m_pDecimator->Process(m_Oversampled, std::span{ m_Decimated }.subspan(start)) };
+			m_Decimated.resize(start + written);
+		}
+	}
+
+	void APU::SetRawOutputCapture(bool isEnabled) noexcept
+	{
+		m_IsCapturingRaw = isEnabled;
+		m_RawCycle = m_Cycle;
+		m_RawOutput.clear();
+		m_RawFrame.clear();
+	}
+
+	uint32_t APU::SamplesAvailable() const noexcept
+	{
+		return m_pDecimator ? static_cast<uint32_t>(m_Decimated.size()) : m_Blip.SamplesAvailable();
+	}
+
+	uint32_t APU::ReadSamples(std::span<int16_t> samples) noexcept
+	{
+		if (!m_pDecimator)
+		{
+			return m_Blip.ReadSamples(samples);
+		}
+
+		size_t const count{ std::min(samples.size(), m_Decimated.size()) };
+		std::copy_n(m_Decimated.begin(), count, samples.begin());
+		m_Decimated.erase(m_Decimated.begin(), m_Decimated.begin() + count);
+		return static_cast<uint32_t>(count);
+	}
+
+	uint64_t APU::NextClock() const noexcept
+	{
+		uint64_t next{ std::min(m_NextFrameStepCycle, m_DMC.nextClock) };
+		for (Pulse const& pulse : m_Pulse)
+		{
+			if (!pulse.IsIdle())
+			{
+				next = std::min(next, pulse.nextClock);
+			}
+		}
+		if (!m_Triangle.IsIdle())
+		{
+			next = std::min(next, m_Triangle.nextClock);
+		}
+		if (!m_Noise.IsIdle())
+		{
+			next = std::min(next, m_Noise.nextClock);
+		}
+		return next;
+	}
+
+	void APU::Clock(uint64_t cycle) noexcept
+	{
+		m_Cycle = cycle;
+
+		// Same order as the hardware within a cycle, the frame counter can wake channels whose timer is due this cycle
+		if (cycle == m_NextFrameStepCycle)
+		{
+			ClockFrameCounter();
+		}
+
+		for (Pulse& pulse : m_Pulse)
+		{
+			if (pulse.nextClock == cycle)
+			{
+				pulse.ClockTimer(cycle);
+			}
+		}
+		if (m_Triangle.nextClock == cycle)
+		{
+			m_Triangle.ClockTimer(cycle);
+		}
+		if (m_Noise.nextClock == cycle)
+		{
+			m_Noise.ClockTimer(cycle);
+		}
+		if (m_DMC.nextClock == cycle)
+		{
+			ClockDMC();
+		}
+
+		// The new output is heard from the end of the cycle
+		m_Cycle = cycle + 1;
+		UpdateOutput();
+	}
+
+	void APU::ClockReference() noexcept
+	{
+		uint64_t const cycle{ m_Cycle };
+
+		uint32_t const frameStep{ m_IsFiveStep ? FIVE_STEP_TABLE[m_FrameStep] : FOUR_STEP_TABLE[m_FrameStep] };
+		if (cycle - m_FrameCounterStart + 1 == frameStep)
+		{
+			ClockFrameCounter();
+		}
+
+		// The sequencers are shared with the event driven APU, only when they are clocked is worked out here
+		// Pulse timers tick on odd cycles
+		if (cycle % 2 == 1)
+		{
+			for (size_t pulse{ 0 }; pulse < m_Pulse.size(); ++pulse)
+			{
+				uint16_t& timer{ m_ReferenceTimers.pulse[pulse] };
+				if (timer == 0)
+				{
+					timer = m_Pulse[pulse].period;
+					m_Pulse[pulse].ClockTimer(cycle);
+				}
+				else
+				{
+					--timer;
+				}
+			}
+		}
+
+		if (m_ReferenceTimers.triangle == 0)
+		{
+			m_ReferenceTimers.triangle = m_Triangle.period;
+			m_Triangle.ClockTimer(cycle);
+		}
+		else
+		{
+			--m_ReferenceTimers.triangle;
+		}
+
+		// The noise and DMC periods count cycles between clocks
+		if (m_ReferenceTimers.noise == 0)
+		{
+			m_ReferenceTimers.noise = static_cast<uint16_t>(m_Noise.period - 1);
+			m_Noise.ClockTimer(cycle);
+		}
+		else
+		{
+			--m_ReferenceTimers.noise;
+		}
+
+		if (m_ReferenceTimers.dmc == 0)
+		{
+			m_ReferenceTimers.dmc = static_cast<uint16_t>(m_DMC.rate - 1);
+			ClockDMC();
+		}
+		else
+		{
+			--m_ReferenceTimers.dmc;
+		}
+
+		m_Cycle = cycle + 1;
+		UpdateOutput();
+	}
+
+	void APU::SkipIdleChannels() noexcept
+	{
+		// Every timer already ran up to now
+		if (m_IsPerCycleReference)
+		{
+			return;
+		}
+
+		for (Pulse& pulse : m_Pulse)
+		{
+			if (pulse.IsIdle())
+			{
+				pulse.SkipTo(m_Cycle);
+			}
+		}
+		if (m_Triangle.IsIdle())
+		{
+			m_Triangle.SkipTo(m_Cycle);
+		}
+		if (m_Noise.IsIdle())
+		{
+			m_Noise.SkipTo(m_Cycle);
+		}
+	}
+
+	void APU::ResetFrameCounter(uint64_t cycle) noexcept
+	{
+		m_FrameCounterStart = cycle;
+		m_FrameStep = 0;
+		m_NextFrameStepCycle = cycle + (m_IsFiveStep ? FIVE_STEP_TABLE[0] : FOUR_STEP_TABLE[0]) - 1;
+	}
+
+	void APU::ClockFrameCounter() noexcept
+	{
+		// Envelopes, length counters and sweeps can wake idle channels up
+		SkipIdleChannels();
+
+		if (!m_IsFiveStep)
+		{
+			ClockQuarterFrame();
+			if (m_FrameStep == 1 || m_FrameStep == 3)
+			{
+				ClockHalfFrame();
+			}
+
+			if (m_FrameStep == 3)
+			{
+				m_FrameIRQ = m_FrameIRQ || !m_IsFrameIRQInhibited;
+				ResetFrameCounter(m_Cycle + 1);
+				return;
+			}
+		}
+		else
+		{
+			// The 4th step does nothing in 5 step mode
+			if (m_FrameStep != 3)
+			{
+				ClockQuarterFrame();
+			}
+			if (m_FrameStep == 1 || m_FrameStep == 4)
+			{
+				ClockHalfFrame();
+			}
+
+			if (m_FrameStep == 4)
+			{
+				ResetFrameCounter(m_Cycle + 1);
+				return;
+			}
+		}
+
+		++m_FrameStep;
+		m_NextFrameStepCycle = m_FrameCounterStart + (m_IsFiveStep ? FIVE_STEP_TABLE[m_FrameStep] : FOUR_STEP_TABLE[m_FrameStep]) - 1;
+	}
+
+	void APU::ClockQuarterFrame() noexcept
+	{
+		m_Pulse[0].envelope.Clock();
+		m_Pulse[1].envelope.Clock();
+		m_Noise.envelope.Clock();
+		m_Triangle.ClockLinearCounter();
+	}
+
+	void APU::ClockHalfFrame() noexcept
+	{
+		// The envelope loop flag doubles as the length counter halt flag
+		for (Pulse& pulse : m_Pulse)
+		{
+			if (!pulse.envelope.loop && pulse.length > 0)
+			{
+				--pulse.length;
+			}
+			pulse.ClockSweep();
+		}
+
+		if (!m_Triangle.control && m_Triangle.length > 0)
+		{
+			--m_Triangle.length;
+		}
+
+		if (!m_Noise.envelope.loop && m_Noise.length > 0)
+		{
+			--m_Noise.length;
+		}
+	}
+
+	void APU::ClockDMC() noexcept
+	{
+		m_DMC.nextClock = m_Cycle + m_DMC.rate;
+
+		// Output unit, every bit moves the level 2 up or down
+		if (!m_DMC.isSilent)
+		{
+			if (m_DMC.shift & 0x01)
+			{
+				m_DMC.level = (m_DMC.level <= 125) ? static_cast<uint8_t>(m_DMC.level + 2) : m_DMC.level;
+			}
+			else
+			{
+				m_DMC.level = (m_DMC.level >= 2) ? static_cast<uint8_t>(m_DMC.level - 2) : m_DMC.level;
+			}
+		}
+		m_DMC.shift >>= 1;
+
+		if (--m_DMC.bitsRemaining == 0)
+		{
+			m_DMC.bitsRemaining = 8;
+			m_DMC.isSilent = !m_DMC.hasSample;
+			if (m_DMC.hasSample)
+			{
+				m_DMC.shift = m_DMC.sampleBuffer;
+				m_DMC.hasSample = false;
+			}
+		}
+
+		// The buffer only empties here, refill it right away
+		FetchDMCSample();
+	}
+
+	void APU::FetchDMCSample() noexcept
+	{
+		if (m_DMC.hasSample || m_DMC.bytesRemaining == 0)
+		{
+			return;
+		}
+
+		// The real DMA steals a few CPU cycles, that stall is not emulated
+		m_DMC.sampleBuffer = m_Cartridge.Read(m_DMC.currentAddress);
+		m_DMC.hasSample = true;
+		m_DMC.currentAddress = (m_DMC.currentAddress == 0xFFFF) ? 0x8000 : static_cast<uint16_t>(m_DMC.currentAddress + 1);
+
+		if (--m_DMC.bytesRemaining == 0)
+		{
+			if (m_DMC.loop)
+			{
+				RestartDMC();
+			}
+			else if (m_DMC.irqEnabled)
+			{
+				m_DMC.irq = true;
+			}
+		}
+	}
+
+	void APU::RestartDMC() noexcept
+	{
+		m_DMC.currentAddress = m_DMC.sampleAddress;
+		m_DMC.bytesRemaining = m_DMC.sampleLength;
+	}
+
+	void APU::UpdateOutput() noexcept
+	{
+		int32_t const amplitude{ PULSE_MIX_TABLE[m_Pulse[0].Output() + m_Pulse[1].Output()]
+			+ TND_MIX_TABLE[3 * m_Triangle.Output() + 2 * m_Noise.Output() + m_DMC.Output()] };
+
+		if (amplitude != m_Amplitude)
+		{
+			if (m_IsCapturingRaw)
+			{
+				CaptureRawOutput();
+			}
+			m_Blip.AddDelta(static_cast<uint32_t>(m_Cycle - m_FrameStartCycle), amplitude - m_Amplitude);
+			m_Amplitude = amplitude;
+		}
+	}
+
+	void APU::CaptureRawOutput() noexcept
+	{
+		if (m_Cycle > m_RawCycle)
+		{
+			m_RawOutput.insert(m_RawOutput.end(), static_cast<size_t>(m_Cycle - m_RawCycle), static_cast<int16_t>(m_Amplitude));
+			m_RawCycle = m_Cycle;
+		}
+	}
+
+	void APU::Envelope::Clock() noexcept
+	{
+		if (start)
+		{
+			start = false;
+			decay = 15;
+			divider = period;
+			return;
+		}
+
+		if (divider > 0)
+		{
+			--divider;
+			return;
+		}
+
+		divider = period;
+		if (decay > 0)
+		{
+			--decay;
+		}
+		else if (loop)
+		{
+			decay = 15;
+		}
+	}
+
+	void APU::Pulse::ClockTimer(uint64_t cycle) noexcept
+	{
+		// Reloaded with the period, then counts down once every 2 cycles
+		nextClock = cycle + 2 * (static_cast<uint64_t>(period) + 1);
+		step = (step + 1) & 0x07;
+	}
+
+	bool APU::Pulse::IsIdle() const noexcept
+	{
+		// Periods below 8 and sweeps that would overflow mute the channel, even when the sweep is disabled
+		return length == 0 || period < 8 || SweepTarget() > 0x07FF || envelope.Volume() == 0;
+	}
+
+	void APU::Pulse::SkipTo(uint64_t cycle) noexcept
+	{
+		if (nextClock >= cycle)
+		{
+			return;
+		}
+
+		// The period can't have changed while idle, every write and frame counter step skips ahead first
+		uint64_t const clockPeriod{ 2 * (static_cast<uint64_t>(period) + 1) };
+		uint64_t const clocks{ (cycle - nextClock + clockPeriod - 1) / clockPeriod };
+		nextClock += clocks * clockPeriod;
+		step = static_cast<uint8_t>((step + clocks) & 0x07);
+	}
+
+	void APU::Pulse::ClockSweep() noexcept
+	{
+		uint16_t const target{ SweepTarget() };
+		if (sweepDivider == 0 && sweepEnabled && sweepShift > 0 && period >= 8 && target <= 0x07FF)
+		{
+			period = target;
+		}
+
+		if (sweepDivider == 0 || sweepReload)
+		{
+			sweepDivider = sweepPeriod;
+			sweepReload = false;
+		}
+		else
+		{
+			--sweepDivider;
+		}
+	}
+
+	uint16_t APU::Pulse::SweepTarget() const noexcept
+	{
+		uint16_t const change{ static_cast<uint16_t>(period >> sweepShift) };
+		if (!sweepNegate)
+		{
+			return static_cast<uint16_t>(period + change);
+		}
+
+		// Clamped at 0, a negative target never mutes
+		int32_t const target{ period - change - (isFirst ? 1 : 0) };
+		return static_cast<uint16_t>(std::max(target, 0));
+	}
+
+	void APU::Triangle::ClockTimer(uint64_t cycle) noexcept
+	{
+		nextClock = cycle + period + 1;
+		if (!IsIdle())
+		{
+			step = (step + 1) & 0x1F;
+		}
+	}
+
+	void APU::Triangle::SkipTo(uint64_t cycle) noexcept
+	{
+		if (nextClock >= cycle)
+		{
+			return;
+		}
+
+		// Only the timer moves, the sequencer holds
+		uint64_t const clockPeriod{ static_cast<uint64_t>(period) + 1 };
+		nextClock += (cycle - nextClock + clockPeriod - 1) / clockPeriod * clockPeriod;
+	}
+
+	void APU::Triangle::ClockLinearCounter() noexcept
+	{
+		if (linearReload)
+		{
+			linearCounter = linearReloadValue;
+		}
+		else if (linearCounter > 0)
+		{
+			--linearCounter;
+		}
+
+		if (!control)
+		{
+			linearReload = false;
+		}
+	}
+
+	void APU::Noise::ClockTimer(uint64_t cycle) noexcept
+	{
+		nextClock = cycle + period;
+
+		// Short mode taps bit 6 instead of bit 1, which gives a 93 step metallic loop
+		uint16_t const feedback{ static_cast<uint16_t>((shift ^ (shift >> (isShortMode ? 6 : 1))) & 0x01) };
+		shift = static_cast<uint16_t>((shift >> 1) | (feedback << 14));
+	}
+
+	void APU::Noise::SkipTo(uint64_t cycle) noexcept
+	{
+		while (nextClock < cycle)
+		{
+			ClockTimer(nextClock);
+		}
+	}
+}
@@ -0,0 +1,373 @@
+#ifndef NES_EMULATOR_APU
+#define NES_EMULATOR_APU
+
+#include "emulator_pch.h"
+
+#include "NESCartridge.h"
+#include "BlipBuffer.h"
+#include "FIRDecimator.h"
+
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+/* Various sources used during development of the APU of our emulator:
+ * https://www.nesdev.org/wiki/APU
+ * https://www.nesdev.org/wiki/APU_Frame_Counter
+ * https://www.nesdev.org/wiki/APU_Envelope
+ * https://www.nesdev.org/wiki/APU_Sweep
+ * https://www.nesdev.org/wiki/APU_Length_Counter
+ * https://www.nesdev.org/wiki/APU_Pulse
+ * https://www.nesdev.org/wiki/APU_Triangle
+ * https://www.nesdev.org/wiki/APU_Noise
+ * https://www.nesdev.org/wiki/APU_DMC
+ * https://www.nesdev.org/wiki/APU_Mixer
+ */
+
+namespace NesEm
+{
+	// The APU or Audio Processing Unit generates the sound: 2 pulse channels, a triangle, noise and a DMC (delta modulated samples)
+	// It does not output a sample every cycle, every change of the mixed output goes into a blip buffer as a band-limited step
+	// With Config::AUDIO_OVERSAMPLING the blip buffer runs at a multiple of the output rate and a FIR decimator brings it down
+	// The APU counts real CPU cycles (see Config::APU_CYCLES_NUMERATOR), the times the CPU passes in are converted
+	//
+	// It only runs when something observes it: register accesses, its IRQ deadlines and the end of a frame (samples are needed)
+	// Catching up jumps from timer event to timer event, channels that can't change the output (muted, halted) are skipped in bulk
+	class APU final
+	{
+	public:
+		explicit APU(Cartridge& cart);
+		~APU() = default;
+
+		APU(APU const&) = delete;
+		APU(APU&&) = delete;
+		APU& operator=(APU const&) = delete;
+		APU& operator=(APU&&) = delete;
+
+		// Param uint64_t CPU cycle the CPU is at
+		// Runs the APU up to that point, the CPU calls this before it touches an APU register so it sees the state at that time
+		// Costs one step per timer event since the last call, not one per cycle
+		void CatchUp(uint64_t cpuCycle) noexcept;
+
+		// Return uint64_t first CPU cycle at which the APU raises an IRQ (frame counter, end of a DMC sample), UINT64_MAX when none is coming
+		// The scheduler catches the APU up there so the CPU sees the IRQ on time
+		[[nodiscard]] uint64_t NextSyncCPUCycle() const noexcept;
+
+		// Return bool is the APU holding the CPU's IRQ line low (frame counter or DMC interrupt flag)
+		[[nodiscard]] bool IsIRQAsserted() const noexcept { return m_FrameIRQ || m_DMC.irq; }
+
+		// Param uint16_t register $4000 - $4013, $4015 or $4017
+		void Write(uint16_t address, uint8_t value) noexcept;
+		// Reads $4015, the only readable register, clears the frame interrupt flag
+		[[nodiscard]] uint8_t ReadStatus() noexcept;
+
+		// Makes the samples up to where the APU is caught up available, call once per emulated frame after catching it up
+		void EndFrame() noexcept;
+		// Param double factor the output sample rate is scaled by, for dynamic rate control (close to 1)
+		// Applied from the next audio frame, a frame's deltas are all placed with the same rate
+		void SetSampleRateRatio(double ratio) noexcept { m_SampleRateRatio = ratio; }
+		// Return uint32_t samples (Config::AUDIO_SAMPLE_RATE, mono) that can be read
+		[[nodiscard]] uint32_t SamplesAvailable() const noexcept;
+		// Param std::span where to write the samples
+		// Return uint32_t samples written
+		uint32_t ReadSamples(std::span<int16_t> samples) noexcept;
+
+		// Param bool also keep the mixer's output of every APU cycle, before the blip buffer resamples it
+		// About 33000 samples a frame, for bit exact audio logs that don't depend on the resampling
+		void SetRawOutputCapture(bool isEnabled) noexcept;
+		// Return std::span mixer output of every cycle of the last audio frame (see EndFrame), Config::CPU_CLOCK_RATE mono
+		// Empty without raw output capture
+		[[nodiscard]] std::span<int16_t const> RawOutput() const noexcept { return m_RawFrame; }
+
+		// Param bool clock every channel's timer on every cycle with plain down counters, the way the hardware does,
+		// instead of jumping from event to event and fast forwarding idle channels. Call before the APU first runs
+		// Many times slower, only the reference --verify-apu checks the event driven APU against
+		void SetPerCycleReference(bool isEnabled) noexcept { m_IsPerCycleReference = isEnabled; }
+
+	private:
+#pragma region constants
+		static constexpr uint16_t STATUS_ADDRESS{ 0x4015 };
+		static constexpr uint16_t FRAME_COUNTER_ADDRESS{ 0x4017 };
+
+		// Most samples waiting to be read, a few frames worth
+		static constexpr uint32_t SAMPLE_CAPACITY{ Config::AUDIO_SAMPLE_RATE * Config::AUDIO_OVERSAMPLING / 10 };
+
+		// The tables are static constexpr whatever NES_EM_USE_STATIC_CONSTEXPR_TABLE says, the channel structs and their defaults use them
+		// Length counter values loaded by the upper 5 bits of $4003, $4007, $400B and $400F
+		static constexpr std::array<uint8_t, 32> LENGTH_TABLE
+		{
+			10, 254, 20, 2, 40, 4, 80, 6, 160, 8, 60, 10, 14, 12, 26, 14,
+			12, 16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30
+		};
+
+		// 12.5%, 25%, 50%, 25% negated
+		static constexpr std::array<std::array<uint8_t, 8>, 4> DUTY_TABLE
+		{ {
+			{ 0, 1, 0, 0, 0, 0, 0, 0 },
+			{ 0, 1, 1, 0, 0, 0, 0, 0 },
+			{ 0, 1, 1, 1, 1, 0, 0, 0 },
+			{ 1, 0, 0, 1, 1, 1, 1, 1 }
+		} };
+
+		static constexpr std::array<uint8_t, 32> TRIANGLE_TABLE
+		{
+			15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+			0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+		};
+
+		// Timer periods in CPU cycles
+		static constexpr std::array<uint16_t, 16> NOISE_PERIOD_TABLE
+		{
+			Config::MODE == Config::NES_MODE::PAL
+				? std::array<uint16_t, 16>{ 4, 8, 14, 30, 60, 88, 118, 148, 188, 236, 354, 472, 708, 944, 1890, 3778 }
+				: std::array<uint16_t, 16>{ 4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068 }
+		};
+		static constexpr std::array<uint16_t, 16> DMC_RATE_TABLE
+		{
+			Config::MODE == Config::NES_MODE::PAL
+				? std::array<uint16_t, 16>{ 398, 354, 316, 298, 276, 236, 210, 198, 176, 148, 132, 118, 98, 78, 66, 50 }
+				: std::array<uint16_t, 16>{ 428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54 }
+		};
+
+		// Frame counter steps in CPU cycles since it was reset, the last step of each mode wraps it around
+		static constexpr std::array<uint32_t, 4> FOUR_STEP_TABLE
+		{
+			Config::MODE == Config::NES_MODE::PAL
+				? std::array<uint32_t, 4>{ 8313, 16627, 24939, 33253 }
+				: std::array<uint32_t, 4>{ 7457, 14913, 22371, 29829 }
+		};
+		static constexpr std::array<uint32_t, 5> FIVE_STEP_TABLE
+		{
+			Config::MODE == Config::NES_MODE::PAL
+				? std::array<uint32_t, 5>{ 8313, 16627, 24939, 33253, 41565 }
+				: std::array<uint32_t, 5>{ 7457, 14913, 22371, 29829, 37281 }
+		};
+
+		// The mixer is nonlinear, a louder channel adds less, the formulas are precomputed for every input of each group
+		// Pulse group by pulse 1 + pulse 2 (0 - 30), triangle, noise and DMC group by 3 * triangle + 2 * noise + DMC (0 - 202)
+		// Scaled so both groups at their loudest add up to the full int16_t range
+		// Built at compile time like the tables above, never once per APU whatever NES_EM_USE_STATIC_CONSTEXPR_TABLE says
+		static constexpr double MIXER_PEAK{ 95.52 / (8128.0 / 30.0 + 100.0) + 163.67 / (24329.0 / 202.0 + 100.0) };
+		static constexpr std::array<int16_t, 31> PULSE_MIX_TABLE
+		{
+			[]()
+			{
+				std::array<int16_t, 31> table{ };
+				for (size_t sum{ 1 }; sum < table.size(); ++sum)
+				{
+					table[sum] = static_cast<int16_t>(95.52 / (8128.0 / static_cast<double>(sum) + 100.0) / MIXER_PEAK * 32767.0 + 0.5);
+				}
+				return table;
+			}()
+		};
+		static constexpr std::array<int16_t, 203> TND_MIX_TABLE
+		{
+			[]()
+			{
+				std::array<int16_t, 203> table{ };
+				for (size_t sum{ 1 }; sum < table.size(); ++sum)
+				{
+					table[sum] = static_cast<int16_t>(163.67 / (24329.0 / static_cast<double>(sum) + 100.0) / MIXER_PEAK * 32767.0 + 0.5);
+				}
+				return table;
+			}()
+		};
+#pragma endregion
+
+		// Volume of the pulse and noise channels, either constant or a decaying sawtooth
+		struct Envelope final
+		{
+			bool start{ false };
+			bool loop{ false };
+			bool isConstant{ false };
+			uint8_t period{ 0 };
+			uint8_t divider{ 0 };
+			uint8_t decay{ 0 };
+
+			// Quarter frame
+			void Clock() noexcept;
+			[[nodiscard]] uint8_t Volume() const noexcept { return isConstant ? period : decay; }
+		};
+
+		// Every channel's timer is kept as the cycle it next reaches 0 at (clocks the sequencer / output unit) instead of a counter
+		// Ticking a counter down every cycle is what makes catching up in bulk possible
+
+		struct Pulse final
+		{
+			Envelope envelope{ };
+
+			uint8_t duty{ 0 };
+			uint8_t step{ 0 };
+			uint16_t period{ 0 };
+			// Pulse timers tick on odd cycles, at half the CPU clock
+			uint64_t nextClock{ 1 };
+			uint8_t length{ 0 };
+			bool isEnabled{ false };
+
+			bool sweepEnabled{ false };
+			bool sweepNegate{ false };
+			bool sweepReload{ false };
+			uint8_t sweepPeriod{ 0 };
+			uint8_t sweepShift{ 0 };
+			uint8_t sweepDivider{ 0 };
+			// Pulse 1 negates with the one's complement, pulse 2 with the two's complement
+			bool isFirst{ false };
+
+			// Param uint64_t cycle the timer reached 0 at
+			void ClockTimer(uint64_t cycle) noexcept;
+			// Half frame
+			void ClockSweep() noexcept;
+			[[nodiscard]] uint16_t SweepTarget() const noexcept;
+			// Return bool is the output 0 whatever the sequencer's step
+			[[nodiscard]] bool IsIdle() const noexcept;
+			// Param uint64_t cycle to fast forward the timer and sequencer to while idle
+			void SkipTo(uint64_t cycle) noexcept;
+			[[nodiscard]] uint8_t Output() const noexcept { return (IsIdle() || DUTY_TABLE[duty][step] == 0) ? 0 : envelope.Volume(); }
+		};
+
+		struct Triangle final
+		{
+			uint8_t step{ 0 };
+			uint16_t period{ 0 };
+			uint64_t nextClock{ 0 };
+			uint8_t length{ 0 };
+			bool isEnabled{ false };
+
+			// Also halts the length counter
+			bool control{ false };
+			bool linearReload{ false };
+			uint8_t linearReloadValue{ 0 };
+			uint8_t linearCounter{ 0 };
+
+			// Param uint64_t cycle the timer reached 0 at
+			void ClockTimer(uint64_t cycle) noexcept;
+			// Quarter frame
+			void ClockLinearCounter() noexcept;
+			// Return bool is the sequencer halted, the output holds its level
+			// Ultrasonic periods are counted as halted too, they'd only produce a pop on real hardware
+			[[nodiscard]] bool IsIdle() const noexcept { return length == 0 || linearCounter == 0 || period < 2; }
+			void SkipTo(uint64_t cycle) noexcept;
+			[[nodiscard]] uint8_t Output() const noexcept { return TRIANGLE_TABLE[step]; }
+		};
+
+		struct Noise final
+		{
+			Envelope envelope{ };
+
+			bool isShortMode{ false };
+			uint16_t period{ NOISE_PERIOD_TABLE[0] };
+			uint64_t nextClock{ 0 };
+			// Linear feedback shift register, 1 at power up
+			uint16_t shift{ 1 };
+			uint8_t length{ 0 };
+			bool isEnabled{ false };
+
+			// Param uint64_t cycle the timer reached 0 at
+			void ClockTimer(uint64_t cycle) noexcept;
+			[[nodiscard]] bool IsIdle() const noexcept { return length == 0 || envelope.Volume() == 0; }
+			// Still shifts the LFSR, the pattern continues where it would have been
+			void SkipTo(uint64_t cycle) noexcept;
+			[[nodiscard]] uint8_t Output() const noexcept { return (IsIdle() || (shift & 0x01)) ? 0 : envelope.Volume(); }
+		};
+
+		struct DMC final
+		{
+			bool irqEnabled{ false };
+			bool loop{ false };
+			uint16_t rate{ DMC_RATE_TABLE[0] };
+			uint64_t nextClock{ 0 };
+			uint8_t level{ 0 };
+
+			uint16_t sampleAddress{ 0xC000 };
+			uint16_t sampleLength{ 1 };
+			uint16_t currentAddress{ 0xC000 };
+			uint16_t bytesRemaining{ 0 };
+
+			uint8_t sampleBuffer{ 0 };
+			bool hasSample{ false };
+			uint8_t shift{ 0 };
+			uint8_t bitsRemaining{ 8 };
+			bool isSilent{ true };
+
+			bool irq{ false };
+
+			[[nodiscard]] uint8_t Output() const noexcept { return level; }
+		};
+
+		Cartridge& m_Cartridge;
+
+		std::array<Pulse, 2> m_Pulse{ };
+		Triangle m_Triangle{ };
+		Noise m_Noise{ };
+		DMC m_DMC{ };
+
+		bool m_IsFiveStep{ false };
+		bool m_IsFrameIRQInhibited{ false };
+		bool m_FrameIRQ{ false };
+		uint8_t m_FrameStep{ 0 };
+		// Cycle the frame counter was last reset at and the cycle of its next step
+		uint64_t m_FrameCounterStart{ 0 };
+		uint64_t m_NextFrameStepCycle{ FOUR_STEP_TABLE[0] - 1 };
+
+		// APU cycles (real CPU cycles) run so far
+		uint64_t m_Cycle{ 0 };
+		// Cycle the current audio frame started at, delta times are relative to it
+		uint64_t m_FrameStartCycle{ 0 };
+		// Mixed output the blip buffer last got a delta for, PULSE_MIX_TABLE + TND_MIX_TABLE
+		int32_t m_Amplitude{ 0 };
+
+		double m_SampleRateRatio{ 1.0 };
+		double m_AppliedSampleRateRatio{ 1.0 };
+
+		BlipBuffer m_Blip;
+		// Only with oversampling, the blip buffer's samples of a frame and what they decimate to
+		std::unique_ptr<FIRDecimator> m_pDecimator{ nullptr };
+		std::vector<int16_t> m_Oversampled{ };
+		std::vector<int16_t> m_Decimated{ };
+
+		bool m_IsCapturingRaw{ false };
+		// First cycle that isn't in m_RawOutput yet
+		uint64_t m_RawCycle{ 0 };
+		// The current audio frame's output so far and the last complete frame's
+		std::vector<int16_t> m_RawOutput{ };
+		std::vector<int16_t> m_RawFrame{ };
+
+		// Per cycle reference only, the timers as counters that reload at 0, the channels' nextClock is not used
+		struct ReferenceTimers final
+		{
+			std::array<uint16_t, 2> pulse{ };
+			uint16_t triangle{ 0 };
+			uint16_t noise{ 0 };
+			uint16_t dmc{ 0 };
+		};
+		bool m_IsPerCycleReference{ false };
+		ReferenceTimers m_ReferenceTimers{ };
+
+		// Return uint64_t cycle of the first timer event that can change something
+		[[nodiscard]] uint64_t NextClock() const noexcept;
+		// Param uint64_t cycle of the event, runs every unit that has something to do at that cycle
+		void Clock(uint64_t cycle) noexcept;
+		// Brings the timers of idle channels to the current cycle, before anything can wake them up
+		void SkipIdleChannels() noexcept;
+		// Runs the current cycle of the per cycle reference, every counter ticks
+		void ClockReference() noexcept;
+
+		void ClockFrameCounter() noexcept;
+		void ResetFrameCounter(uint64_t cycle) noexcept;
+		void ClockQuarterFrame() noexcept;
+		void ClockHalfFrame() noexcept;
+
+		void ClockDMC() noexcept;
+		// Loads the next byte of the sample into the buffer when it is empty
+		void FetchDMCSample() noexcept;
+		void RestartDMC() noexcept;
+
+		// Adds a delta to the blip buffer when the mixed output changed
+		void UpdateOutput() noexcept;
+		// Repeats the current output for every cycle up to the current one
+		void CaptureRawOutput() noexcept;
+	};
+}
+
+#endif
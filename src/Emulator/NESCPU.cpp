@@ -3,8 +3,9 @@
 #include <iostream>
 namespace NesEm
 {
-	CPU::CPU(PPU& ppu, Cartridge& cart):
+	CPU::CPU(PPU& ppu, APU& apu, Cartridge& cart):
 	m_PPU{ ppu },
+	m_APU{ apu },
 	m_Cartridge{ cart },
 
 	m_Memory{  },
@@ -36,16 +37,58 @@ namespace NesEm
 	{
 		//Wait until clock is available again to execute the next instruction
 		if (m_CurrCycles == 0)
+		{
+			BeginNext();
+		}
+
+		--m_CurrCycles;
+		++m_TotalCycles;
+	}
+
+	void CPU::RunUntil(uint64_t cycle) noexcept
+	{
+		while (m_TotalCycles < cycle && m_TotalCycles < m_APUSyncCycle)
+		{
+			if (m_CurrCycles == 0)
+			{
+				BeginNext();
+			}
+
+			// Nothing happens during the remaining cycles of an instruction, skip them at once
+			m_TotalCycles += m_CurrCycles;
+			m_CurrCycles = 0;
+		}
+	}
+
+	void CPU::BeginNext() noexcept
+	{
+		if (m_OAMDMAPending)
+		{
+			// The CPU is halted while the DMA unit copies the page, the copy itself already happened on the $4014 write
+			m_OAMDMAPending = false;
+			m_CurrCycles = static_cast<uint16_t>(OAM_DMA_CYCLES + (m_TotalCycles & 1));
+		}
+		else if (m_NMIPending)
+		{
+			m_NMIPending = false;
+			NMI();
+		}
+		else if (!IsFlagSet(StatusFlags::I) && m_APU.IsIRQAsserted())
+		{
+			// The line is level triggered, it keeps firing until the handler acknowledges it at the APU
+			IRQ();
+		}
+		else
 		{
 			// Get correct code from table & increase program counter
 			uint8_t const opcodeID{ Read() };
 
+#if NES_EM_LOG_CPU_INSTRUCTIONS
 			SDL_Log("%d", int(opcodeID));
+#endif
 
 			// Update cycles based on instruction from the table
 			m_CurrCycles = m_OpcodeHandler.ExecuteOpcode(opcodeID, (*this));
 		}
-
-		--m_CurrCycles;
 	}
 }
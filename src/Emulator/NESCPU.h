@@ -6,6 +6,8 @@
 #include "NESMemory.h"
 #include "NESCartridge.h"
 #include "NESPPU.h"
+#include "NESAPU.h"
+#include "NESController.h"
 #include "OpcodeHandler.h"
 
 /* Various sources used during development of the CPU of our emulator: 
@@ -20,11 +22,25 @@ namespace NesEm
 	class CPU final
 	{
 	public:
-		CPU(PPU& ppu, Cartridge& cart);
+		CPU(PPU& ppu, APU& apu, Cartridge& cart);
 		~CPU() = default;
 
 		void Clock() noexcept;
 
+		// Param uint64_t CPU cycle to run up to
+		// Runs whole instructions until that cycle or the APU's next sync cycle is reached, the last one may end past it
+		// Accessing PPU / APU registers catches that unit up first, so they only have to be synced at their own events
+		void RunUntil(uint64_t cycle) noexcept;
+
+		// Reads the APU's next IRQ deadline (APU::NextSyncCPUCycle) again, call after catching the APU up
+		// APU register writes do it themselves, they can bring the deadline forward while a RunUntil is in progress
+		void UpdateAPUSync() noexcept { m_APUSyncCycle = m_APU.NextSyncCPUCycle(); }
+		// Return uint64_t cycle the APU has to be caught up at, so its IRQ is seen before the next instruction
+		[[nodiscard]] uint64_t APUSyncCycle() const noexcept { return m_APUSyncCycle; }
+
+		// Return uint64_t cycles the CPU has been clocked
+		[[nodiscard]] uint64_t TotalCycles() const noexcept { return m_TotalCycles; }
+
 		// Runs "Async" and can interupt the CPU at any point in time (will finish the current instruction 1st)
 		void Reset() noexcept
 		{
@@ -43,6 +59,23 @@ namespace NesEm
 			m_CurrCycles = 8;
 		}
 
+		// Non maskable interrupt line (PPU vblank), handled before the next instruction is fetched
+		void RequestNMI() noexcept
+		{
+			m_NMIPending = true;
+		}
+
+		// Param uint8_t controller port (0 or 1)
+		// Param uint8_t held buttons, see Controller::Button, picked up the next time the game latches the controllers
+		void SetControllerButtons(uint8_t port, uint8_t buttons) noexcept
+		{
+			assert(port < m_Controllers.size());
+			m_Controllers[port].SetButtons(buttons);
+		}
+
+		// Return std::span the 2KB internal RAM
+		[[nodiscard]] std::span<uint8_t const> RAM() const noexcept { return { m_Memory.Data(), m_Memory.Size() }; }
+
 		CPU(CPU const&) = delete;
 		CPU(CPU&&) = delete;
 		CPU& operator=(CPU const&) = delete;
@@ -62,9 +95,27 @@ namespace NesEm
 		static constexpr uint16_t ADDRESSABLE_PPU_RANGE_START{ 0x2000 };
 		static constexpr uint16_t ADDRESSABLE_PPU_RANGE_END{ 0x3FFF };
 
+		// https://www.nesdev.org/wiki/PPU_registers#OAMDMA
+		static constexpr uint16_t OAM_DMA_ADDRESS{ 0x4014 };
+		// 1 halt cycle + 256 get / put pairs, 1 extra alignment cycle when the DMA starts on an odd CPU cycle
+		static constexpr uint16_t OAM_DMA_CYCLES{ 513 };
+
+		// https://www.nesdev.org/wiki/APU_registers
+		static constexpr uint16_t APU_RANGE_START{ 0x4000 };
+		static constexpr uint16_t APU_RANGE_END{ 0x4013 };
+		static constexpr uint16_t APU_STATUS_ADDRESS{ 0x4015 };
+
+		// https://www.nesdev.org/wiki/Standard_controller
+		// Writes to $4017 go to the APU frame counter, not the controllers
+		static constexpr uint16_t CONTROLLER_1_ADDRESS{ 0x4016 };
+		static constexpr uint16_t CONTROLLER_2_ADDRESS{ 0x4017 };
+		// Upper bits of a controller read are open bus, usually the high byte of the address
+		static constexpr uint8_t CONTROLLER_OPEN_BUS{ 0x40 };
+
 #pragma endregion
 
 		PPU& m_PPU;
+		APU& m_APU;
 		Cartridge& m_Cartridge;
 
 		// Opcode handler should be friended since we do need access to some private variables
@@ -75,6 +126,9 @@ namespace NesEm
 		//2KB RAM
 		NESMemory<2048> m_Memory{ };
 
+		// Reading shifts the controller, which is part of a const bus read
+		mutable std::array<Controller, 2> m_Controllers{ };
+
 		uint8_t m_Accumulator{ 0 };
 		uint8_t m_XRegister{ 0 };
 		uint8_t m_YRegister{ 0 };
@@ -86,7 +140,19 @@ namespace NesEm
 		uint8_t m_StatusRegister{ 0 };
 
 		//Counter of cycles to be executed before next instruction may be executed
-		uint8_t m_CurrCycles{ 0 };
+		//Wide enough to hold an OAM DMA stall
+		uint16_t m_CurrCycles{ 0 };
+		//Total amount of cycles the CPU has been clocked, the time PPU catch up and OAM DMA alignment are based on
+		uint64_t m_TotalCycles{ 0 };
+
+		bool m_NMIPending{ false };
+		// APU IRQ deadline RunUntil also stops at, like the PPU's NMI a write can make it come sooner
+		uint64_t m_APUSyncCycle{ UINT64_MAX };
+
+		// Starts whatever comes next once the previous instruction finished: DMA stall, NMI or the next instruction
+		void BeginNext() noexcept;
+		//Set by a $4014 write, the stall is charged once the current instruction has finished
+		bool m_OAMDMAPending{ false };
 
 		enum class StatusFlags : uint8_t
 		{
@@ -194,8 +260,19 @@ namespace NesEm
 			else if (address >= ADDRESSABLE_PPU_RANGE_START && address <= ADDRESSABLE_PPU_RANGE_END)
 			{
 				// Read from PPU registers
+				m_PPU.CatchUp(m_TotalCycles);
 				return m_PPU.Read(address);
 			}
+			else if (address == APU_STATUS_ADDRESS)
+			{
+				// Reading acknowledges the frame interrupt
+				m_APU.CatchUp(m_TotalCycles);
+				return m_APU.ReadStatus();
+			}
+			else if (address == CONTROLLER_1_ADDRESS || address == CONTROLLER_2_ADDRESS)
+			{
+				return CONTROLLER_OPEN_BUS | m_Controllers[address - CONTROLLER_1_ADDRESS].Read();
+			}
 
 			// Mapper in cartridge will handle mirroring and adjusting the address if necessary
 			return m_Cartridge.Read(address);
@@ -213,7 +290,38 @@ namespace NesEm
 			else if (address >= ADDRESSABLE_PPU_RANGE_START && address <= ADDRESSABLE_PPU_RANGE_END)
 			{
 				// Write to PPU registers
+				m_PPU.CatchUp(m_TotalCycles);
 				m_PPU.Write(address, value);
+
+				// Enabling NMI during vblank triggers it right away
+				if (m_PPU.PollNMI())
+				{
+					m_NMIPending = true;
+				}
+				return;
+			}
+			else if (address == OAM_DMA_ADDRESS)
+			{
+				OAMDMA(value);
+				return;
+			}
+			else if ((address >= APU_RANGE_START && address <= APU_RANGE_END) || address == APU_STATUS_ADDRESS || address == CONTROLLER_2_ADDRESS)
+			{
+				// $4017 is the APU frame counter on writes
+				m_APU.CatchUp(m_TotalCycles);
+				m_APU.Write(address, value);
+
+				// The frame counter ($4017), the DMC IRQ flag ($4010) or starting a sample ($4015) can move the IRQ deadline forward
+				UpdateAPUSync();
+				return;
+			}
+			else if (address == CONTROLLER_1_ADDRESS)
+			{
+				// The strobe line is shared by both ports
+				for (auto& controller : m_Controllers)
+				{
+					controller.Write(value);
+				}
 				return;
 			}
 
@@ -234,14 +342,41 @@ namespace NesEm
 #pragma endregion
 #pragma endregion
 
+		// Param uint8_t high byte of the CPU page to copy ($XX00 - $XXFF)
+		// Copies the whole page into OAM at once instead of 256 separate reads and writes
+		void OAMDMA(uint8_t page) noexcept
+		{
+			m_PPU.CatchUp(m_TotalCycles);
+
+			if (page <= (ADDRESSABLE_RAM_RANGE_END >> 8))
+			{
+				// Internal RAM, pages are mirrored every 2KB
+				m_PPU.WriteOAMDMA(std::span<uint8_t const, 256>{ m_Memory.Data() + ((page << 8) & 0x07FF), 256 });
+			}
+			else if (uint8_t const* pPRG{ m_Cartridge.GetPRGPage(page) }; pPRG)
+			{
+				m_PPU.WriteOAMDMA(std::span<uint8_t const, 256>{ pPRG, 256 });
+			}
+			else
+			{
+				// Registers or unmapped memory, go through the bus
+				std::array<uint8_t, 256> buffer{ };
+				for (uint16_t offset{ 0 }; offset < buffer.size(); ++offset)
+				{
+					buffer[offset] = Read(static_cast<uint16_t>((page << 8) | offset));
+				}
+				m_PPU.WriteOAMDMA(buffer);
+			}
+
+			m_OAMDMAPending = true;
+		}
+
 		// Runs "Async" and can interupt the CPU at any point in time (will finish the current instruction 1st)
 		void IRQ() noexcept
 		{
 			// https://www.nesdev.org/wiki/CPU_interrupts
-			if (not IsFlagSet(StatusFlags::I))
-				return;
-
-			Push((m_ProgramCounter << 8) & 0x00FF);
+			// Masked interrupts are filtered out by the caller, the line stays asserted until they are enabled again
+			Push((m_ProgramCounter >> 8) & 0x00FF);
 			Push(m_ProgramCounter & 0x00FF);
 
 			ClearFlag(StatusFlags::B);
@@ -249,6 +384,8 @@ namespace NesEm
 			SetFlag(StatusFlags::U);
 
 			Push(m_StatusRegister);
+			// Keeps the still asserted line from interrupting the handler
+			SetFlag(StatusFlags::I);
 
 			// LL | HH
 			m_ProgramCounter = static_cast<uint16_t>(Read(INTERRUPT_VECTOR) | (Read(INTERRUPT_VECTOR + 1) << 8));
@@ -258,7 +395,7 @@ namespace NesEm
 
 		void NMI() noexcept
 		{
-			Push((m_ProgramCounter << 8) & 0x00FF);
+			Push((m_ProgramCounter >> 8) & 0x00FF);
 			Push(m_ProgramCounter & 0x00FF);
 
 			ClearFlag(StatusFlags::B);
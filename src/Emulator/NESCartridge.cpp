@@ -106,9 +106,18 @@ namespace  NesEm
 			throw std::runtime_error("Could not open file");
 		}
 
+		// Flags 6
+		// Bit 0: 0 = horizontal (vertical arrangement), 1 = vertical (horizontal arrangement)
+		// Bit 3: alternative nametable layout (four screen)
+		Mirroring mirroring{ (m_Flags6 & 0x01) ? Mirroring::Vertical : Mirroring::Horizontal };
+		if (m_Flags6 & 0x08)
+		{
+			mirroring = Mirroring::FourScreen;
+		}
+
 		assert(m_MapperID == 0 && "Currently only supporting NROM mapper");
 		// Load the correct mapper and store it
-		m_pMapper = std::make_shared<NROMMapper>(m_CHRBanks, m_PRGBanks);
+		m_pMapper = std::make_shared<NROMMapper>(m_CHRBanks, m_PRGBanks, mirroring);
 
 		SDL_Log("%s", "Cartridge loaded successfully");
 	}
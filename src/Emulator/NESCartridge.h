@@ -9,6 +9,7 @@
 #include <vector>
 #include <filesystem>
 #include <fstream>
+#include <span>
 
 #include "SDL3/SDL.h"
 
@@ -32,7 +33,7 @@ namespace NesEm
 
 		~Cartridge() = default;
 
-		// Read from cartridge
+		// Read from cartridge (CPU side)
 		[[nodiscard]] uint8_t Read(uint16_t address) const noexcept
 		{
 			// use the mapper to "redirect" our address and read the value
@@ -42,15 +43,15 @@ namespace NesEm
 
 			if (isPRG)
 			{
-				assert(mappedAddr <= m_PRG.size());
+				assert(mappedAddr < m_PRG.size());
 				return m_PRG[mappedAddr];
 			}
 
-			assert(mappedAddr <= m_CHR.size());
-			return m_CHR[mappedAddr];
+			// Nothing is mapped here, CHR is only reachable by the PPU
+			return 0;
 		}
 
-		// Write to cartridge
+		// Write to cartridge (CPU side)
 		void Write(uint16_t address, uint8_t value) noexcept
 		{
 			// use the mapper to "redirect" our address and read the value
@@ -60,14 +61,51 @@ namespace NesEm
 
 			if (isPRG)
 			{
-				assert(mappedAddr <= m_PRG.size());
+				assert(mappedAddr < m_PRG.size());
 				m_PRG[mappedAddr] = value;
 			}
+		}
+
+		// Param uint8_t 256 byte CPU page ($xx00 - $xxFF)
+		// Return uint8_t const* the PRG memory backing the whole page, nullptr when the page is not PRG mapped
+		// Mappers switch banks on at least 256 byte boundaries, so a mapped page is always contiguous
+		[[nodiscard]] uint8_t const* GetPRGPage(uint8_t page) const noexcept
+		{
+			uint16_t mappedAddr{ static_cast<uint16_t>(page << 8) };
+			if (!m_pMapper->MapAddress(mappedAddr))
+			{
+				return nullptr;
+			}
+
+			assert(mappedAddr + 0x100u <= m_PRG.size());
+			return m_PRG.data() + mappedAddr;
+		}
 
-			assert(mappedAddr <= m_CHR.size());
-			m_CHR[mappedAddr] = value;
+		// Param uint8_t 1KB page of the PPU pattern tables (0 - 7 -> $0000 - $1FFF)
+		// Return uint8_t* the CHR memory currently mapped to that page
+		[[nodiscard]] uint8_t* GetCHRPage(uint8_t page) noexcept
+		{
+			return m_CHR.data() + GetCHROffset(page);
+		}
+
+		// Param uint8_t 1KB page of the PPU pattern tables (0 - 7 -> $0000 - $1FFF)
+		// Return uint32_t offset in CHR memory currently mapped to that page
+		[[nodiscard]] uint32_t GetCHROffset(uint8_t page) const noexcept
+		{
+			uint32_t const offset{ m_pMapper->MapCHRPage(page) };
+			assert(offset + 0x400 <= m_CHR.size());
+			return offset;
 		}
 
+		// Return std::span all CHR memory, for anything that keeps its own copy or maps offsets itself
+		[[nodiscard]] std::span<uint8_t> GetCHRMemory() noexcept { return m_CHR; }
+
+		// Return bool is the CHR memory writable (the board uses CHR-RAM instead of CHR-ROM)
+		[[nodiscard]] bool HasCHRRAM() const noexcept { return m_CHRBanks == 0; }
+
+		// Return Mirroring the nametable layout the board currently uses
+		[[nodiscard]] Mirroring GetMirroring() const noexcept { return m_pMapper->GetMirroring(); }
+
 		Cartridge(Cartridge const&) = delete;
 		Cartridge(Cartridge&&) = delete;
 		Cartridge& operator=(Cartridge const&) = delete;
@@ -0,0 +1,75 @@
+#ifndef NES_EMULATOR_CONTROLLER
+#define NES_EMULATOR_CONTROLLER
+
+#include "emulator_pch.h"
+
+/* Various sources used during development of the controller of our emulator:
+ * https://www.nesdev.org/wiki/Standard_controller
+ */
+
+namespace NesEm
+{
+	// Standard controller, connected to $4016 (port 1) and $4017 (port 2)
+	// Writing bit 0 of $4016 latches the buttons of both controllers, every read after that shifts out the next button
+	class Controller final
+	{
+	public:
+		// Bit of each button in the state, in the order they are read out
+		enum class Button : uint8_t
+		{
+			A = (1 << 0),
+			B = (1 << 1),
+			Select = (1 << 2),
+			Start = (1 << 3),
+			Up = (1 << 4),
+			Down = (1 << 5),
+			Left = (1 << 6),
+			Right = (1 << 7)
+		};
+
+		Controller() = default;
+		~Controller() = default;
+
+		Controller(Controller const&) = default;
+		Controller(Controller&&) = default;
+		Controller& operator=(Controller const&) = default;
+		Controller& operator=(Controller&&) = default;
+
+		// Param uint8_t held buttons, a Button bit each
+		void SetButtons(uint8_t buttons) noexcept
+		{
+			m_Buttons = buttons;
+		}
+
+		// Param uint8_t value written to $4016, only the strobe bit (0) matters
+		void Write(uint8_t value) noexcept
+		{
+			m_Strobe = value & 0x01;
+			if (m_Strobe)
+			{
+				m_ShiftRegister = m_Buttons;
+			}
+		}
+
+		// Return uint8_t next button in bit 0, 1 once all 8 were read (official controllers)
+		[[nodiscard]] uint8_t Read() noexcept
+		{
+			// While the strobe is high the register keeps reloading, so it only ever reports A
+			if (m_Strobe)
+			{
+				return m_Buttons & 0x01;
+			}
+
+			uint8_t const bit{ static_cast<uint8_t>(m_ShiftRegister & 0x01) };
+			m_ShiftRegister = static_cast<uint8_t>((m_ShiftRegister >> 1) | 0x80);
+			return bit;
+		}
+
+	private:
+		uint8_t m_Buttons{ 0 };
+		uint8_t m_ShiftRegister{ 0 };
+		bool m_Strobe{ false };
+	};
+}
+
+#endif
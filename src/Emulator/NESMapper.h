@@ -9,13 +9,25 @@
 
 namespace NesEm
 {
+	// How the 4 nametable slots of the PPU ($2000, $2400, $2800, $2C00) are backed by CIRAM
+	// https://www.nesdev.org/wiki/Mirroring#Nametable_Mirroring
+	enum class Mirroring : uint8_t
+	{
+		Horizontal, // $2000 = $2400, $2800 = $2C00
+		Vertical, // $2000 = $2800, $2400 = $2C00
+		SingleScreenLow, // All slots use the first table
+		SingleScreenHigh, // All slots use the second table
+		FourScreen // Every slot has its own table (extra VRAM on the cartridge)
+	};
+
 	// Mapper base class, all implemented mappers will inherit from this
 	class Mapper
 	{
 	public:
-		Mapper(uint8_t chrBanks, uint8_t prgBanks):
+		Mapper(uint8_t chrBanks, uint8_t prgBanks, Mirroring mirroring):
 		m_CHRBanks{ chrBanks },
-		m_PRGBanks{ prgBanks } { }
+		m_PRGBanks{ prgBanks },
+		m_Mirroring{ mirroring } { }
 
 		virtual ~Mapper() = default; 
 
@@ -23,6 +35,13 @@ namespace NesEm
 		// Return bool is the address in the PRG bank? 
 		[[nodiscard]] virtual bool MapAddress(uint16_t& address) const noexcept = 0;
 
+		// Param uint8_t 1KB page of the PPU pattern tables (0 - 7 -> $0000 - $1FFF)
+		// Return uint32_t offset in CHR memory that page is backed by
+		[[nodiscard]] virtual uint32_t MapCHRPage(uint8_t page) const noexcept = 0;
+
+		// Return Mirroring current nametable layout, mappers that control mirroring can change this at runtime
+		[[nodiscard]] virtual Mirroring GetMirroring() const noexcept { return m_Mirroring; }
+
 		Mapper(Mapper const&) = delete;
 		Mapper(Mapper&&) = delete;
 		Mapper& operator=(Mapper const&) = delete;
@@ -36,6 +55,9 @@ namespace NesEm
 		// Number of PRG banks
 		uint8_t m_PRGBanks{ };
 
+		// Mirroring from the iNES header
+		Mirroring m_Mirroring{ };
+
 	private:
 	};
 }
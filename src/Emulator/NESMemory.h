@@ -31,6 +31,11 @@ namespace NesEm
 			m_RAM[address] = value;
 		}
 
+		// Raw access for anything that maps or copies whole pages at once
+		[[nodiscard]] inline uint8_t* Data() noexcept { return m_RAM.data(); }
+		[[nodiscard]] inline uint8_t const* Data() const noexcept { return m_RAM.data(); }
+		[[nodiscard]] static constexpr std::size_t Size() noexcept { return RAM_SIZE; }
+
 	private:
 		std::array<uint8_t, RAM_SIZE> m_RAM{  };
 	};
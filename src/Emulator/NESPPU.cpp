@@ -1,13 +1,214 @@
 #include "NESPPU.h"
+#include "NESPPURenderWorker.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace NesEm
 {
+	PPU::PPU(Cartridge& cart):
+		m_Cartridge{ cart }
+	{
+		if constexpr (Config::DEFERRED_RENDERING)
+		{
+			// Started first so the initial page mapping below is part of the log it replays
+			m_pRenderWorker = std::make_unique<PPURenderWorker>(m_RenderLog, m_Cartridge);
+		}
+
+		MapPatternTables();
+		SetMirroring(m_Cartridge.GetMirroring());
+	}
+
+	PPU::~PPU()
+	{
+		// Joins the worker while the log it reads from is still alive
+		m_pRenderWorker.reset();
+	}
+
+	std::array<uint8_t, 4> PPU::NametableLayout(Mirroring mirroring) noexcept
+	{
+		switch (mirroring)
+		{
+		case Mirroring::Horizontal:			return { 0, 0, 1, 1 };
+		case Mirroring::Vertical:			return { 0, 1, 0, 1 };
+		case Mirroring::SingleScreenLow:	return { 0, 0, 0, 0 };
+		case Mirroring::SingleScreenHigh:	return { 1, 1, 1, 1 };
+		case Mirroring::FourScreen:			return { 0, 1, 2, 3 };
+		default: return { };
+		}
+	}
+
+	void PPU::SetMirroring(Mirroring mirroring) noexcept
+	{
+		FlushPPUDataBatch();
+
+		std::array<uint8_t, 4> const tables{ NametableLayout(mirroring) };
+		for (uint8_t slot{ 0 }; slot < tables.size(); ++slot)
+		{
+			uint8_t* const pTable{ m_Nametables.Data() + tables[slot] * PAGE_SIZE };
+			MarkDirty(m_PageTable[NAMETABLE_PAGE + slot] != pTable);
+			m_PageTable[NAMETABLE_PAGE + slot] = pTable;
+		}
+
+		Record(RenderCommand::Type::Mirroring, 0, static_cast<uint8_t>(mirroring));
+	}
+
+	void PPU::MapPatternTables() noexcept
+	{
+		FlushPPUDataBatch();
+
+		for (uint8_t page{ 0 }; page < NAMETABLE_PAGE; ++page)
+		{
+			uint8_t* const pPage{ m_Cartridge.GetCHRPage(page) };
+			MarkDirty(m_PageTable[page] != pPage);
+			m_PageTable[page] = pPage;
+
+			Record(RenderCommand::Type::CHRPage, static_cast<uint16_t>(m_Cartridge.GetCHROffset(page) / PAGE_SIZE), page);
+		}
+	}
+
+	void PPU::WriteOAMDMA(std::span<uint8_t const, 256> page) noexcept
+	{
+		// OAMADDR is usually 0 so this is a single copy, otherwise the copy wraps around the end of OAM
+		// OAMADDR itself ends up where it started after 256 increments
+		uint8_t* const pOAM{ m_OAM.Data() };
+		std::size_t const firstPart{ m_OAM.Size() - m_OAMAddr };
+
+		bool const changed{ std::memcmp(pOAM + m_OAMAddr, page.data(), firstPart) != 0
+			|| std::memcmp(pOAM, page.data() + firstPart, m_OAMAddr) != 0 };
+		MarkDirty(changed);
+
+		std::memcpy(pOAM + m_OAMAddr, page.data(), firstPart);
+		std::memcpy(pOAM, page.data() + firstPart, m_OAMAddr);
+
+		// Games usually DMA every frame, the worker's copy already matches when nothing changed
+		if (changed)
+		{
+			for (uint16_t index{ 0 }; index < m_OAM.Size(); ++index)
+			{
+				Record(RenderCommand::Type::OAM, index, pOAM[index]);
+			}
+		}
+	}
+
+	void PPU::FlushPPUDataBatch() noexcept
+	{
+		if (m_BatchSize == 0)
+		{
+			return;
+		}
+
+		// The batch never crosses a page, one pointer lookup for the whole run
+		uint8_t* const pDestination{ m_PageTable[m_BatchAddr >> 10] + (m_BatchAddr & (PAGE_SIZE - 1)) };
+
+		bool changed{ false };
+		if (m_BatchStep == 1)
+		{
+			assert((m_BatchAddr & (PAGE_SIZE - 1)) + m_BatchSize <= PAGE_SIZE);
+
+			changed = std::memcmp(pDestination, m_BatchData.data(), m_BatchSize) != 0;
+			std::memcpy(pDestination, m_BatchData.data(), m_BatchSize);
+		}
+		else
+		{
+			// Going down a column of tiles
+			assert((m_BatchAddr & (PAGE_SIZE - 1)) + (m_BatchSize - 1) * m_BatchStep < PAGE_SIZE);
+
+			for (uint16_t i{ 0 }; i < m_BatchSize; ++i)
+			{
+				uint8_t& data{ pDestination[i * m_BatchStep] };
+				changed |= data != m_BatchData[i];
+				data = m_BatchData[i];
+			}
+		}
+		MarkDirty(changed);
+
+		// The worker's copy already matches when nothing changed
+		if (changed)
+		{
+			for (uint16_t i{ 0 }; i < m_BatchSize; ++i)
+			{
+				Record(RenderCommand::Type::VRAM, static_cast<uint16_t>(m_BatchAddr + i * m_BatchStep), m_BatchData[i]);
+			}
+		}
+
+		m_BatchSize = 0;
+	}
+
 	void PPU::Clock() noexcept
 	{
 		// https://www.nesdev.org/wiki/PPU_frame_timing
-		//TODO
+		// https://www.nesdev.org/wiki/PPU_rendering
+
+		bool const renderingEnabled{ m_PPUMask.bits.backgroundEnable || m_PPUMask.bits.spriteEnable };
+
+		if (m_CurrScanline < static_cast<int16_t>(Config::SCREEN_HEIGHT))
+		{
+			if (!m_StatusPredicted)
+			{
+				PredictStatusEvents();
+			}
+
+			uint32_t const time{ FrameTime() };
+			if (time == m_Sprite0HitTime)
+			{
+				m_PPUStatus.bits.sprite0HitFlag = 1;
+			}
+			if (time == m_SpriteOverflowTime)
+			{
+				m_PPUStatus.bits.spriteOverflowFlag = 1;
+			}
+
+			if (m_CurrScanline == PRE_RENDER_SCANLINE)
+			{
+				if (m_CurrCycle == 1)
+				{
+					// Flags are cleared at the start of the pre-render line
+					m_PPUStatus.bits.vblankFlag = 0;
+					m_PPUStatus.bits.sprite0HitFlag = 0;
+					m_PPUStatus.bits.spriteOverflowFlag = 0;
+				}
+
+				// Vertical scroll bits are reloaded during dots 280 - 304
+				if (renderingEnabled && m_CurrCycle >= 280 && m_CurrCycle <= 304)
+				{
+					// v: GHIA.BC DEF..... <- t: GHIA.BC DEF.....
+					m_VRAMAddr.bits.coarseY = m_TempVRAMAddr.bits.coarseY;
+					m_VRAMAddr.bits.nametableY = m_TempVRAMAddr.bits.nametableY;
+					m_VRAMAddr.bits.fineY = m_TempVRAMAddr.bits.fineY;
+				}
+			}
+			else if (m_CurrCycle == 1)
+			{
+				// Visible scanline, fetch and compose it as a whole from the state at its start
+				RenderScanline();
+			}
+
+			if (renderingEnabled)
+			{
+				if (m_CurrCycle == 256)
+				{
+					IncrementY(m_VRAMAddr);
+				}
+				else if (m_CurrCycle == 257)
+				{
+					// v: ....A.. ...BCDEF <- t: ....A.. ...BCDEF
+					m_VRAMAddr.bits.coarseX = m_TempVRAMAddr.bits.coarseX;
+					m_VRAMAddr.bits.nametableX = m_TempVRAMAddr.bits.nametableX;
+				}
+			}
+		}
+		else if (m_CurrScanline == VBLANK_SCANLINE && m_CurrCycle == 1)
+		{
+			m_PPUStatus.bits.vblankFlag = 1;
+			if (m_PPUCtrl.bits.nmiEnable)
+			{
+				m_NMIRequested = true;
+			}
+		}
 
 		++m_CurrCycle;
+		++m_TotalDots;
 
 		switch (Config::MODE)
 		{
@@ -20,10 +221,10 @@ namespace NesEm
 			{
 				m_CurrCycle = 0;
 				++m_CurrScanline;
-				if (m_CurrScanline >= 312)
+				if (m_CurrScanline >= 311)
 				{
-					m_CurrScanline = -1;
-					m_FrameComplete = true;
+					m_CurrScanline = PRE_RENDER_SCANLINE;
+					CompleteFrame();
 				}
 			}
 		}break;
@@ -38,8 +239,8 @@ namespace NesEm
 				++m_CurrScanline;
 				if (m_CurrScanline >= 261)
 				{
-					m_CurrScanline = -1;
-					m_FrameComplete = true;
+					m_CurrScanline = PRE_RENDER_SCANLINE;
+					CompleteFrame();
 				}
 			}
 
@@ -50,8 +251,453 @@ namespace NesEm
 		}
 	}
 
-	void PPU::Render() const noexcept
+	void PPU::IncrementX(LOOPY_REG& address) noexcept
+	{
+		// https://www.nesdev.org/wiki/PPU_scrolling#Coarse_X_increment
+		if (address.bits.coarseX == 31)
+		{
+			address.bits.coarseX = 0;
+			address.bits.nametableX = ~address.bits.nametableX;
+		}
+		else
+		{
+			++address.bits.coarseX;
+		}
+	}
+
+	void PPU::IncrementY(LOOPY_REG& address) noexcept
+	{
+		// https://www.nesdev.org/wiki/PPU_scrolling#Y_increment
+		if (address.bits.fineY < 7)
+		{
+			++address.bits.fineY;
+			return;
+		}
+
+		address.bits.fineY = 0;
+
+		// Row 29 is the last row of tiles in a nametable, rows 30 and 31 are attribute data and wrap without switching nametables
+		if (address.bits.coarseY == 29)
+		{
+			address.bits.coarseY = 0;
+			address.bits.nametableY = ~address.bits.nametableY;
+		}
+		else if (address.bits.coarseY == 31)
+		{
+			address.bits.coarseY = 0;
+		}
+		else
+		{
+			++address.bits.coarseY;
+		}
+	}
+
+	void PPU::RenderScanline() noexcept
+	{
+		assert(m_CurrScanline >= 0 && m_CurrScanline < static_cast<int16_t>(Config::SCREEN_HEIGHT));
+
+		// Uploads made during vblank have to land before they are fetched
+		FlushPPUDataBatch();
+
+		// When nothing that affects the picture changed, the framebuffer still holds the exact same pixels
+		// Sprite 0 hit and overflow are scheduled separately, so there is nothing else to do for this scanline
+		if (!m_PixelOutput || (!m_DirtyThisFrame && !m_DirtyLastFrame))
+		{
+			return;
+		}
+
+		m_FrameChanged = true;
+
+		if constexpr (Config::DEFERRED_RENDERING)
+		{
+			// The worker composes it from the state the log has replayed up to this point
+			Record(RenderCommand::Type::Scanline, m_VRAMAddr.raw, static_cast<uint8_t>(m_FineX | (SubcarrierPhase(m_TotalDots) << 3)));
+		}
+		else
+		{
+			SpriteLine sprites{ };
+			if (m_PPUMask.bits.spriteEnable)
+			{
+				bool overflow{ false };
+				static_cast<void>(EvaluateSprites(m_PageTable, m_OAM.Data(), m_PPUCtrl, m_CurrScanline, false, sprites, overflow));
+			}
+
+			BackgroundLine background{ };
+			if (m_PPUMask.bits.backgroundEnable)
+			{
+				FetchBackground(m_PageTable, m_PPUCtrl, m_VRAMAddr, background);
+			}
+
+			ComposeScanline(background, sprites, m_PPUMask, m_FineX, m_Pallete.Data(), &m_FrameBuffer[m_CurrScanline * Config::SCREEN_WIDTH]);
+			m_LineEmphasis[m_CurrScanline] = m_PPUMask.raw >> 5;
+			m_LinePhases[m_CurrScanline] = SubcarrierPhase(m_TotalDots);
+		}
+	}
+
+	void PPU::PredictStatusEvents() noexcept
 	{
-		//TODO
+		// Pending uploads are part of what is fetched, flushing marks the state dirty so only then is the prediction valid
+		FlushPPUDataBatch();
+		m_StatusPredicted = true;
+
+		uint32_t const now{ FrameTime() };
+
+		// A hit later on the current scanline was decided at its start (dot 1), like the scanline's pixels
+		bool const hitOnThisLine{ m_Sprite0HitTime != NO_EVENT && m_Sprite0HitTime > now
+			&& m_Sprite0HitTime / DOTS_PER_SCANLINE == now / DOTS_PER_SCANLINE };
+		if (!hitOnThisLine)
+		{
+			m_Sprite0HitTime = NO_EVENT;
+		}
+		m_SpriteOverflowTime = NO_EVENT;
+
+		// The flags are cleared at the start of the pre-render line, before that they are still set from the previous frame
+		bool const inFrame{ m_CurrScanline >= 0 };
+		bool findHit{ !hitOnThisLine && !(inFrame && m_PPUStatus.bits.sprite0HitFlag)
+			&& m_PPUMask.bits.backgroundEnable && m_PPUMask.bits.spriteEnable };
+		bool findOverflow{ !(inFrame && m_PPUStatus.bits.spriteOverflowFlag) && m_PPUMask.bits.spriteEnable };
+
+		// Follow v the way Clock moves it, starting with the next scanline that has not been fetched yet
+		LOOPY_REG address{ m_VRAMAddr };
+		int16_t scanline{ m_CurrScanline };
+		if (scanline < 0 || m_CurrCycle > 1)
+		{
+			if (m_CurrCycle <= 256)
+			{
+				IncrementY(address);
+			}
+			if (m_CurrCycle <= 257)
+			{
+				address.bits.coarseX = m_TempVRAMAddr.bits.coarseX;
+				address.bits.nametableX = m_TempVRAMAddr.bits.nametableX;
+			}
+			if (scanline == PRE_RENDER_SCANLINE && m_CurrCycle <= 304)
+			{
+				address.bits.coarseY = m_TempVRAMAddr.bits.coarseY;
+				address.bits.nametableY = m_TempVRAMAddr.bits.nametableY;
+				address.bits.fineY = m_TempVRAMAddr.bits.fineY;
+			}
+			++scanline;
+		}
+
+		for (; (findHit || findOverflow) && scanline < static_cast<int16_t>(Config::SCREEN_HEIGHT); ++scanline)
+		{
+			SpriteLine sprites{ };
+			bool overflow{ false };
+			int const sprite0X{ EvaluateSprites(m_PageTable, m_OAM.Data(), m_PPUCtrl, scanline, true, sprites, overflow) };
+
+			// Set when the scanline is evaluated
+			if (findOverflow && overflow)
+			{
+				m_SpriteOverflowTime = FrameTime(scanline, 1);
+				findOverflow = false;
+			}
+
+			if (findHit && sprite0X >= 0)
+			{
+				BackgroundLine background{ };
+				FetchBackground(m_PageTable, m_PPUCtrl, address, background);
+
+				if (int const x{ FindSprite0Hit(background, sprites, m_PPUMask, m_FineX, sprite0X) }; x >= 0)
+				{
+					// Pixel x is output at dot x + 1
+					m_Sprite0HitTime = FrameTime(scanline, static_cast<uint16_t>(x + 1));
+					findHit = false;
+				}
+			}
+
+			IncrementY(address);
+			address.bits.coarseX = m_TempVRAMAddr.bits.coarseX;
+			address.bits.nametableX = m_TempVRAMAddr.bits.nametableX;
+		}
+	}
+
+	int PPU::FindSprite0Hit(BackgroundLine const& background, SpriteLine const& sprites, PPU_MASK_REG mask, uint8_t fineX, int sprite0X) noexcept
+	{
+		// An opaque pixel of sprite 0 overlaps an opaque background pixel
+		// Does not happen in the left column when either of them is clipped, nor at x = 255
+		bool const leftClipped{ !mask.bits.backgroundLeftColEnable || !mask.bits.spriteLeftColEnable };
+		int const start{ (leftClipped && sprite0X < 8) ? 8 : sprite0X };
+		int const end{ std::min(sprite0X + 8, static_cast<int>(Config::SCREEN_WIDTH) - 1) };
+
+		for (int x{ start }; x < end; ++x)
+		{
+			if ((sprites[x] & SPRITE_ZERO) && (background[x + fineX] & 0x03))
+			{
+				return x;
+			}
+		}
+
+		return -1;
+	}
+
+	uint64_t PPU::NextSyncCPUCycle() const noexcept
+	{
+		uint32_t const now{ FrameTime() };
+		uint32_t const vblank{ FrameTime(VBLANK_SCANLINE, 1) };
+		uint32_t const event{ now <= vblank ? vblank : FRAME_DOTS - 1 };
+
+		// Clock call that handles the event, CatchUp(cycle) runs every dot up to cycle * DOTS_PER_CPU_CYCLE
+		uint64_t const eventDot{ m_TotalDots + (event - now) };
+		return (eventDot + Config::DOTS_PER_CPU_CYCLE - 1) / Config::DOTS_PER_CPU_CYCLE;
+	}
+
+	void PPU::FetchBackground(PageTable const& pages, PPU_CTRL_REG ctrl, LOOPY_REG address, BackgroundLine& line) noexcept
+	{
+		// https://www.nesdev.org/wiki/PPU_scrolling#Tile_and_attribute_fetching
+		uint16_t const patternTable{ static_cast<uint16_t>(ctrl.bits.backgroundTileSelect ? 0x1000 : 0x0000) };
+
+		for (uint32_t tile{ 0 }; tile < SCANLINE_TILES; ++tile)
+		{
+			// tile address = 0x2000 | (v & 0x0FFF)
+			uint8_t const tileID{ Fetch(pages, NAMETABLE_ADDRESS | (address.raw & 0x0FFF)) };
+
+			// attribute address = 0x23C0 | (v & 0x0C00) | ((v >> 4) & 0x38) | ((v >> 2) & 0x07)
+			uint8_t const attribute{ Fetch(pages, static_cast<uint16_t>(0x23C0 | (address.raw & 0x0C00) | ((address.raw >> 4) & 0x38) | ((address.raw >> 2) & 0x07))) };
+			// Each attribute byte covers 4x4 tiles, 2 bits per 2x2 quadrant
+			uint8_t const shift{ static_cast<uint8_t>(((address.bits.coarseY & 0x02) << 1) | (address.bits.coarseX & 0x02)) };
+			uint8_t const palette{ static_cast<uint8_t>(((attribute >> shift) & 0x03) << 2) };
+
+			// 16 bytes per tile, low bit plane followed by the high bit plane
+			uint16_t const patternAddr{ static_cast<uint16_t>(patternTable + tileID * 16 + address.bits.fineY) };
+			uint8_t const patternLow{ Fetch(pages, patternAddr) };
+			uint8_t const patternHigh{ Fetch(pages, patternAddr + 8) };
+
+			uint8_t* const pPixels{ &line[tile * 8] };
+			for (uint8_t pixel{ 0 }; pixel < 8; ++pixel)
+			{
+				uint8_t const bit{ static_cast<uint8_t>(7 - pixel) };
+				uint8_t const value{ static_cast<uint8_t>(((patternLow >> bit) & 0x01) | (((patternHigh >> bit) & 0x01) << 1)) };
+				pPixels[pixel] = value ? (palette | value) : 0;
+			}
+
+			IncrementX(address);
+		}
+	}
+
+	int PPU::EvaluateSprites(PageTable const& pages, uint8_t const* pOAM, PPU_CTRL_REG ctrl, int16_t scanline,
+		bool spriteZeroOnly, SpriteLine& line, bool& overflow) noexcept
+	{
+		// https://www.nesdev.org/wiki/PPU_sprite_evaluation
+		int const height{ ctrl.bits.spriteHeight ? 16 : 8 };
+		int sprite0X{ -1 };
+
+		uint8_t spriteCount{ 0 };
+		for (uint8_t sprite{ 0 }; sprite < 64; ++sprite)
+		{
+			uint8_t const* const pSprite{ pOAM + sprite * 4 };
+
+			// Sprite data is delayed by one scanline
+			int row{ scanline - pSprite[0] - 1 };
+			if (row < 0 || row >= height)
+			{
+				continue;
+			}
+
+			// Only 8 sprites fit on a scanline
+			if (spriteCount == 8)
+			{
+				overflow = true;
+				break;
+			}
+			++spriteCount;
+
+			if (spriteZeroOnly && sprite != 0)
+			{
+				continue;
+			}
+
+			uint8_t const tileID{ pSprite[1] };
+			uint8_t const attributes{ pSprite[2] };
+			uint8_t const spriteX{ pSprite[3] };
+
+			if (attributes & 0x80)
+			{
+				// Flip vertically
+				row = height - 1 - row;
+			}
+
+			uint16_t patternAddr{ };
+			if (height == 8)
+			{
+				patternAddr = static_cast<uint16_t>((ctrl.bits.spriteTileSelect ? 0x1000 : 0x0000) + tileID * 16 + row);
+			}
+			else
+			{
+				// 8x16: bit 0 selects the pattern table, the bottom half uses the next tile
+				patternAddr = static_cast<uint16_t>(((tileID & 0x01) ? 0x1000 : 0x0000) + (tileID & 0xFE) * 16 + (row >= 8 ? 16 + row - 8 : row));
+			}
+
+			uint8_t const patternLow{ Fetch(pages, patternAddr) };
+			uint8_t const patternHigh{ Fetch(pages, patternAddr + 8) };
+
+			uint8_t const flags{ static_cast<uint8_t>(SPRITE_PALETTE | ((attributes & 0x03) << 2)
+				| ((attributes & 0x20) ? SPRITE_BEHIND_BACKGROUND : 0)
+				| (sprite == 0 ? SPRITE_ZERO : 0)) };
+
+			for (uint8_t pixel{ 0 }; pixel < 8 && spriteX + pixel < static_cast<int>(Config::SCREEN_WIDTH); ++pixel)
+			{
+				// Flip horizontally
+				uint8_t const bit{ static_cast<uint8_t>((attributes & 0x40) ? pixel : 7 - pixel) };
+				uint8_t const value{ static_cast<uint8_t>(((patternLow >> bit) & 0x01) | (((patternHigh >> bit) & 0x01) << 1)) };
+
+				// Lower OAM index has priority, only fill pixels no earlier sprite covered
+				if (value && !(line[spriteX + pixel] & 0x03))
+				{
+					line[spriteX + pixel] = flags | value;
+				}
+			}
+
+			if (sprite == 0)
+			{
+				sprite0X = spriteX;
+			}
+		}
+
+		return sprite0X;
+	}
+
+	void PPU::ComposeScanline(BackgroundLine const& background, SpriteLine const& sprites, PPU_MASK_REG mask, uint8_t fineX,
+		uint8_t const* pPalette, uint8_t* pLine) noexcept
+	{
+		uint8_t const greyScaleMask{ static_cast<uint8_t>(mask.bits.greyScale ? 0x30 : 0x3F) };
+
+		for (uint32_t x{ 0 }; x < Config::SCREEN_WIDTH; ++x)
+		{
+			uint8_t backgroundPixel{ background[x + fineX] };
+			uint8_t spritePixel{ sprites[x] };
+
+			// Left column clipping
+			if (x < 8)
+			{
+				if (!mask.bits.backgroundLeftColEnable)
+				{
+					backgroundPixel = 0;
+				}
+				if (!mask.bits.spriteLeftColEnable)
+				{
+					spritePixel = 0;
+				}
+			}
+
+			// Transparent background pixels use the backdrop colour
+			uint8_t pixel{ static_cast<uint8_t>((backgroundPixel & 0x03) ? backgroundPixel : 0) };
+
+			// Sprite wins unless it is behind an opaque background pixel
+			if ((spritePixel & 0x03) && (!(spritePixel & SPRITE_BEHIND_BACKGROUND) || !(backgroundPixel & 0x03)))
+			{
+				pixel = spritePixel & (SPRITE_PALETTE | 0x0F);
+			}
+
+			pLine[x] = pPalette[pixel] & greyScaleMask;
+		}
+	}
+
+	void PPU::CompleteFrame() noexcept
+	{
+		// Make sure pending uploads count towards this frame's dirty state
+		FlushPPUDataBatch();
+
+		m_FrameComplete = true;
+
+		++m_FrameCount;
+		Record(RenderCommand::Type::FrameEnd);
+
+		// The scheduled flags were for this frame
+		m_Sprite0HitTime = NO_EVENT;
+		m_SpriteOverflowTime = NO_EVENT;
+		m_StatusPredicted = false;
+
+		if (!m_PixelOutput)
+		{
+			// The framebuffer was not updated, anything dirtied since it was last composed has to be redrawn by the next output frame
+			++m_DroppedFrameCount;
+			m_NewPicture = false;
+			m_FrameChanged = false;
+
+			m_DirtyLastFrame |= m_DirtyThisFrame;
+			m_DirtyThisFrame = false;
+			return;
+		}
+
+		if (!m_FrameChanged)
+		{
+			++m_SkippedFrameCount;
+		}
+
+		// Writes during this frame (usually in vblank) still affect the next frame's picture
+		m_NewPicture = m_FrameChanged;
+		m_FrameChanged = false;
+		if (m_NewPicture)
+		{
+			++m_PictureSequence;
+		}
+
+		m_DirtyLastFrame = m_DirtyThisFrame;
+		m_DirtyThisFrame = false;
+	}
+
+	void PPU::Render(uint32_t* pPixels, int pitch) const noexcept
+	{
+		Render(FrameIndices(), pPixels, pitch);
+	}
+
+	void PPU::Render(std::span<uint8_t const> frameBuffer, uint32_t* pPixels, int pitch) noexcept
+	{
+		assert(pPixels);
+		assert(pitch >= static_cast<int>(Config::SCREEN_WIDTH * sizeof(uint32_t)));
+		assert(frameBuffer.size() >= Config::SCREEN_WIDTH * Config::SCREEN_HEIGHT);
+
+		// Write each row straight into the destination, the pitch may be larger than a row of pixels
+		for (uint32_t y{ 0 }; y < Config::SCREEN_HEIGHT; ++y)
+		{
+			auto* const pRow{ reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(pPixels) + y * pitch) };
+			uint8_t const* const pIndices{ &frameBuffer[y * Config::SCREEN_WIDTH] };
+
+			for (uint32_t x{ 0 }; x < Config::SCREEN_WIDTH; ++x)
+			{
+				pRow[x] = SYSTEM_PALETTE[pIndices[x]];
+			}
+		}
+	}
+
+	std::span<uint8_t const> PPU::FrameIndices() const noexcept
+	{
+		// Only the emulation thread adds to the log, so once the worker caught up it stays idle while we read its output
+		return m_pRenderWorker ? m_pRenderWorker->WaitForFrame(m_FrameCount) : m_FrameBuffer;
+	}
+
+	std::span<uint32_t const> PPU::FramePixels() const noexcept
+	{
+		if (m_FramePixelsSequence != m_PictureSequence)
+		{
+			m_FramePixels.resize(Config::SCREEN_WIDTH * Config::SCREEN_HEIGHT);
+			Render(m_FramePixels.data(), static_cast<int>(Config::SCREEN_WIDTH * sizeof(uint32_t)));
+			m_FramePixelsSequence = m_PictureSequence;
+		}
+
+		return m_FramePixels;
+	}
+
+	std::span<uint8_t const> PPU::FrameEmphasis() const noexcept
+	{
+		if (m_pRenderWorker)
+		{
+			static_cast<void>(m_pRenderWorker->WaitForFrame(m_FrameCount));
+			return m_pRenderWorker->LineEmphasis();
+		}
+
+		return m_LineEmphasis;
+	}
+
+	std::span<uint8_t const> PPU::FramePhases() const noexcept
+	{
+		if (m_pRenderWorker)
+		{
+			static_cast<void>(m_pRenderWorker->WaitForFrame(m_FrameCount));
+			return m_pRenderWorker->LinePhases();
+		}
+
+		return m_LinePhases;
 	}
 }
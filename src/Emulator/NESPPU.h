@@ -4,7 +4,15 @@
 #include "emulator_pch.h"
 
 #include "NESMemory.h"
+#include "NESCartridge.h"
 #include "EmulatorSettings.h"
+#include "SPSCRing.h"
+
+#include <array>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
 
 /* Various sources used during development of the PPU of our emulator:
  * https://www.youtube.com/watch?v=xdzOvpYPmGE&list=PLrOv9FMX8xJHqMvSGB_9G9nZZ_4IgteYf&index=4
@@ -12,20 +20,100 @@
  * https://www.nesdev.org/wiki/PPU_registers
  * https://www.nesdev.org/wiki/Cycle_reference_chart
  * https://www.nesdev.org/wiki/PPU_frame_timing
+ * https://www.nesdev.org/wiki/PPU_memory_map
+ * https://www.nesdev.org/wiki/PPU_scrolling
+ * https://www.nesdev.org/wiki/PPU_sprite_evaluation
  */
 
 namespace NesEm
 {
+	class PPURenderWorker;
+
 	// The PPU or Picture Processing Unit is basically a very early representation of a GPU
 	// it has its own address space and handles anything related to background and sprite rendering
 	class PPU final
 	{
 	public:
-		PPU() = default;
-		~PPU() = default;
+		explicit PPU(Cartridge& cart);
+		~PPU();
 
 		void Clock() noexcept;
-		void Render() const noexcept;
+
+		// Param uint64_t CPU cycle the CPU is at
+		// Runs the PPU up to that point, the CPU calls this before it touches a PPU register so it sees the state at that time
+		// Does nothing when the PPU is already there (e.g. when it is clocked dot by dot)
+		void CatchUp(uint64_t cpuCycle) noexcept
+		{
+			while (m_TotalDots <= cpuCycle * Config::DOTS_PER_CPU_CYCLE)
+			{
+				Clock();
+			}
+		}
+
+		// Return uint64_t first CPU cycle at which the PPU has something the CPU has to react to (start of vblank / NMI, end of the frame)
+		// The CPU can run up to there without syncing, status flags (sprite 0 hit, overflow) are scheduled and caught up to on read
+		[[nodiscard]] uint64_t NextSyncCPUCycle() const noexcept;
+
+		// Return std::span ARGB8888 colour of every palette index, for tools that convert recorded indices without a PPU
+		[[nodiscard]] static constexpr std::span<uint32_t const, 64> SystemPalette() noexcept { return SYSTEM_PALETTE; }
+
+		// Palette conversion stage, converts the palette indices of the last completed frame to ARGB8888
+		// Param uint32_t* pixel memory to write to (e.g. a locked streaming texture), SCREEN_WIDTH x SCREEN_HEIGHT
+		// Param int pitch, length of one row of the destination in bytes
+		void Render(uint32_t* pPixels, int pitch) const noexcept;
+		// Param std::span palette indices of a frame copied out before, SCREEN_WIDTH x SCREEN_HEIGHT
+		static void Render(std::span<uint8_t const> indices, uint32_t* pPixels, int pitch) noexcept;
+
+		// Return std::span palette indices of the last completed frame, SCREEN_WIDTH x SCREEN_HEIGHT
+		// Only valid until the emulation continues, the PPU keeps composing into the same memory
+		[[nodiscard]] std::span<uint8_t const> FrameIndices() const noexcept;
+		// Return std::span PPUMASK emphasis bits (red, green, blue -> bit 0, 1, 2) of every scanline of the last completed frame
+		[[nodiscard]] std::span<uint8_t const> FrameEmphasis() const noexcept;
+		// Return std::span colour subcarrier phase of the first pixel of every scanline of the last completed frame, in 1/12ths of a cycle
+		[[nodiscard]] std::span<uint8_t const> FramePhases() const noexcept;
+		// Return std::span the last completed frame as ARGB8888, SCREEN_WIDTH x SCREEN_HEIGHT
+		// Converted on the first call after every new picture, later calls return the same memory
+		[[nodiscard]] std::span<uint32_t const> FramePixels() const noexcept;
+
+		// Return bool did the PPU finish a frame since the last call to ClearFrameComplete
+		[[nodiscard]] bool IsFrameComplete() const noexcept { return m_FrameComplete; }
+		void ClearFrameComplete() noexcept { m_FrameComplete = false; }
+
+		// Return bool does the last completed frame differ from the one before it
+		// When false the previous output can be reused, no conversion, upload or present is required
+		[[nodiscard]] bool HasNewPicture() const noexcept { return m_NewPicture; }
+		// Return uint64_t increments with every completed frame that has a new picture, equal values mean identical output
+		[[nodiscard]] uint64_t PictureSequence() const noexcept { return m_PictureSequence; }
+		// Return uint64_t how many frames were short-circuited because nothing relevant was written
+		[[nodiscard]] uint64_t SkippedFrameCount() const noexcept { return m_SkippedFrameCount; }
+		// Return uint64_t how many frames ran without pixel output because of frame skip
+		[[nodiscard]] uint64_t DroppedFrameCount() const noexcept { return m_DroppedFrameCount; }
+
+		// Param bool should the frame that is about to run produce pixels
+		// When disabled everything a game can observe still runs (vblank, NMI, sprite 0 hit, sprite overflow)
+		// but no background / sprite pixels are composed and the frame is never presented
+		// Only change this between frames
+		void SetPixelOutput(bool enabled) noexcept { m_PixelOutput = enabled; }
+
+		// Return bool did the PPU request a non maskable interrupt since the last poll (start of vblank)
+		[[nodiscard]] bool PollNMI() noexcept
+		{
+			bool const requested{ m_NMIRequested };
+			m_NMIRequested = false;
+			return requested;
+		}
+
+		// Points the 4 nametable slots of the page table at CIRAM according to the mirroring mode
+		// Mappers that control mirroring call this when it changes, only the 4 nametable pointers are rewritten
+		void SetMirroring(Mirroring mirroring) noexcept;
+
+		// Points the 8 pattern table pages at the CHR memory the cartridge currently maps
+		// Mappers call this after switching CHR banks
+		void MapPatternTables() noexcept;
+
+		// Param std::span 256 bytes of CPU memory written by OAM DMA ($4014)
+		// Copies the page into OAM starting at OAMADDR (wrapping around), equivalent to 256 OAMDATA writes
+		void WriteOAMDMA(std::span<uint8_t const, 256> page) noexcept;
 
 		// Param uint16_t the address we're writing to
 		// Param uint8_t the data we are writing to the address
@@ -40,43 +128,106 @@ namespace NesEm
 
 			case (PPU_CTRL_ADDRESS & 7):
 			{
+				MarkDirty(m_PPUCtrl.raw != value);
+
+				// Enabling NMI while in vblank immediately triggers it
+				if (!m_PPUCtrl.bits.nmiEnable && (value & 0x80) && m_PPUStatus.bits.vblankFlag)
+				{
+					m_NMIRequested = true;
+				}
+
 				m_PPUCtrl = value;
-				m_PPUCtrl.raw = value;
+				Record(RenderCommand::Type::Ctrl, 0, value);
+
+				// t: ...GH.. ........ <- d: ......GH
+				uint16_t const oldTemp{ m_TempVRAMAddr.raw };
+				m_TempVRAMAddr.bits.nametableX = m_PPUCtrl.bits.nametableSelectX;
+				m_TempVRAMAddr.bits.nametableY = m_PPUCtrl.bits.nametableSelectY;
+				MarkDirty(oldTemp != m_TempVRAMAddr.raw);
 			}break;
 
 			case (PPU_MASK_ADDRESS & 7):
 			{
-
+				MarkDirty(m_PPUMask.raw != value);
+				m_PPUMask = value;
+				Record(RenderCommand::Type::Mask, 0, value);
 			}break;
 
 			case (PPU_STATUS_ADDRESS & 7):
 			{
-
+				// Read only
 			}break;
 
 			case (OAM_ADDR_ADDRESS & 7):
 			{
-
+				m_OAMAddr = value;
 			}break;
 
 			case (OAM_DATA_ADDRESS & 7):
 			{
-
+				MarkDirty(m_OAM.Read(m_OAMAddr) != value);
+				m_OAM.Write(m_OAMAddr, value);
+				Record(RenderCommand::Type::OAM, m_OAMAddr, value);
+				++m_OAMAddr;
 			}break;
 
 			case (PPU_SCROLL_ADDRESS & 7):
 			{
-
+				uint16_t const oldTemp{ m_TempVRAMAddr.raw };
+				uint8_t const oldFineX{ m_FineX };
+
+				if (!m_WriteToggle)
+				{
+					// t: ....... ...ABCDE <- d: ABCDE...
+					// x:              FGH <- d: .....FGH
+					m_TempVRAMAddr.bits.coarseX = value >> 3;
+					m_FineX = value & 0x07;
+				}
+				else
+				{
+					// t: FGH..AB CDE..... <- d: ABCDEFGH
+					m_TempVRAMAddr.bits.coarseY = value >> 3;
+					m_TempVRAMAddr.bits.fineY = value & 0x07;
+				}
+				m_WriteToggle = !m_WriteToggle;
+
+				MarkDirty(oldTemp != m_TempVRAMAddr.raw || oldFineX != m_FineX);
 			}break;
 
 			case (PPU_ADDR_ADDRESS & 7):
 			{
-
+				uint16_t const oldTemp{ m_TempVRAMAddr.raw };
+
+				if (!m_WriteToggle)
+				{
+					// t: .CDEFGH ........ <- d: ..CDEFGH
+					// t: Z...... ........ <- 0 (bit 14 is cleared)
+					m_TempVRAMAddr.raw = static_cast<uint16_t>((m_TempVRAMAddr.raw & 0x00FF) | ((value & 0x3F) << 8));
+				}
+				else
+				{
+					// t: ....... ABCDEFGH <- d: ABCDEFGH
+					// v: <...all bits...> <- t: <...all bits...>
+					m_TempVRAMAddr.raw = static_cast<uint16_t>((m_TempVRAMAddr.raw & 0xFF00) | value);
+
+					// Changing v mid frame moves where the rest of the frame is fetched from
+					MarkDirty(IsRendering() && m_VRAMAddr.raw != m_TempVRAMAddr.raw);
+					m_VRAMAddr = m_TempVRAMAddr;
+				}
+				m_WriteToggle = !m_WriteToggle;
+
+				MarkDirty(oldTemp != m_TempVRAMAddr.raw);
 			}break;
 
 			case (PPU_DATA_ADDRESS & 7):
 			{
-
+				// Nametables, palette and CHR-RAM are only reachable through here, the bus write tracks if anything changed
+				// Sequential uploads are collected and copied into VRAM as a single span, v still moves on every write
+				if (!BatchPPUData(value))
+				{
+					BusWrite(m_VRAMAddr.raw, value);
+				}
+				IncrementVRAMAddr();
 			}break;
 
 			default: break;
@@ -86,7 +237,7 @@ namespace NesEm
 		
 		// Param uint16_t the address we're reading from
 		// Return uint8_t the data read from the address
-		[[nodiscard]] uint8_t Read(uint16_t address) const noexcept
+		[[nodiscard]] uint8_t Read(uint16_t address) noexcept
 		{
 			// Handle mirroring
 			address &= 7;
@@ -95,69 +246,384 @@ namespace NesEm
 			switch (address)
 			{
 
-			case (PPU_CTRL_ADDRESS & 7):
+			case (PPU_STATUS_ADDRESS & 7):
 			{
+				// Lower 5 bits are open bus, the read buffer is the closest we have to that
+				uint8_t const data{ static_cast<uint8_t>((m_PPUStatus.raw & 0xE0) | (m_DataBuffer & 0x1F)) };
 
+				// Reading the status clears vblank and the shared write toggle
+				m_PPUStatus.bits.vblankFlag = 0;
+				m_WriteToggle = false;
+
+				return data;
 			}break;
 
-			case (PPU_MASK_ADDRESS & 7):
+			case (OAM_DATA_ADDRESS & 7):
 			{
+				return m_OAM.Read(m_OAMAddr);
+			}break;
 
+			case (PPU_DATA_ADDRESS & 7):
+			{
+				// https://www.nesdev.org/wiki/PPU_registers#The_PPUDATA_read_buffer
+				// Reads are delayed by one, except for the palette which is returned immediately
+				// The buffer is then filled with the nametable "underneath" the palette
+				uint16_t const vramAddr{ static_cast<uint16_t>(m_VRAMAddr.raw & 0x3FFF) };
+
+				FlushPPUDataBatch();
+
+				uint8_t data{ m_DataBuffer };
+				if (vramAddr >= PALETTE_ADDRESS)
+				{
+					data = BusRead(vramAddr);
+					m_DataBuffer = BusRead(vramAddr - 0x1000);
+				}
+				else
+				{
+					m_DataBuffer = BusRead(vramAddr);
+				}
+
+				IncrementVRAMAddr();
+				return data;
 			}break;
 
-			case (PPU_STATUS_ADDRESS & 7):
+			// Write only registers
+			default: break;
+
+			}
+
+			return 0;
+		}
+
+		PPU(PPU const&) = delete;
+		PPU(PPU&&) = delete;
+		PPU& operator=(PPU const&) = delete;
+		PPU& operator=(PPU&&) = delete;
+
+	private:
+		// Replays the render log, reads the private register layouts and uses the static rendering helpers
+		friend class PPURenderWorker;
+
+		Cartridge& m_Cartridge;
+
+		// Dot within the current scanline (0 - 340)
+		uint16_t m_CurrCycle{ };
+		// -1 is the pre-render line, 0 - 239 are visible, followed by post-render and vblank
+		int16_t m_CurrScanline{ };
+
+		static constexpr int16_t PRE_RENDER_SCANLINE{ -1 };
+		static constexpr int16_t VBLANK_SCANLINE{ 241 };
+
+		static constexpr uint16_t DOTS_PER_SCANLINE{ 341 };
+		// PAL: 312 scanlines, NTSC: 262 scanlines (the odd frame skipped dot is not emulated)
+		static constexpr uint32_t FRAME_DOTS{ (Config::MODE == Config::NES_MODE::PAL ? 312u : 262u) * DOTS_PER_SCANLINE };
+
+		// Dots clocked since power on
+		uint64_t m_TotalDots{ 0 };
+
+		// Param int16_t scanline
+		// Param uint16_t dot within the scanline
+		// Return uint32_t dot since the start of the frame (pre-render line = 0)
+		[[nodiscard]] static constexpr uint32_t FrameTime(int16_t scanline, uint16_t cycle) noexcept
+		{
+			return static_cast<uint32_t>((scanline - PRE_RENDER_SCANLINE) * DOTS_PER_SCANLINE + cycle);
+		}
+		[[nodiscard]] uint32_t FrameTime() const noexcept { return FrameTime(m_CurrScanline, m_CurrCycle); }
+
+		bool m_FrameComplete{ false };
+
+#pragma region DirtyTracking
+		// Anything that affects the picture written this / last frame
+		// Writes made during a frame (e.g. vblank) only show up in the next one, so both have to be clean to reuse the output
+		bool m_DirtyThisFrame{ true };
+		bool m_DirtyLastFrame{ true };
+
+		// Was any pixel regenerated during the current frame
+		bool m_FrameChanged{ false };
+		// Did the last completed frame regenerate any pixels
+		bool m_NewPicture{ false };
+		uint64_t m_PictureSequence{ 0 };
+
+		uint64_t m_SkippedFrameCount{ 0 };
+
+		// When false the frame is emulated without producing pixels (frame skip)
+		bool m_PixelOutput{ true };
+		uint64_t m_DroppedFrameCount{ 0 };
+
+		// Param bool did the write actually change any state
+		FORCE_INLINE void MarkDirty(bool changed = true) noexcept
+		{
+			m_DirtyThisFrame |= changed;
+			// Whatever changes the picture can also move sprite 0 hit / overflow
+			m_StatusPredicted &= !changed;
+		}
+
+		// Called once the last scanline of a frame finished
+		void CompleteFrame() noexcept;
+#pragma endregion
+
+#pragma region DeferredRendering
+		// Everything the picture depends on, recorded in order on the emulation thread
+		// The render worker replays it against its own copy of VRAM / OAM and composes scanlines while the CPU keeps running
+		struct RenderCommand final
+		{
+			enum class Type : uint8_t
 			{
+				Ctrl, // value: PPUCTRL
+				Mask, // value: PPUMASK
+				VRAM, // address: $0000 - $2FFF or palette, value: data
+				OAM, // address: OAM index, value: data
+				Mirroring, // value: Mirroring
+				CHRPage, // address: CHR offset / PAGE_SIZE, value: pattern table page
+				Scanline, // address: v, value: fine X | subcarrier phase << 3, compose the scanline the timestamp falls on
+				FrameEnd,
+				Stop // Shuts the worker down
+			};
 
-			}break;
+			// Dot since the start of the frame (pre-render line = 0)
+			uint32_t time{ };
+			uint16_t address{ };
+			uint8_t value{ };
+			Type type{ };
+		};
 
-			case (OAM_ADDR_ADDRESS & 7):
+		// Enough for a full CHR-RAM and nametable upload in one frame without the CPU waiting on the worker
+		using RenderLog = SPSCRing<RenderCommand, (1 << 14)>;
+		RenderLog m_RenderLog{ };
+		// Only created when Config::DEFERRED_RENDERING is enabled
+		std::unique_ptr<PPURenderWorker> m_pRenderWorker{ };
+
+		// Frames completed on the emulation thread, the worker catches up to this before the output is read
+		uint64_t m_FrameCount{ 0 };
+
+		// Adds a command to the render log, the worker is only woken for whole scanlines and frames
+		FORCE_INLINE void Record(RenderCommand::Type type, uint16_t address = 0, uint8_t value = 0) noexcept
+		{
+			if constexpr (Config::DEFERRED_RENDERING)
 			{
+				RenderCommand const command{
+					FrameTime(),
+					address,
+					value,
+					type };
+
+				while (!m_RenderLog.TryPush(command))
+				{
+					// The worker is a full log behind, give it time to drain
+					// It may be waiting for data it was never notified of, commands in the middle of a scanline (e.g. OAM DMA) don't notify
+					m_RenderLog.Notify();
+					std::this_thread::yield();
+				}
+
+				if (type == RenderCommand::Type::Scanline || type == RenderCommand::Type::FrameEnd)
+				{
+					m_RenderLog.Notify();
+				}
+			}
+		}
+#pragma endregion
+		
+		bool m_NMIRequested{ false };
+
+#pragma region PPUBus
+		// https://www.nesdev.org/wiki/PPU_memory_map
+		// $0000 - $0FFF: Pattern table 0 (cartridge CHR)
+		// $1000 - $1FFF: Pattern table 1 (cartridge CHR)
+		// $2000 - $2FFF: Nametables 0 - 3 (CIRAM, depending on mirroring)
+		// $3000 - $3EFF: Mirror of $2000 - $2EFF
+		// $3F00 - $3F1F: Palette RAM, mirrored up to $3FFF
+		static constexpr uint16_t NAMETABLE_ADDRESS{ 0x2000 };
+		static constexpr uint16_t NAMETABLE_MIRROR_ADDRESS{ 0x3000 };
+		static constexpr uint16_t PALETTE_ADDRESS{ 0x3F00 };
+
+		static constexpr uint16_t PAGE_SIZE{ 0x400 };
+		// 8 pattern table pages + 4 nametable slots
+		static constexpr uint8_t PAGE_COUNT{ 12 };
+		static constexpr uint8_t NAMETABLE_PAGE{ 8 };
+
+		// Every 1KB page of $0000 - $2FFF points straight at the memory backing it
+		std::array<uint8_t*, PAGE_COUNT> m_PageTable{ };
+
+		// Console VRAM (CIRAM) is 2KB, the upper half is only used by four screen boards which add it on the cartridge
+		NESMemory<4 * PAGE_SIZE> m_Nametables{ };
 
-			}break;
+		NESMemory<32> m_Pallete{ };
 
-			case (OAM_DATA_ADDRESS & 7):
+		// Object Attribute Memory, 64 sprites of 4 bytes
+		// Byte 0: Y position of top - 1
+		// Byte 1: Tile index
+		// Byte 2: Attributes (VHP...PP: flip vertical, flip horizontal, priority (1 = behind background), palette)
+		// Byte 3: X position of left
+		NESMemory<256> m_OAM{ };
+		uint8_t m_OAMAddr{ 0 };
+
+		using PageTable = std::array<uint8_t*, PAGE_COUNT>;
+
+		// Rendering fetch, one indexed pointer load
+		// Param PageTable the pages to fetch through (the PPU's own or the render worker's copy)
+		// Param uint16_t address in $0000 - $2FFF
+		[[nodiscard]] static FORCE_INLINE uint8_t Fetch(PageTable const& pages, uint16_t address) noexcept
+		{
+			assert(address < NAMETABLE_MIRROR_ADDRESS);
+			return pages[address >> 10][address & (PAGE_SIZE - 1)];
+		}
+
+		[[nodiscard]] FORCE_INLINE uint8_t Fetch(uint16_t address) const noexcept
+		{
+			return Fetch(m_PageTable, address);
+		}
+
+		// Param Mirroring nametable layout
+		// Return which CIRAM table backs each of the nametable slots $2000, $2400, $2800, $2C00
+		[[nodiscard]] static std::array<uint8_t, 4> NametableLayout(Mirroring mirroring) noexcept;
+
+		// Param uint16_t palette address ($3F00 - $3FFF)
+		// Return uint16_t index in palette RAM, $3F10/$3F14/$3F18/$3F1C mirror $3F00/$3F04/$3F08/$3F0C
+		[[nodiscard]] static constexpr uint16_t PaletteIndex(uint16_t address) noexcept
+		{
+			address &= 0x1F;
+			if ((address & 0x13) == 0x10)
 			{
+				address &= 0x0F;
+			}
+			return address;
+		}
 
-			}break;
+		[[nodiscard]] uint8_t BusRead(uint16_t address) const noexcept
+		{
+			address &= 0x3FFF;
 
-			case (PPU_SCROLL_ADDRESS & 7):
+			if (address >= PALETTE_ADDRESS)
 			{
+				return m_Pallete.Read(PaletteIndex(address));
+			}
 
-			}break;
+			// $3000 - $3EFF mirrors the nametables
+			if (address >= NAMETABLE_MIRROR_ADDRESS)
+			{
+				address -= 0x1000;
+			}
 
-			case (PPU_ADDR_ADDRESS & 7):
+			return Fetch(address);
+		}
+
+		void BusWrite(uint16_t address, uint8_t value) noexcept
+		{
+			address &= 0x3FFF;
+
+			if (address >= PALETTE_ADDRESS)
 			{
+				uint16_t const index{ PaletteIndex(address) };
+				MarkDirty(m_Pallete.Read(index) != value);
+				m_Pallete.Write(index, value);
+				Record(RenderCommand::Type::VRAM, address, value);
+				return;
+			}
 
-			}break;
+			// CHR-ROM can't be written to
+			if (address < NAMETABLE_ADDRESS && !m_Cartridge.HasCHRRAM())
+			{
+				return;
+			}
 
-			case (PPU_DATA_ADDRESS & 7):
+			// $3000 - $3EFF mirrors the nametables
+			if (address >= NAMETABLE_MIRROR_ADDRESS)
 			{
+				address -= 0x1000;
+			}
 
-			}break;
+			uint8_t& data{ m_PageTable[address >> 10][address & (PAGE_SIZE - 1)] };
+			MarkDirty(data != value);
+			data = value;
+			Record(RenderCommand::Type::VRAM, address, value);
+		}
 
-			default: break;
+		// Pending run of sequential PPUDATA writes, always within a single page
+		// Anything that reads VRAM or remaps pages flushes it first
+		std::array<uint8_t, PAGE_SIZE> m_BatchData{ };
+		// Address of the first byte ($0000 - $2FFF)
+		uint16_t m_BatchAddr{ 0 };
+		uint16_t m_BatchSize{ 0 };
+		// Increment between bytes, 1 or 32
+		uint8_t m_BatchStep{ 1 };
+
+		// Param uint8_t value written to PPUDATA at v
+		// Return bool was the write added to the batch, when false it has to go through the bus directly
+		[[nodiscard]] FORCE_INLINE bool BatchPPUData(uint8_t value) noexcept
+		{
+			uint16_t address{ static_cast<uint16_t>(m_VRAMAddr.raw & 0x3FFF) };
 
+			// The palette is tiny and has its own mirroring, writes during rendering hit whatever the PPU is fetching
+			// CHR-ROM writes are dropped by the bus anyway
+			if (address >= PALETTE_ADDRESS || IsRendering() || (address < NAMETABLE_ADDRESS && !m_Cartridge.HasCHRRAM()))
+			{
+				FlushPPUDataBatch();
+				return false;
 			}
 
-			return 0;
+			// $3000 - $3EFF mirrors the nametables
+			if (address >= NAMETABLE_MIRROR_ADDRESS)
+			{
+				address -= 0x1000;
+			}
+
+			uint8_t const step{ static_cast<uint8_t>(m_PPUCtrl.bits.incrementMode ? 32 : 1) };
+
+			// Only continue the run when this write lands right after the previous one, in the same page
+			if (m_BatchSize != 0
+				&& (step != m_BatchStep
+					|| address != m_BatchAddr + m_BatchSize * m_BatchStep
+					|| (address >> 10) != (m_BatchAddr >> 10)))
+			{
+				FlushPPUDataBatch();
+			}
+
+			if (m_BatchSize == 0)
+			{
+				m_BatchAddr = address;
+				m_BatchStep = step;
+			}
+
+			m_BatchData[m_BatchSize++] = value;
+			return true;
 		}
 
-		PPU(PPU const&) = delete;
-		PPU(PPU&&) = delete;
-		PPU& operator=(PPU const&) = delete;
-		PPU& operator=(PPU&&) = delete;
+		// Applies the pending PPUDATA writes to the page they target
+		void FlushPPUDataBatch() noexcept;
+#pragma endregion
 
-	private:
-		uint16_t m_CurrCycle{ };
-		uint16_t m_CurrScanline{ };
+		// Output of the PPU, one palette index (0 - 63) per pixel
+		// Kept as indices so the conversion to colours can happen straight into the renderer's memory
+		using FrameBuffer = std::array<uint8_t, Config::SCREEN_WIDTH * Config::SCREEN_HEIGHT>;
+		FrameBuffer m_FrameBuffer{ };
 
-		//TODO
-		bool m_FrameComplete{ false };
-		
-		NESMemory<1024> m_Nametable_1{ };
-		NESMemory<1024> m_Nametable_2{ };
+		// Palette converted copy of the last completed frame for FramePixels, allocated on first use
+		mutable std::vector<uint32_t> m_FramePixels{ };
+		// Picture sequence m_FramePixels was converted from
+		mutable uint64_t m_FramePixelsSequence{ UINT64_MAX };
 
-		NESMemory<32> m_Pallete{ };
+		// Per scanline of the frame buffer, what a composite video filter needs besides the palette indices
+		using LineBuffer = std::array<uint8_t, Config::SCREEN_HEIGHT>;
+		LineBuffer m_LineEmphasis{ };
+		LineBuffer m_LinePhases{ };
+
+		// Param uint64_t dot since power on
+		// Return uint8_t colour subcarrier phase at the start of that dot in 1/12ths of a cycle, a dot lasts 8 of them
+		[[nodiscard]] static constexpr uint8_t SubcarrierPhase(uint64_t dot) noexcept
+		{
+			return static_cast<uint8_t>((dot * 8) % 12);
+		}
+
+		// 2C02 system palette, index -> ARGB8888
+		// https://www.nesdev.org/wiki/PPU_palettes
+		// Always static, SystemPalette hands it out without an instance
+		static constexpr std::array<uint32_t, 64> SYSTEM_PALETTE
+		{
+			/*0*/ 0xFF545454, 0xFF001E74, 0xFF081090, 0xFF300088, 0xFF440064, 0xFF5C0030, 0xFF540400, 0xFF3C1800, 0xFF202A00, 0xFF083A00, 0xFF004000, 0xFF003C00, 0xFF00323C, 0xFF000000, 0xFF000000, 0xFF000000,
+			/*1*/ 0xFF989698, 0xFF084CC4, 0xFF3032EC, 0xFF5C1EE4, 0xFF8814B0, 0xFFA01464, 0xFF982220, 0xFF783C00, 0xFF545A00, 0xFF287200, 0xFF087C00, 0xFF007628, 0xFF006678, 0xFF000000, 0xFF000000, 0xFF000000,
+			/*2*/ 0xFFECEEEC, 0xFF4C9AEC, 0xFF787CEC, 0xFFB062EC, 0xFFE454EC, 0xFFEC58B4, 0xFFEC6A64, 0xFFD48820, 0xFFA0AA00, 0xFF74C400, 0xFF4CD020, 0xFF38CC6C, 0xFF38B4CC, 0xFF3C3C3C, 0xFF000000, 0xFF000000,
+			/*3*/ 0xFFECEEEC, 0xFFA8CCEC, 0xFFBCBCEC, 0xFFD4B2EC, 0xFFECAEEC, 0xFFECAED4, 0xFFECB4B0, 0xFFE4C490, 0xFFCCD278, 0xFFB4DE78, 0xFFA8E290, 0xFF98E2B4, 0xFFA0D6E4, 0xFFA0A2A0, 0xFF000000, 0xFF000000,
+		};
 
 #pragma region PPU_Registers
 		// https://www.nesdev.org/wiki/PPU_registers
@@ -171,7 +637,7 @@ namespace NesEm
 		static constexpr uint16_t PPU_ADDR_ADDRESS{ 0x2006 };
 		static constexpr uint16_t PPU_DATA_ADDRESS{ 0x2007 };
 
-		static constexpr uint16_t OAM_DMA_ADDRESS{ 0x4014 };
+		// OAM DMA ($4014) lives on the CPU bus, see CPU::OAMDMA and WriteOAMDMA
 	#pragma endregion
 
 		// PPU control register, located at address $2000 (write) --> Miscellaneous settings
@@ -266,10 +732,110 @@ namespace NesEm
 		};
 		PPU_STATUS_REG m_PPUStatus{};
 
+		// Internal VRAM address registers (v and t), written through PPUSCROLL and PPUADDR
+		union LOOPY_REG
+		{
+			// yyy NN YYYYY XXXXX
+			// ||| || ||||| +++++-- coarse X scroll
+			// ||| || +++++-------- coarse Y scroll
+			// ||| ++-------------- nametable select
+			// +++----------------- fine Y scroll
+			// https://www.nesdev.org/wiki/PPU_scrolling#PPU_internal_registers
+			struct LOOPY final
+			{
+				uint16_t coarseX	: 5;
+				uint16_t coarseY	: 5;
+				uint16_t nametableX : 1;
+				uint16_t nametableY : 1;
+				uint16_t fineY		: 3;
+				uint16_t unused		: 1;
+			};
+			static_assert(sizeof(LOOPY) == 2, "LOOPY must be exactly 2 bytes!");
+
+			LOOPY bits;
+			uint16_t raw{ };
+		};
+		// Current VRAM address (v)
+		LOOPY_REG m_VRAMAddr{ };
+		// Temporary VRAM address (t), the address of the top left onscreen tile
+		LOOPY_REG m_TempVRAMAddr{ };
+		// Fine X scroll (x)
+		uint8_t m_FineX{ 0 };
+		// First or second write toggle (w), shared by PPUSCROLL and PPUADDR
+		bool m_WriteToggle{ false };
+
+		// PPUDATA read buffer
+		uint8_t m_DataBuffer{ 0 };
+#pragma endregion
 
-		// PPU scroll regiter, located at address $2005 (write)
-		//TODO
-		uint8_t m_PPUScroll{  };
+#pragma region Rendering
+		// Sprite pixel layout on a scanline: ...ZBSPP
+		// bits 0 - 3: palette index of the pixel in the sprite half of palette RAM
+		static constexpr uint8_t SPRITE_PALETTE{ 0x10 };
+		static constexpr uint8_t SPRITE_BEHIND_BACKGROUND{ 0x20 };
+		static constexpr uint8_t SPRITE_ZERO{ 0x40 };
+
+		// Tiles fetched for one scanline, one more than fits on screen to allow for fine X scrolling
+		static constexpr uint32_t SCANLINE_TILES{ Config::SCREEN_WIDTH / 8 + 1 };
+
+		// Return bool is the PPU currently fetching for the screen (and accessing v itself)
+		[[nodiscard]] bool IsRendering() const noexcept
+		{
+			return (m_PPUMask.bits.backgroundEnable || m_PPUMask.bits.spriteEnable)
+				&& m_CurrScanline < static_cast<int16_t>(Config::SCREEN_HEIGHT);
+		}
+
+		// PPUDATA access moves v by 1 or 32 depending on PPUCTRL
+		FORCE_INLINE void IncrementVRAMAddr() noexcept
+		{
+			MarkDirty(IsRendering());
+			m_VRAMAddr.raw = static_cast<uint16_t>((m_VRAMAddr.raw + (m_PPUCtrl.bits.incrementMode ? 32 : 1)) & 0x7FFF);
+		}
+
+		// Move v to the next tile, wrapping into the horizontally adjacent nametable
+		static void IncrementX(LOOPY_REG& address) noexcept;
+		// Move v to the next pixel row, wrapping into the vertically adjacent nametable
+		static void IncrementY(LOOPY_REG& address) noexcept;
+
+		using BackgroundLine = std::array<uint8_t, SCANLINE_TILES * 8>;
+		using SpriteLine = std::array<uint8_t, Config::SCREEN_WIDTH>;
+
+		// Renders the current visible scanline into the framebuffer
+		// With deferred rendering the scanline is handed to the render worker instead
+		void RenderScanline() noexcept;
+
+		// The stages below only depend on their parameters, so the render worker runs them on its replayed state
+
+		// Param (out) background pixels (palette << 2 | value) starting at the tile the address points to
+		static void FetchBackground(PageTable const& pages, PPU_CTRL_REG ctrl, LOOPY_REG address, BackgroundLine& line) noexcept;
+		// Param bool spriteZeroOnly, only decode sprite 0, all a sprite 0 hit needs (other sprites are still counted for overflow)
+		// Param (out) sprite pixels of the scanline, see SPRITE_ flags
+		// Param (out) bool set when more than 8 sprites are on the scanline
+		// Return int X of sprite 0 when it is on this scanline, -1 if it is not
+		static int EvaluateSprites(PageTable const& pages, uint8_t const* pOAM, PPU_CTRL_REG ctrl, int16_t scanline,
+			bool spriteZeroOnly, SpriteLine& line, bool& overflow) noexcept;
+		// Param (out) uint8_t* SCREEN_WIDTH palette indices of the scanline
+		static void ComposeScanline(BackgroundLine const& background, SpriteLine const& sprites, PPU_MASK_REG mask, uint8_t fineX,
+			uint8_t const* pPalette, uint8_t* pLine) noexcept;
+
+	#pragma region StatusPrediction
+		// https://www.nesdev.org/wiki/PPU_OAM#Sprite_zero_hits
+		// https://www.nesdev.org/wiki/PPU_sprite_evaluation#Sprite_overflow_bug
+		// Sprite 0 hit and sprite overflow are worked out for the rest of the frame in one go and then just happen at their dot
+		// The prediction is redone once anything that affects the picture changes, so it is usually done once per frame
+		static constexpr uint32_t NO_EVENT{ UINT32_MAX };
+
+		// Frame time (see FrameTime) at which the flag gets set, NO_EVENT when it does not happen this frame
+		uint32_t m_Sprite0HitTime{ NO_EVENT };
+		uint32_t m_SpriteOverflowTime{ NO_EVENT };
+		bool m_StatusPredicted{ false };
+
+		// Follows v from the current dot to the end of the visible frame and schedules both flags
+		void PredictStatusEvents() noexcept;
+
+		// Return int X of the first sprite 0 hit on the scanline, -1 if there is none
+		[[nodiscard]] static int FindSprite0Hit(BackgroundLine const& background, SpriteLine const& sprites, PPU_MASK_REG mask, uint8_t fineX, int sprite0X) noexcept;
+	#pragma endregion
 #pragma endregion
 
 
@@ -0,0 +1,152 @@
+#include "NESPPURenderWorker.h"
+
+namespace NesEm
+{
+	PPURenderWorker::PPURenderWorker(PPU::RenderLog& log, Cartridge& cart):
+		m_Log{ log }
+	{
+		std::span<uint8_t> const chr{ cart.GetCHRMemory() };
+		if (cart.HasCHRRAM())
+		{
+			// From here on CHR-RAM only changes through logged PPUDATA writes
+			m_CHRRAM.assign(chr.begin(), chr.end());
+			m_pCHR = m_CHRRAM.data();
+		}
+		else
+		{
+			m_pCHR = chr.data();
+		}
+
+		m_Thread = std::thread{ &PPURenderWorker::Run, this };
+	}
+
+	PPURenderWorker::~PPURenderWorker()
+	{
+		RenderCommand const stop{ 0, 0, 0, RenderCommand::Type::Stop };
+		while (!m_Log.TryPush(stop))
+		{
+			std::this_thread::yield();
+		}
+		m_Log.Notify();
+
+		m_Thread.join();
+	}
+
+	PPU::FrameBuffer const& PPURenderWorker::WaitForFrame(uint64_t frame) const noexcept
+	{
+		for (uint64_t completed{ m_CompletedFrames.load(std::memory_order_acquire) }; completed < frame;
+			completed = m_CompletedFrames.load(std::memory_order_acquire))
+		{
+			m_CompletedFrames.wait(completed, std::memory_order_acquire);
+		}
+
+		return m_FrameBuffer;
+	}
+
+	void PPURenderWorker::Run() noexcept
+	{
+		RenderCommand command{ };
+		while (true)
+		{
+			if (!m_Log.TryPop(command))
+			{
+				m_Log.WaitForData();
+				continue;
+			}
+
+			if (!Execute(command))
+			{
+				return;
+			}
+		}
+	}
+
+	bool PPURenderWorker::Execute(RenderCommand const& command) noexcept
+	{
+		switch (command.type)
+		{
+		case RenderCommand::Type::Ctrl:
+			m_PPUCtrl = command.value;
+			break;
+
+		case RenderCommand::Type::Mask:
+			m_PPUMask = command.value;
+			break;
+
+		case RenderCommand::Type::VRAM:
+			WriteVRAM(command.address, command.value);
+			break;
+
+		case RenderCommand::Type::OAM:
+			m_OAM.Write(command.address, command.value);
+			break;
+
+		case RenderCommand::Type::Mirroring:
+		{
+			std::array<uint8_t, 4> const tables{ PPU::NametableLayout(static_cast<Mirroring>(command.value)) };
+			for (uint8_t slot{ 0 }; slot < tables.size(); ++slot)
+			{
+				m_PageTable[PPU::NAMETABLE_PAGE + slot] = m_Nametables.Data() + tables[slot] * PPU::PAGE_SIZE;
+			}
+		}break;
+
+		case RenderCommand::Type::CHRPage:
+			m_PageTable[command.value] = m_pCHR + command.address * PPU::PAGE_SIZE;
+			break;
+
+		case RenderCommand::Type::Scanline:
+			ComposeScanline(static_cast<int16_t>(command.time / PPU::DOTS_PER_SCANLINE + PPU::PRE_RENDER_SCANLINE), command.address,
+				static_cast<uint8_t>(command.value & 0x07), static_cast<uint8_t>(command.value >> 3));
+			break;
+
+		case RenderCommand::Type::FrameEnd:
+			m_CompletedFrames.fetch_add(1, std::memory_order_release);
+			m_CompletedFrames.notify_all();
+			break;
+
+		case RenderCommand::Type::Stop:
+			return false;
+
+		default: break;
+		}
+
+		return true;
+	}
+
+	void PPURenderWorker::WriteVRAM(uint16_t address, uint8_t value) noexcept
+	{
+		// The PPU already dropped CHR-ROM writes and folded the nametable mirror
+		if (address >= PPU::PALETTE_ADDRESS)
+		{
+			m_Pallete.Write(PPU::PaletteIndex(address), value);
+			return;
+		}
+
+		assert(address < PPU::NAMETABLE_MIRROR_ADDRESS);
+		m_PageTable[address >> 10][address & (PPU::PAGE_SIZE - 1)] = value;
+	}
+
+	void PPURenderWorker::ComposeScanline(int16_t scanline, uint16_t vramAddr, uint8_t fineX, uint8_t phase) noexcept
+	{
+		assert(scanline >= 0 && scanline < static_cast<int16_t>(Config::SCREEN_HEIGHT));
+
+		PPU::SpriteLine sprites{ };
+		if (m_PPUMask.bits.spriteEnable)
+		{
+			bool overflow{ false };
+			static_cast<void>(PPU::EvaluateSprites(m_PageTable, m_OAM.Data(), m_PPUCtrl, scanline, false, sprites, overflow));
+		}
+
+		PPU::BackgroundLine background{ };
+		if (m_PPUMask.bits.backgroundEnable)
+		{
+			PPU::LOOPY_REG address{ };
+			address.raw = vramAddr;
+			PPU::FetchBackground(m_PageTable, m_PPUCtrl, address, background);
+		}
+
+		PPU::ComposeScanline(background, sprites, m_PPUMask, fineX, m_Pallete.Data(), &m_FrameBuffer[scanline * Config::SCREEN_WIDTH]);
+		m_LineEmphasis[scanline] = m_PPUMask.raw >> 5;
+		m_LinePhases[scanline] = phase;
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef NES_EMULATOR_PPU_RENDER_WORKER
+#define NES_EMULATOR_PPU_RENDER_WORKER
+
+#include "emulator_pch.h"
+
+#include "NESPPU.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace NesEm
+{
+	// Composes the PPU's scanlines on its own thread
+	// It keeps a private copy of everything the picture depends on (registers, nametables, palette, OAM, CHR-RAM)
+	// and brings it up to date by replaying the PPU's render log in order, so it never touches memory the emulation thread writes to
+	class PPURenderWorker final
+	{
+	public:
+		// Param PPU::RenderLog the log to replay, the PPU is the only producer
+		// Param Cartridge for the CHR memory, CHR-ROM is read in place, CHR-RAM is copied
+		PPURenderWorker(PPU::RenderLog& log, Cartridge& cart);
+		~PPURenderWorker();
+
+		// Param uint64_t amount of frames the PPU completed
+		// Return FrameBuffer palette indices of that frame, blocks until the worker replayed up to its end
+		[[nodiscard]] PPU::FrameBuffer const& WaitForFrame(uint64_t frame) const noexcept;
+
+		// Return LineBuffer emphasis bits / subcarrier phase of every composed scanline, only consistent with the frame after WaitForFrame
+		[[nodiscard]] PPU::LineBuffer const& LineEmphasis() const noexcept { return m_LineEmphasis; }
+		[[nodiscard]] PPU::LineBuffer const& LinePhases() const noexcept { return m_LinePhases; }
+
+		PPURenderWorker(PPURenderWorker const&) = delete;
+		PPURenderWorker(PPURenderWorker&&) = delete;
+		PPURenderWorker& operator=(PPURenderWorker const&) = delete;
+		PPURenderWorker& operator=(PPURenderWorker&&) = delete;
+
+	private:
+		using RenderCommand = PPU::RenderCommand;
+
+		PPU::RenderLog& m_Log;
+
+		// Replayed state
+		PPU::PageTable m_PageTable{ };
+		NESMemory<4 * PPU::PAGE_SIZE> m_Nametables{ };
+		NESMemory<32> m_Pallete{ };
+		NESMemory<256> m_OAM{ };
+		PPU::PPU_CTRL_REG m_PPUCtrl{ };
+		PPU::PPU_MASK_REG m_PPUMask{ };
+
+		// CHR pages are mapped relative to this, the cartridge's CHR-ROM or our own copy of its CHR-RAM
+		uint8_t* m_pCHR{ nullptr };
+		std::vector<uint8_t> m_CHRRAM{ };
+
+		// Only written by the worker, scanlines that are not composed keep the previous frame's pixels
+		PPU::FrameBuffer m_FrameBuffer{ };
+		PPU::LineBuffer m_LineEmphasis{ };
+		PPU::LineBuffer m_LinePhases{ };
+		std::atomic<uint64_t> m_CompletedFrames{ 0 };
+
+		std::thread m_Thread{ };
+
+		void Run() noexcept;
+
+		// Return bool should the worker keep running
+		bool Execute(RenderCommand const& command) noexcept;
+
+		void WriteVRAM(uint16_t address, uint8_t value) noexcept;
+		void ComposeScanline(int16_t scanline, uint16_t vramAddr, uint8_t fineX, uint8_t phase) noexcept;
+	};
+}
+
+#endif
@@ -15,8 +15,8 @@ namespace NesEm
 	class NROMMapper final : public Mapper
 	{
 	public:
-		NROMMapper(uint8_t chrBanks, uint8_t prgBanks) :
-			Mapper{ chrBanks, prgBanks } { }
+		NROMMapper(uint8_t chrBanks, uint8_t prgBanks, Mirroring mirroring) :
+			Mapper{ chrBanks, prgBanks, mirroring } { }
 
 		virtual ~NROMMapper() override = default;
 
@@ -54,7 +54,12 @@ namespace NesEm
 			return false;
 		}
 
-		// PPU remapping?
+		[[nodiscard]] virtual uint32_t MapCHRPage(uint8_t page) const noexcept override
+		{
+			// PPU $0000 - $1FFF: 8 KB CHR-ROM / RAM, no bank switching
+			assert(page < 8);
+			return page * 0x400u;
+		}
 
 
 		NROMMapper(NROMMapper const&) = delete;
@@ -0,0 +1,152 @@
+#ifndef NES_EMULATOR_SPSC_RING
+#define NES_EMULATOR_SPSC_RING
+
+#include "emulator_pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <span>
+
+namespace NesEm
+{
+	// Lock-free ring buffer for exactly one producer thread and one consumer thread
+	// Head and tail only ever move forward, each is written by one side and read by the other
+	template <typename T, std::size_t CAPACITY>
+	class SPSCRing final
+	{
+		static_assert(CAPACITY != 0 && (CAPACITY & (CAPACITY - 1)) == 0, "Capacity must be a power of 2");
+
+	public:
+		SPSCRing() = default;
+		~SPSCRing() = default;
+
+		// Producer side
+		// Return bool was there space for the element
+		[[nodiscard]] bool TryPush(T const& element) noexcept
+		{
+			std::size_t const head{ m_Head.load(std::memory_order_relaxed) };
+
+			// Only reload the consumer's position when the ring looks full
+			if (head - m_CachedTail == CAPACITY)
+			{
+				m_CachedTail = m_Tail.load(std::memory_order_acquire);
+				if (head - m_CachedTail == CAPACITY)
+				{
+					return false;
+				}
+			}
+
+			m_pElements[head & (CAPACITY - 1)] = element;
+			m_Head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Producer side, for streams of small elements (e.g. audio samples) where pushing one at a time costs an atomic store each
+		// Param std::span elements to push, in order
+		// Return std::size_t how many of them fit, the rest was not pushed
+		[[nodiscard]] std::size_t TryPushBulk(std::span<T const> elements) noexcept
+		{
+			std::size_t const head{ m_Head.load(std::memory_order_relaxed) };
+
+			if (CAPACITY - (head - m_CachedTail) < elements.size())
+			{
+				m_CachedTail = m_Tail.load(std::memory_order_acquire);
+			}
+
+			std::size_t const count{ std::min(elements.size(), CAPACITY - (head - m_CachedTail)) };
+			// The free space can wrap around the end of the storage
+			std::size_t const first{ std::min(count, CAPACITY - (head & (CAPACITY - 1))) };
+			std::copy_n(elements.begin(), first, m_pElements.get() + (head & (CAPACITY - 1)));
+			std::copy_n(elements.begin() + first, count - first, m_pElements.get());
+
+			m_Head.store(head + count, std::memory_order_release);
+			return count;
+		}
+
+		// Producer side, wakes the consumer if it is blocked in WaitForData
+		// Pushing does not notify by itself, so the producer decides how often it is worth the cost
+		void Notify() noexcept
+		{
+			m_Head.notify_one();
+		}
+
+		// Consumer side
+		// Param (out) the oldest element
+		// Return bool was there an element to pop
+		[[nodiscard]] bool TryPop(T& element) noexcept
+		{
+			std::size_t const tail{ m_Tail.load(std::memory_order_relaxed) };
+
+			if (tail == m_CachedHead)
+			{
+				m_CachedHead = m_Head.load(std::memory_order_acquire);
+				if (tail == m_CachedHead)
+				{
+					return false;
+				}
+			}
+
+			element = m_pElements[tail & (CAPACITY - 1)];
+			m_Tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer side
+		// Param std::span where to write the oldest elements
+		// Return std::size_t how many were popped, less than the span's size when the ring ran empty
+		[[nodiscard]] std::size_t TryPopBulk(std::span<T> elements) noexcept
+		{
+			std::size_t const tail{ m_Tail.load(std::memory_order_relaxed) };
+
+			if (m_CachedHead - tail < elements.size())
+			{
+				m_CachedHead = m_Head.load(std::memory_order_acquire);
+			}
+
+			std::size_t const count{ std::min(elements.size(), m_CachedHead - tail) };
+			std::size_t const first{ std::min(count, CAPACITY - (tail & (CAPACITY - 1))) };
+			std::copy_n(m_pElements.get() + (tail & (CAPACITY - 1)), first, elements.begin());
+			std::copy_n(m_pElements.get(), count - first, elements.begin() + first);
+
+			m_Tail.store(tail + count, std::memory_order_release);
+			return count;
+		}
+
+		// Consumer side, blocks until the producer pushed past what was consumed and notified
+		void WaitForData() const noexcept
+		{
+			m_Head.wait(m_Tail.load(std::memory_order_relaxed), std::memory_order_acquire);
+		}
+
+		// Return std::size_t elements currently in the ring, only a snapshot when the other side is active
+		[[nodiscard]] std::size_t Size() const noexcept
+		{
+			return m_Head.load(std::memory_order_acquire) - m_Tail.load(std::memory_order_acquire);
+		}
+
+		[[nodiscard]] static constexpr std::size_t Capacity() noexcept { return CAPACITY; }
+
+		SPSCRing(SPSCRing const&) = delete;
+		SPSCRing(SPSCRing&&) = delete;
+		SPSCRing& operator=(SPSCRing const&) = delete;
+		SPSCRing& operator=(SPSCRing&&) = delete;
+
+	private:
+		// Each side gets its own cache line so they don't keep invalidating each other
+		static constexpr std::size_t CACHE_LINE_SIZE{ 64 };
+
+		// Heap allocated, rings can be large and their owners often live on the stack
+		std::unique_ptr<T[]> m_pElements{ std::make_unique<T[]>(CAPACITY) };
+
+		alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_Head{ 0 };
+		// Producer's last known consumer position
+		std::size_t m_CachedTail{ 0 };
+
+		alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_Tail{ 0 };
+		// Consumer's last known producer position
+		std::size_t m_CachedHead{ 0 };
+	};
+}
+
+#endif
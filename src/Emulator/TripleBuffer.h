@@ -0,0 +1,90 @@
+#ifndef NES_EMULATOR_TRIPLE_BUFFER
+#define NES_EMULATOR_TRIPLE_BUFFER
+
+#include "emulator_pch.h"
+
+#include <array>
+#include <atomic>
+
+namespace NesEm
+{
+	// Lock-free hand over of the latest value from exactly one producer thread to one consumer thread, e.g. frames
+	// The producer fills the back buffer and publishes it by swapping it with the middle one, the consumer swaps
+	// the middle one with its front buffer when something new was published
+	// Neither side ever waits for the other, a value the consumer didn't fetch in time is replaced by the next one
+	template <typename T>
+	class TripleBuffer final
+	{
+	public:
+		TripleBuffer() = default;
+		~TripleBuffer() = default;
+
+		// Producer side
+		// Return T& buffer to fill, what it holds is whatever was published in it a few swaps ago
+		[[nodiscard]] T& Back() noexcept { return m_Buffers[m_Back]; }
+
+		// Producer side, hands the back buffer over and takes the middle one in its place
+		void Publish() noexcept
+		{
+			uint8_t const previous{ m_Middle.exchange(static_cast<uint8_t>(m_Back | NEW_FLAG), std::memory_order_acq_rel) };
+			m_Back = previous & INDEX_MASK;
+		}
+
+		// Producer side, wakes the consumer if it is blocked in WaitForPublish
+		// Publishing does not notify by itself, so the producer decides how often it is worth the cost
+		void Notify() noexcept
+		{
+			m_Middle.notify_one();
+		}
+
+		// Consumer side
+		// Return bool was something published since the last fetch, Front then holds the latest
+		[[nodiscard]] bool Fetch() noexcept
+		{
+			if ((m_Middle.load(std::memory_order_relaxed) & NEW_FLAG) == 0)
+			{
+				return false;
+			}
+
+			uint8_t const previous{ m_Middle.exchange(m_Front, std::memory_order_acq_rel) };
+			m_Front = previous & INDEX_MASK;
+			return true;
+		}
+
+		// Consumer side
+		// Return T const& the last fetched value, stays the same until the next successful Fetch
+		[[nodiscard]] T const& Front() const noexcept { return m_Buffers[m_Front]; }
+
+		// Consumer side, blocks until something was published since the last fetch and notified
+		void WaitForPublish() const noexcept
+		{
+			// Without the flag the middle holds exactly what the last fetch put there, any publish changes it
+			uint8_t const middle{ m_Middle.load(std::memory_order_relaxed) };
+			if ((middle & NEW_FLAG) == 0)
+			{
+				m_Middle.wait(middle, std::memory_order_acquire);
+			}
+		}
+
+		TripleBuffer(TripleBuffer const&) = delete;
+		TripleBuffer(TripleBuffer&&) = delete;
+		TripleBuffer& operator=(TripleBuffer const&) = delete;
+		TripleBuffer& operator=(TripleBuffer&&) = delete;
+
+	private:
+		// The middle buffer's index in the low bits, the flag marks a publish the consumer didn't fetch yet
+		static constexpr uint8_t INDEX_MASK{ 0x03 };
+		static constexpr uint8_t NEW_FLAG{ 0x04 };
+
+		// Each side gets its own cache line so they don't keep invalidating each other
+		static constexpr std::size_t CACHE_LINE_SIZE{ 64 };
+
+		std::array<T, 3> m_Buffers{ };
+
+		alignas(CACHE_LINE_SIZE) std::atomic<uint8_t> m_Middle{ 1 };
+		alignas(CACHE_LINE_SIZE) uint8_t m_Back{ 0 };
+		alignas(CACHE_LINE_SIZE) uint8_t m_Front{ 2 };
+	};
+}
+
+#endif
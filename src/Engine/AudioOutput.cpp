@@ -0,0 +1,166 @@
+#include "AudioOutput.h"
+
+#include <algorithm>
+#include <array>
+
+namespace NesEm
+{
+	AudioOutput::AudioOutput(uint32_t sampleRate, uint32_t latencyMs):
+		m_SampleRate{ sampleRate }
+	{
+		SetLatency(latencyMs);
+
+		if (!SDL_InitSubSystem(SDL_INIT_AUDIO))
+		{
+			SDL_Log("Could not initialize audio, running without sound: %s", SDL_GetError());
+			return;
+		}
+
+		SDL_AudioSpec const spec{ SDL_AUDIO_S16, 1, static_cast<int>(sampleRate) };
+		m_pStream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, &AudioOutput::FeedDevice, this);
+		if (!m_pStream)
+		{
+			SDL_Log("Could not open an audio device, running without sound: %s", SDL_GetError());
+			SDL_QuitSubSystem(SDL_INIT_AUDIO);
+			return;
+		}
+
+		// Devices open paused
+		SDL_ResumeAudioStreamDevice(m_pStream);
+		SDL_Log("Audio initialized: %u Hz, %u ms latency", sampleRate, m_LatencyMs);
+	}
+
+	AudioOutput::~AudioOutput()
+	{
+		if (m_pStream)
+		{
+			// Also stops the callbacks, nothing touches the ring after this
+			SDL_DestroyAudioStream(m_pStream);
+			SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		}
+	}
+
+	uint32_t AudioOutput::QueueSamples(std::span<int16_t const> samples) noexcept
+	{
+		if (!m_pStream || samples.empty())
+		{
+			return 0;
+		}
+
+		// Keep the queue within the latency, not just within the ring
+		std::size_t const queued{ m_Ring.Size() };
+		std::size_t const latency{ LatencySamples() };
+		std::size_t const space{ latency > queued ? latency - queued : 0 };
+
+		std::size_t const pushed{ m_Ring.TryPushBulk(samples.first(std::min(space, samples.size()))) };
+		if (pushed < samples.size())
+		{
+			++m_Overruns;
+			m_OverrunSamples += samples.size() - pushed;
+		}
+
+		// Halfway between before and after the push, the level the device sees on average until the next call
+		UpdateRateControl((static_cast<float>(queued) + static_cast<float>(pushed) / 2.f) / static_cast<float>(latency));
+		return static_cast<uint32_t>(pushed);
+	}
+
+	void AudioOutput::UpdateRateControl(float fill) noexcept
+	{
+		constexpr double SMOOTHING{ 1.0 / 8.0 };
+		// Calls (frames) for the learned offset to follow a constant error, about 10 seconds
+		constexpr double INTEGRAL_GAIN{ 1.0 / 512.0 };
+
+		m_SmoothedFill += (fill - m_SmoothedFill) * SMOOTHING;
+		double const error{ std::clamp(1.0 - 2.0 * m_SmoothedFill, -1.0, 1.0) };
+
+		// Proportional to the distance from half full, the full deviation is reached at empty and full
+		// On its own that settles off center, the integral learns the constant clock mismatch so the queue settles at half full
+		m_RateOffset = std::clamp(m_RateOffset + MAX_RATE_DEVIATION * error * INTEGRAL_GAIN, -MAX_RATE_DEVIATION, MAX_RATE_DEVIATION);
+		m_RateRatio = 1.0 + std::clamp(MAX_RATE_DEVIATION * error + m_RateOffset, -MAX_RATE_DEVIATION, MAX_RATE_DEVIATION);
+
+		FillStatistics& stats{ m_FillStats };
+		stats.min = (stats.measurements == 0) ? fill : std::min(stats.min, fill);
+		stats.max = (stats.measurements == 0) ? fill : std::max(stats.max, fill);
+		++stats.measurements;
+		stats.average += (fill - stats.average) / static_cast<float>(stats.measurements);
+	}
+
+	void AudioOutput::WaitForSpace(uint32_t samples) const noexcept
+	{
+		if (!m_pStream)
+		{
+			return;
+		}
+
+		while (true)
+		{
+			// Read before the level, a pop in between changes it and the wait returns right away
+			uint32_t const consumed{ m_Consumed.load(std::memory_order_acquire) };
+			std::size_t const queued{ m_Ring.Size() };
+			std::size_t const latency{ LatencySamples() };
+			if (queued + samples <= latency || queued < latency / 2)
+			{
+				return;
+			}
+			m_Consumed.wait(consumed, std::memory_order_acquire);
+		}
+	}
+
+	void AudioOutput::SetLatency(uint32_t latencyMs) noexcept
+	{
+		uint32_t const maxLatencyMs{ static_cast<uint32_t>(RING_CAPACITY * 1000 / m_SampleRate) };
+		m_LatencyMs = std::clamp(latencyMs, 1u, maxLatencyMs);
+		m_LatencySamples.store(static_cast<uint32_t>(static_cast<uint64_t>(m_LatencyMs) * m_SampleRate / 1000), std::memory_order_relaxed);
+	}
+
+	void SDLCALL AudioOutput::FeedDevice(void* pUserData, SDL_AudioStream* pStream, int additionalAmount, [[maybe_unused]] int totalAmount)
+	{
+		if (additionalAmount > 0)
+		{
+			static_cast<AudioOutput*>(pUserData)->Feed(pStream, static_cast<uint32_t>(additionalAmount) / sizeof(int16_t));
+		}
+	}
+
+	void AudioOutput::Feed(SDL_AudioStream* pStream, uint32_t samples) noexcept
+	{
+		if (!m_IsPrimed)
+		{
+			m_IsPrimed = m_Ring.Size() >= LatencySamples() / 2;
+		}
+
+		std::array<int16_t, CHUNK_SIZE> chunk{ };
+		bool hasConsumed{ false };
+		while (samples > 0)
+		{
+			uint32_t const wanted{ std::min(samples, CHUNK_SIZE) };
+			uint32_t popped{ 0 };
+			if (m_IsPrimed)
+			{
+				popped = static_cast<uint32_t>(m_Ring.TryPopBulk(std::span{ chunk }.first(wanted)));
+				if (popped > 0)
+				{
+					m_LastSample = chunk[popped - 1];
+					hasConsumed = true;
+				}
+
+				if (popped < wanted)
+				{
+					m_Underruns.fetch_add(1, std::memory_order_relaxed);
+					m_UnderrunSamples.fetch_add(wanted - popped, std::memory_order_relaxed);
+					m_IsPrimed = false;
+				}
+			}
+
+			// Holding the last level instead of dropping to 0 avoids a click
+			std::fill(chunk.begin() + popped, chunk.begin() + wanted, m_LastSample);
+			SDL_PutAudioStreamData(pStream, chunk.data(), static_cast<int>(wanted * sizeof(int16_t)));
+			samples -= wanted;
+		}
+
+		if (hasConsumed)
+		{
+			m_Consumed.fetch_add(1, std::memory_order_release);
+			m_Consumed.notify_one();
+		}
+	}
+}
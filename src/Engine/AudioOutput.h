@@ -0,0 +1,133 @@
+#ifndef NES_EMULATOR_AUDIO_OUTPUT
+#define NES_EMULATOR_AUDIO_OUTPUT
+
+#include "SPSCRing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+#include <SDL3/SDL.h>
+
+namespace NesEm
+{
+	// Plays the emulator's samples on the default audio device through an SDL audio stream
+	// The emulation thread queues samples into a lock-free ring, SDL's audio thread pulls them out when the device needs more
+	// Neither side locks or allocates, so a slow frame can't stall the device and the device can't stall the emulation
+	//
+	// Latency is the most audio queued ahead of the device: more rides out longer hitches, less makes sound follow input sooner
+	// Samples that would go past it are dropped (overrun), the device running dry plays the last sample held (underrun)
+	//
+	// The emulated machine's frame rate never exactly matches the host's display and audio clocks, so the queue slowly fills or drains
+	// RateRatio steers it back to half full: the producer scales its sample rate by it, by at most MAX_RATE_DEVIATION (inaudible)
+	// Or the other way around, WaitForSpace lets the device's clock pace the producer, then the rate has to stay as it is
+	class AudioOutput final
+	{
+	public:
+		static constexpr uint32_t DEFAULT_LATENCY_MS{ 60 };
+		// Largest change of the producer's sample rate dynamic rate control asks for, 0.5%
+		static constexpr double MAX_RATE_DEVIATION{ 0.005 };
+
+		// Queue level relative to the latency (0 empty, 1 full), measured every QueueSamples call since the last reset
+		struct FillStatistics final
+		{
+			float average{ 0.f };
+			float min{ 0.f };
+			float max{ 0.f };
+			uint64_t measurements{ 0 };
+		};
+
+		// Param uint32_t rate of the queued samples in Hz, mono int16_t
+		// Param uint32_t latency in milliseconds, limited to what the ring holds
+		// Without an audio device it still accepts samples, they are dropped
+		explicit AudioOutput(uint32_t sampleRate, uint32_t latencyMs = DEFAULT_LATENCY_MS);
+		~AudioOutput();
+
+		AudioOutput(AudioOutput const&) = delete;
+		AudioOutput(AudioOutput&&) = delete;
+		AudioOutput& operator=(AudioOutput const&) = delete;
+		AudioOutput& operator=(AudioOutput&&) = delete;
+
+		// Return bool was an audio device opened
+		[[nodiscard]] bool IsOpen() const noexcept { return m_pStream != nullptr; }
+
+		// Emulation thread side
+		// Param std::span samples to play
+		// Return uint32_t samples queued, the rest did not fit within the latency and was dropped
+		uint32_t QueueSamples(std::span<int16_t const> samples) noexcept;
+
+		// Param uint32_t samples about to be queued
+		// Blocks (without spinning) until they fit within the latency, returns right away without a device
+		// Doesn't wait while the queue is below half the latency, the device only starts taking samples from there
+		// SDL keeps calling back for a device that was unplugged, so it never waits longer than the latency
+		void WaitForSpace(uint32_t samples) const noexcept;
+
+		// Param uint32_t latency in milliseconds, limited to what the ring holds
+		void SetLatency(uint32_t latencyMs) noexcept;
+		[[nodiscard]] uint32_t LatencyMs() const noexcept { return m_LatencyMs; }
+		// Return uint32_t latency in samples, the most that is queued at once
+		[[nodiscard]] uint32_t LatencySamples() const noexcept { return m_LatencySamples.load(std::memory_order_relaxed); }
+
+		// Return uint32_t samples waiting for the device, only a snapshot while it plays
+		[[nodiscard]] uint32_t QueuedSamples() const noexcept { return static_cast<uint32_t>(m_Ring.Size()); }
+		[[nodiscard]] uint32_t SampleRate() const noexcept { return m_SampleRate; }
+
+		// Return double factor to scale the rate samples are produced at by (1 +- MAX_RATE_DEVIATION), updated by QueueSamples
+		// Above 1 when the queue is less than half full, so the producer makes more samples per emulated frame
+		[[nodiscard]] double RateRatio() const noexcept { return m_RateRatio; }
+		[[nodiscard]] FillStatistics const& FillStats() const noexcept { return m_FillStats; }
+		void ResetFillStats() noexcept { m_FillStats = { }; }
+
+		// Return uint64_t times the device asked for more samples than were queued
+		[[nodiscard]] uint64_t UnderrunCount() const noexcept { return m_Underruns.load(std::memory_order_relaxed); }
+		// Return uint64_t samples the device played as filler because the queue ran dry
+		[[nodiscard]] uint64_t UnderrunSamples() const noexcept { return m_UnderrunSamples.load(std::memory_order_relaxed); }
+		// Return uint64_t times queued samples did not fit
+		[[nodiscard]] uint64_t OverrunCount() const noexcept { return m_Overruns; }
+		// Return uint64_t samples dropped because they did not fit
+		[[nodiscard]] uint64_t OverrunSamples() const noexcept { return m_OverrunSamples; }
+
+	private:
+		// About 340ms at 48 kHz, the most latency that can be asked for
+		static constexpr std::size_t RING_CAPACITY{ 16384 };
+		// Samples copied per SDL_PutAudioStreamData call, from a stack buffer
+		static constexpr uint32_t CHUNK_SIZE{ 512 };
+
+		uint32_t const m_SampleRate;
+		uint32_t m_LatencyMs{ 0 };
+		std::atomic<uint32_t> m_LatencySamples{ 0 };
+
+		// Emulation thread -> audio thread
+		SPSCRing<int16_t, RING_CAPACITY> m_Ring{ };
+
+		// Emulation thread side
+		uint64_t m_Overruns{ 0 };
+		uint64_t m_OverrunSamples{ 0 };
+		// The level jumps by a device callback's worth of samples, the ratio follows a smoothed level so the pitch doesn't wobble
+		double m_SmoothedFill{ 0.5 };
+		// Learned mismatch between the emulated and host clocks
+		double m_RateOffset{ 0.0 };
+		double m_RateRatio{ 1.0 };
+		FillStatistics m_FillStats{ };
+
+		// Audio thread side
+		// Waits for the queue to fill to half the latency before playing, at the start and after running dry
+		bool m_IsPrimed{ false };
+		int16_t m_LastSample{ 0 };
+		std::atomic<uint64_t> m_Underruns{ 0 };
+		std::atomic<uint64_t> m_UnderrunSamples{ 0 };
+		// Bumped every time samples are taken out of the ring, WaitForSpace waits for it to change
+		std::atomic<uint32_t> m_Consumed{ 0 };
+
+		SDL_AudioStream* m_pStream{ nullptr };
+
+		// Called by SDL on its audio thread whenever the device needs more data
+		static void SDLCALL FeedDevice(void* pUserData, SDL_AudioStream* pStream, int additionalAmount, int totalAmount);
+		void Feed(SDL_AudioStream* pStream, uint32_t samples) noexcept;
+
+		// Param float queue level relative to the latency
+		void UpdateRateControl(float fill) noexcept;
+	};
+}
+
+#endif
@@ -0,0 +1,195 @@
+#include "AudioRecorder.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+
+namespace NesEm
+{
+	AudioRecorder::Format AudioRecorder::FormatOf(std::filesystem::path const& path)
+	{
+		std::string extension{ path.extension().string() };
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".wav" ? Format::WAV : Format::Raw;
+	}
+
+	AudioRecorder::AudioRecorder(std::filesystem::path const& path, uint32_t sampleRate, Format format):
+		m_Format{ format },
+		m_SampleRate{ sampleRate }
+	{
+		m_File.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+		if (!m_File.is_open())
+		{
+			throw std::runtime_error("Can not create audio file: " + path.string());
+		}
+
+		if (m_Format == Format::WAV)
+		{
+			// Sizes are unknown until the end, a file cut off by a crash still has a valid header
+			WriteWAVHeader(0);
+		}
+
+		m_Buffers.resize(BUFFER_COUNT);
+		for (uint8_t buffer{ 0 }; buffer < BUFFER_COUNT; ++buffer)
+		{
+			m_Buffers[buffer].resize(BUFFER_SAMPLES);
+
+			// The first buffer is being filled, the others are free, after this only the writer pushes
+			if (buffer != m_Buffer)
+			{
+				[[maybe_unused]] bool const pushed{ m_FreeBuffers.TryPush(buffer) };
+				assert(pushed);
+			}
+		}
+
+		m_Thread = std::thread{ &AudioRecorder::Run, this };
+	}
+
+	AudioRecorder::~AudioRecorder()
+	{
+		if (m_BufferFill > 0)
+		{
+			[[maybe_unused]] bool const pushed{ m_Jobs.TryPush({ Job::Type::Write, m_Buffer, m_BufferFill }) };
+			assert(pushed);
+		}
+
+		// Only buffers taken from the pool are queued, so the stop always fits
+		[[maybe_unused]] bool const pushed{ m_Jobs.TryPush({ Job::Type::Stop }) };
+		assert(pushed);
+		m_Jobs.Notify();
+
+		m_Thread.join();
+	}
+
+	void AudioRecorder::SubmitSamples(std::span<int16_t const> samples) noexcept
+	{
+		while (!samples.empty())
+		{
+			uint32_t const count{ static_cast<uint32_t>(std::min<size_t>(samples.size(), BUFFER_SAMPLES - m_BufferFill)) };
+			std::copy_n(samples.begin(), count, m_Buffers[m_Buffer].begin() + m_BufferFill);
+			m_BufferFill += count;
+			samples = samples.subspan(count);
+
+			if (m_BufferFill == BUFFER_SAMPLES)
+			{
+				SwapBuffers();
+			}
+		}
+	}
+
+	void AudioRecorder::SwapBuffers() noexcept
+	{
+		[[maybe_unused]] bool const pushed{ m_Jobs.TryPush({ Job::Type::Write, m_Buffer, m_BufferFill }) };
+		assert(pushed);
+		m_Jobs.Notify();
+
+		if (!m_FreeBuffers.TryPop(m_Buffer))
+		{
+			// The disk is slower than the samples come in, a recording can't skip any
+			++m_Stalls;
+			while (!m_FreeBuffers.TryPop(m_Buffer))
+			{
+				m_FreeBuffers.WaitForData();
+			}
+		}
+		m_BufferFill = 0;
+	}
+
+	void AudioRecorder::Run() noexcept
+	{
+		Job job{ };
+		while (true)
+		{
+			if (!m_Jobs.TryPop(job))
+			{
+				m_Jobs.WaitForData();
+				continue;
+			}
+
+			if (job.type == Job::Type::Stop)
+			{
+				if (m_Format == Format::WAV)
+				{
+					WriteWAVHeader(m_WrittenSamples.load(std::memory_order_relaxed));
+				}
+				m_File.flush();
+				return;
+			}
+
+			Write(job);
+
+			[[maybe_unused]] bool const pushed{ m_FreeBuffers.TryPush(job.buffer) };
+			assert(pushed);
+			m_FreeBuffers.Notify();
+		}
+	}
+
+	void AudioRecorder::Write(Job const& job) noexcept
+	{
+		std::vector<int16_t>& buffer{ m_Buffers[job.buffer] };
+		if constexpr (std::endian::native == std::endian::big)
+		{
+			std::transform(buffer.begin(), buffer.begin() + job.sampleCount, buffer.begin(), [](int16_t sample) { return std::byteswap(sample); });
+		}
+
+		m_File.write(reinterpret_cast<char const*>(buffer.data()), static_cast<std::streamsize>(job.sampleCount * sizeof(int16_t)));
+		if (!m_File && !m_HasWriteError)
+		{
+			SDL_Log("%s", "Could not write to the audio file, the rest of the recording is lost");
+			m_HasWriteError = true;
+		}
+
+		m_WrittenSamples.fetch_add(job.sampleCount, std::memory_order_relaxed);
+	}
+
+	void AudioRecorder::WriteWAVHeader(uint64_t sampleCount) noexcept
+	{
+		constexpr uint32_t BYTES_PER_SAMPLE{ sizeof(int16_t) };
+		// Sizes past what the fields hold are stored as their maximum
+		uint32_t const dataSize{ static_cast<uint32_t>(std::min<uint64_t>(sampleCount * BYTES_PER_SAMPLE, UINT32_MAX - (WAV_HEADER_SIZE - 8))) };
+
+		std::array<uint8_t, WAV_HEADER_SIZE> header{ };
+		size_t offset{ 0 };
+		auto const append{ [&header, &offset](uint32_t value, uint32_t bytes)
+		{
+			for (uint32_t i{ 0 }; i < bytes; ++i)
+			{
+				header[offset++] = static_cast<uint8_t>(value >> (i * 8));
+			}
+		} };
+		auto const appendTag{ [&header, &offset](char const (&tag)[5])
+		{
+			std::copy_n(tag, 4, header.begin() + offset);
+			offset += 4;
+		} };
+
+		appendTag("RIFF");
+		append(dataSize + (WAV_HEADER_SIZE - 8), 4);
+		appendTag("WAVE");
+
+		appendTag("fmt ");
+		append(16, 4);
+		// PCM, mono
+		append(1, 2);
+		append(1, 2);
+		append(m_SampleRate, 4);
+		append(m_SampleRate * BYTES_PER_SAMPLE, 4);
+		append(BYTES_PER_SAMPLE, 2);
+		append(BYTES_PER_SAMPLE * 8, 2);
+
+		appendTag("data");
+		append(dataSize, 4);
+		assert(offset == header.size());
+
+		std::streampos const end{ m_File.tellp() };
+		m_File.seekp(0);
+		m_File.write(reinterpret_cast<char const*>(header.data()), static_cast<std::streamsize>(header.size()));
+		if (end > std::streampos{ static_cast<std::streamoff>(header.size()) })
+		{
+			m_File.seekp(end);
+		}
+	}
+}
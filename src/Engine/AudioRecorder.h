@@ -0,0 +1,112 @@
+#ifndef NES_EMULATOR_AUDIO_RECORDER
+#define NES_EMULATOR_AUDIO_RECORDER
+
+#include "SPSCRing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <thread>
+#include <vector>
+
+/* Sources used during development of the audio recorder:
+ * http://soundfile.sapp.org/doc/WaveFormat/
+ */
+
+namespace NesEm
+{
+	// Streams 16 bit mono samples to a file, bit exact, e.g. to log a run's audio next to its frame hashes
+	// Double buffered: submitting only copies into the buffer being filled, once it is full a background thread writes it
+	// in one large sequential write while the other one fills up
+	// Nothing is ever dropped, submitting waits when the writer still has the other buffer (see StallCount)
+	//
+	// WAV files get a 44 byte PCM header whose sizes are filled in when the recorder is destroyed,
+	// they saturate at 4GB (over 20 minutes of the APU's raw output), players then read up to the end of the file
+	// Raw files are just the samples, little endian
+	class AudioRecorder final
+	{
+	public:
+		static constexpr uint32_t WAV_HEADER_SIZE{ 44 };
+
+		enum class Format : uint8_t
+		{
+			WAV,
+			Raw
+		};
+
+		// Return Format WAV for a .wav extension, raw otherwise
+		[[nodiscard]] static Format FormatOf(std::filesystem::path const& path);
+
+		// Param std::filesystem::path file to create, an existing one is overwritten
+		// Param uint32_t samples per second, stored in the WAV header
+		// Param Format file format
+		// Throws std::runtime_error when the file can not be created
+		AudioRecorder(std::filesystem::path const& path, uint32_t sampleRate, Format format = Format::WAV);
+		// Writes the samples still buffered and finishes the header
+		~AudioRecorder();
+
+		AudioRecorder(AudioRecorder const&) = delete;
+		AudioRecorder(AudioRecorder&&) = delete;
+		AudioRecorder& operator=(AudioRecorder const&) = delete;
+		AudioRecorder& operator=(AudioRecorder&&) = delete;
+
+		// Param std::span samples to append, any amount
+		void SubmitSamples(std::span<int16_t const> samples) noexcept;
+
+		// Return uint64_t samples the writer stored so far
+		[[nodiscard]] uint64_t WrittenSampleCount() const noexcept { return m_WrittenSamples.load(std::memory_order_relaxed); }
+		// Return uint64_t times a submit had to wait for the writer to hand back a buffer
+		[[nodiscard]] uint64_t StallCount() const noexcept { return m_Stalls; }
+
+	private:
+		// Samples per buffer, 1MB: 11 seconds of 48 kHz output, a third of a second of the APU's output of every cycle
+		static constexpr uint32_t BUFFER_SAMPLES{ 1u << 19 };
+		static constexpr uint32_t BUFFER_COUNT{ 2 };
+
+		struct Job final
+		{
+			enum class Type : uint8_t
+			{
+				Write,
+				Stop
+			};
+
+			Type type{ Type::Stop };
+			uint8_t buffer{ 0 };
+			uint32_t sampleCount{ 0 };
+		};
+
+		Format const m_Format;
+		uint32_t const m_SampleRate;
+
+		std::vector<std::vector<int16_t>> m_Buffers{ };
+		// Frontend -> writer, room for every buffer and the stop
+		SPSCRing<Job, BUFFER_COUNT * 2> m_Jobs{ };
+		// Writer -> frontend, buffers that can be filled again
+		SPSCRing<uint8_t, BUFFER_COUNT> m_FreeBuffers{ };
+
+		// Frontend side
+		uint8_t m_Buffer{ 0 };
+		uint32_t m_BufferFill{ 0 };
+		uint64_t m_Stalls{ 0 };
+
+		// Writer side
+		std::ofstream m_File{ };
+		bool m_HasWriteError{ false };
+		std::atomic<uint64_t> m_WrittenSamples{ 0 };
+
+		std::thread m_Thread{ };
+
+		// Hands the buffer being filled to the writer and takes the other one
+		void SwapBuffers() noexcept;
+
+		void Run() noexcept;
+		void Write(Job const& job) noexcept;
+		// Param uint64_t samples in the file
+		void WriteWAVHeader(uint64_t sampleCount) noexcept;
+	};
+}
+
+#endif
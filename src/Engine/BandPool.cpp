@@ -0,0 +1,87 @@
+#include "BandPool.h"
+
+#include <algorithm>
+
+namespace NesEm
+{
+	BandPool::BandPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+		{
+			// The emulation and PPU render threads keep their own cores busy
+			threadCount = std::max(std::thread::hardware_concurrency() / 2, 1u);
+		}
+		threadCount = std::clamp(threadCount, 1u, MAX_THREADS);
+
+		// The calling thread takes band 0
+		m_Workers.reserve(threadCount - 1);
+		for (uint32_t band{ 1 }; band < threadCount; ++band)
+		{
+			m_Workers.emplace_back(&BandPool::RunWorker, this, band);
+		}
+	}
+
+	BandPool::~BandPool()
+	{
+		m_Stop.store(true, std::memory_order_relaxed);
+		m_Generation.fetch_add(1, std::memory_order_release);
+		m_Generation.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void BandPool::Dispatch() noexcept
+	{
+		if (!m_Workers.empty())
+		{
+			m_BandsLeft.store(static_cast<uint32_t>(m_Workers.size()), std::memory_order_relaxed);
+			m_Generation.fetch_add(1, std::memory_order_release);
+			m_Generation.notify_all();
+		}
+
+		RunBand(0);
+
+		for (uint32_t left{ m_BandsLeft.load(std::memory_order_acquire) }; left != 0; left = m_BandsLeft.load(std::memory_order_acquire))
+		{
+			m_BandsLeft.wait(left, std::memory_order_acquire);
+		}
+	}
+
+	void BandPool::RunWorker(uint32_t band) noexcept
+	{
+		uint32_t generation{ 0 };
+		while (true)
+		{
+			m_Generation.wait(generation, std::memory_order_acquire);
+			generation = m_Generation.load(std::memory_order_acquire);
+
+			if (m_Stop.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			RunBand(band);
+
+			if (m_BandsLeft.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				m_BandsLeft.notify_one();
+			}
+		}
+	}
+
+	void BandPool::RunBand(uint32_t band) noexcept
+	{
+		uint32_t const bands{ ThreadCount() };
+		uint32_t const first{ m_Rows * band / bands };
+		uint32_t const last{ m_Rows * (band + 1) / bands };
+
+		// More threads than rows leaves some bands empty
+		if (first < last)
+		{
+			m_pInvoke(m_pJob, first, last);
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef NES_EMULATOR_BAND_POOL
+#define NES_EMULATOR_BAND_POOL
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace NesEm
+{
+	// Splits per frame image work into horizontal bands of rows, the calling thread takes the first band and persistent workers the others
+	// Workers sleep on an atomic between jobs, so a pool costs nothing while it is not running
+	class BandPool final
+	{
+	public:
+		// Param uint32_t threads the bands are split over including the calling one, 0 picks an amount based on the hardware
+		explicit BandPool(uint32_t threadCount = 0);
+		~BandPool();
+
+		BandPool(BandPool const&) = delete;
+		BandPool(BandPool&&) = delete;
+		BandPool& operator=(BandPool const&) = delete;
+		BandPool& operator=(BandPool&&) = delete;
+
+		[[nodiscard]] uint32_t ThreadCount() const noexcept { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+		// Param uint32_t rows to split over the threads
+		// Param Job callable as job(uint32_t firstRow, uint32_t lastRow), once per band with an exclusive lastRow
+		// Blocks until every band is done, the job may reference locals of the caller
+		template <typename Job>
+		void Run(uint32_t rows, Job&& job) noexcept
+		{
+			m_Rows = rows;
+			m_pJob = &job;
+			m_pInvoke = [](void* pJob, uint32_t first, uint32_t last) { (*static_cast<std::remove_reference_t<Job>*>(pJob))(first, last); };
+
+			Dispatch();
+		}
+
+	private:
+		static constexpr uint32_t MAX_THREADS{ 8 };
+
+		// Job of the current run, written before m_Generation is bumped
+		uint32_t m_Rows{ 0 };
+		void* m_pJob{ nullptr };
+		void (*m_pInvoke)(void*, uint32_t, uint32_t) { nullptr };
+
+		std::vector<std::thread> m_Workers{ };
+		std::atomic<uint32_t> m_Generation{ 0 };
+		std::atomic<uint32_t> m_BandsLeft{ 0 };
+		std::atomic<bool> m_Stop{ false };
+
+		void Dispatch() noexcept;
+		void RunWorker(uint32_t band) noexcept;
+		void RunBand(uint32_t band) noexcept;
+	};
+}
+
+#endif
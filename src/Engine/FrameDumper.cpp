@@ -0,0 +1,207 @@
+#include "FrameDumper.h"
+
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace NesEm
+{
+	namespace
+	{
+		// Param std::string_view file name, param std::string_view what comes before the number
+		// Return bool does the name start with the prefix followed by a number, which is then stored in value
+		template <typename T>
+		[[nodiscard]] bool ParseNumberAfter(std::string_view name, std::string_view prefix, T& value) noexcept
+		{
+			if (!name.starts_with(prefix))
+			{
+				return false;
+			}
+
+			name.remove_prefix(prefix.size());
+			return std::from_chars(name.data(), name.data() + name.size(), value).ec == std::errc{ };
+		}
+	}
+
+	FrameDumper::FrameDumper(uint32_t width, uint32_t height, std::filesystem::path directory, Format format):
+		m_Width{ width },
+		m_Height{ height },
+		m_Directory{ std::move(directory) },
+		m_Format{ format }
+	{
+		m_Buffers.resize(POOL_SIZE);
+		for (uint8_t buffer{ 0 }; buffer < POOL_SIZE; ++buffer)
+		{
+			m_Buffers[buffer].resize(static_cast<size_t>(m_Width) * m_Height);
+
+			// Filled before the writer starts, after that only the writer pushes
+			[[maybe_unused]] bool const pushed{ m_FreeBuffers.TryPush(buffer) };
+			assert(pushed);
+		}
+
+		ContinueNumbering();
+
+		m_Thread = std::thread{ &FrameDumper::Run, this };
+	}
+
+	FrameDumper::~FrameDumper()
+	{
+		Job const stop{ Job::Type::Stop };
+		while (!m_Jobs.TryPush(stop))
+		{
+			std::this_thread::yield();
+		}
+		m_Jobs.Notify();
+
+		m_Thread.join();
+	}
+
+	bool FrameDumper::Screenshot(std::span<uint32_t const> pixels) noexcept
+	{
+		if (!Queue(Job::Type::Screenshot, 0, m_ScreenshotCount, pixels))
+		{
+			return false;
+		}
+
+		++m_ScreenshotCount;
+		return true;
+	}
+
+	void FrameDumper::StartSequence() noexcept
+	{
+		if (!m_IsRecording)
+		{
+			m_IsRecording = true;
+			++m_SequenceCount;
+			m_SequenceFrame = 0;
+		}
+	}
+
+	void FrameDumper::SubmitFrame(std::span<uint32_t const> pixels) noexcept
+	{
+		if (m_IsRecording)
+		{
+			// Dropped frames keep their number, so gaps show in the file names
+			static_cast<void>(Queue(Job::Type::Sequence, m_SequenceCount, m_SequenceFrame++, pixels));
+		}
+	}
+
+	void FrameDumper::ContinueNumbering() noexcept
+	{
+		// A directory that doesn't exist yet has nothing to continue from
+		std::error_code error{ };
+		try
+		{
+			for (std::filesystem::directory_iterator it{ m_Directory, error }, end{ }; !error && it != end; it.increment(error))
+			{
+				std::string const name{ it->path().filename().string() };
+
+				uint64_t screenshot{ 0 };
+				uint32_t sequence{ 0 };
+				if (ParseNumberAfter(name, "screenshot_", screenshot))
+				{
+					m_ScreenshotCount = std::max(m_ScreenshotCount, screenshot + 1);
+				}
+				else if (ParseNumberAfter(name, "sequence", sequence))
+				{
+					// StartSequence counts up before the first frame
+					m_SequenceCount = std::max(m_SequenceCount, sequence);
+				}
+			}
+		}
+		catch (std::exception const& e)
+		{
+			SDL_Log("Could not read the frame directory, files may be overwritten: %s", e.what());
+		}
+	}
+
+	bool FrameDumper::Queue(Job::Type type, uint32_t sequence, uint64_t index, std::span<uint32_t const> pixels) noexcept
+	{
+		assert(pixels.size() >= static_cast<size_t>(m_Width) * m_Height);
+
+		uint8_t buffer{ 0 };
+		if (!m_FreeBuffers.TryPop(buffer))
+		{
+			++m_DroppedFrames;
+			return false;
+		}
+
+		std::copy_n(pixels.begin(), m_Buffers[buffer].size(), m_Buffers[buffer].begin());
+
+		// A job only exists for a buffer taken from the pool, so there is always space for it
+		[[maybe_unused]] bool const pushed{ m_Jobs.TryPush({ type, buffer, sequence, index }) };
+		assert(pushed);
+		m_Jobs.Notify();
+		return true;
+	}
+
+	void FrameDumper::Run() noexcept
+	{
+		Job job{ };
+		while (true)
+		{
+			if (!m_Jobs.TryPop(job))
+			{
+				m_Jobs.WaitForData();
+				continue;
+			}
+
+			if (job.type == Job::Type::Stop)
+			{
+				return;
+			}
+
+			Write(job);
+
+			[[maybe_unused]] bool const pushed{ m_FreeBuffers.TryPush(job.buffer) };
+			assert(pushed);
+		}
+	}
+
+	void FrameDumper::Write(Job const& job) noexcept
+	{
+		std::array<char, 64> name{ };
+		char const* const extension{ m_Format == Format::PNG ? "png" : "ppm" };
+		if (job.type == Job::Type::Screenshot)
+		{
+			std::snprintf(name.data(), name.size(), "screenshot_%04llu.%s", static_cast<unsigned long long>(job.index), extension);
+		}
+		else
+		{
+			std::snprintf(name.data(), name.size(), "sequence%03u_%06llu.%s", job.sequence, static_cast<unsigned long long>(job.index), extension);
+		}
+
+		try
+		{
+			if (!m_HasDirectory)
+			{
+				std::filesystem::create_directories(m_Directory);
+				m_HasDirectory = true;
+			}
+
+			std::span<uint32_t const> const pixels{ m_Buffers[job.buffer] };
+			std::vector<uint8_t> const file{ m_Format == Format::PNG
+				? ImageWriter::EncodePNG(pixels, m_Width, m_Height)
+				: ImageWriter::EncodePPM(pixels, m_Width, m_Height) };
+
+			std::filesystem::path const path{ m_Directory / name.data() };
+			if (!ImageWriter::WriteFile(path, file))
+			{
+				SDL_Log("Could not write frame: %s", path.string().c_str());
+				return;
+			}
+		}
+		catch (std::exception const& e)
+		{
+			SDL_Log("Could not encode frame: %s", e.what());
+			return;
+		}
+
+		m_WrittenFrames.fetch_add(1, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,114 @@
+#ifndef NES_EMULATOR_FRAME_DUMPER
+#define NES_EMULATOR_FRAME_DUMPER
+
+#include "SPSCRing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace NesEm
+{
+	// Saves frames as image files without stalling the frame it is called from
+	// A capture only copies the frame into a free buffer of a fixed pool and queues it,
+	// a background thread encodes and writes it and hands the buffer back
+	// When every buffer is still queued the frame is dropped instead of waiting
+	class FrameDumper final
+	{
+	public:
+		enum class Format : uint8_t
+		{
+			PNG,
+			PPM // Uncompressed, cheapest to write
+		};
+
+		// Param uint32_t, uint32_t size of the frames in pixels
+		// Param std::filesystem::path directory the files are written to, created with the first file
+		// Numbering continues after the files already in it, earlier sessions are never overwritten
+		// Param Format file format
+		FrameDumper(uint32_t width, uint32_t height, std::filesystem::path directory, Format format = Format::PNG);
+		// Finishes writing every queued frame
+		~FrameDumper();
+
+		FrameDumper(FrameDumper const&) = delete;
+		FrameDumper(FrameDumper&&) = delete;
+		FrameDumper& operator=(FrameDumper const&) = delete;
+		FrameDumper& operator=(FrameDumper&&) = delete;
+
+		// Param std::span ARGB8888 frame, width x height
+		// Return bool was the frame queued, false when the pool is exhausted
+		bool Screenshot(std::span<uint32_t const> pixels) noexcept;
+
+		// Every frame passed to SubmitFrame is saved until the sequence is stopped, each sequence gets its own file names
+		void StartSequence() noexcept;
+		void StopSequence() noexcept { m_IsRecording = false; }
+		[[nodiscard]] bool IsRecordingSequence() const noexcept { return m_IsRecording; }
+
+		// Call once per emulated frame, does nothing while no sequence is recording
+		// Param std::span ARGB8888 frame, width x height
+		void SubmitFrame(std::span<uint32_t const> pixels) noexcept;
+
+		// Return uint64_t frames the background thread wrote so far
+		[[nodiscard]] uint64_t WrittenFrameCount() const noexcept { return m_WrittenFrames.load(std::memory_order_relaxed); }
+		// Return uint64_t frames that were not saved because no buffer was free
+		[[nodiscard]] uint64_t DroppedFrameCount() const noexcept { return m_DroppedFrames; }
+
+	private:
+		// Frames that can wait to be written at once, about 2MB for NES frames
+		static constexpr uint32_t POOL_SIZE{ 8 };
+
+		struct Job final
+		{
+			enum class Type : uint8_t
+			{
+				Screenshot,
+				Sequence,
+				Stop
+			};
+
+			Type type{ Type::Stop };
+			uint8_t buffer{ 0 };
+			// Sequence the frame belongs to
+			uint32_t sequence{ 0 };
+			// Screenshot number or frame number within the sequence
+			uint64_t index{ 0 };
+		};
+
+		uint32_t const m_Width;
+		uint32_t const m_Height;
+		std::filesystem::path const m_Directory;
+		Format const m_Format;
+
+		std::vector<std::vector<uint32_t>> m_Buffers{ };
+		// Frontend -> writer
+		SPSCRing<Job, POOL_SIZE> m_Jobs{ };
+		// Writer -> frontend, buffers that can be reused
+		SPSCRing<uint8_t, POOL_SIZE> m_FreeBuffers{ };
+
+		// Frontend side
+		uint64_t m_ScreenshotCount{ 0 };
+		uint32_t m_SequenceCount{ 0 };
+		uint64_t m_SequenceFrame{ 0 };
+		bool m_IsRecording{ false };
+		uint64_t m_DroppedFrames{ 0 };
+
+		// Writer side
+		bool m_HasDirectory{ false };
+		std::atomic<uint64_t> m_WrittenFrames{ 0 };
+
+		std::thread m_Thread{ };
+
+		// Starts the screenshot and sequence numbers after the highest ones already in the directory
+		void ContinueNumbering() noexcept;
+		// Return bool was a buffer free
+		bool Queue(Job::Type type, uint32_t sequence, uint64_t index, std::span<uint32_t const> pixels) noexcept;
+
+		void Run() noexcept;
+		void Write(Job const& job) noexcept;
+	};
+}
+
+#endif
@@ -0,0 +1,336 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string>
+
+namespace NesEm::ImageWriter
+{
+	namespace
+	{
+		// Deflate
+		constexpr uint32_t MIN_MATCH{ 3 };
+		constexpr uint32_t MAX_MATCH{ 258 };
+		constexpr uint32_t WINDOW_SIZE{ 32768 };
+		constexpr uint32_t HASH_BITS{ 15 };
+		// Candidates compared per position, more barely shrinks the flat frames we write
+		constexpr uint32_t MAX_CHAIN{ 16 };
+		constexpr uint32_t NO_POSITION{ UINT32_MAX };
+
+		constexpr uint16_t END_OF_BLOCK{ 256 };
+
+		constexpr std::array<uint16_t, 29> LENGTH_BASE{ 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		constexpr std::array<uint8_t, 29> LENGTH_EXTRA{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		constexpr std::array<uint16_t, 30> DISTANCE_BASE{ 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		constexpr std::array<uint8_t, 30> DISTANCE_EXTRA{ 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+		[[nodiscard]] constexpr std::array<uint32_t, 256> GenerateCRCTable() noexcept
+		{
+			std::array<uint32_t, 256> table{ };
+			for (uint32_t i{ 0 }; i < table.size(); ++i)
+			{
+				uint32_t crc{ i };
+				for (int bit{ 0 }; bit < 8; ++bit)
+				{
+					crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+				}
+				table[i] = crc;
+			}
+			return table;
+		}
+
+		constexpr std::array<uint32_t, 256> CRC_TABLE{ GenerateCRCTable() };
+
+		[[nodiscard]] uint32_t CRC32(uint8_t const* pData, size_t size, uint32_t crc = 0) noexcept
+		{
+			crc = ~crc;
+			for (size_t i{ 0 }; i < size; ++i)
+			{
+				crc = CRC_TABLE[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+			}
+			return ~crc;
+		}
+
+		[[nodiscard]] uint32_t Adler32(std::span<uint8_t const> data) noexcept
+		{
+			constexpr uint32_t MOD{ 65521 };
+			// Largest amount of bytes before the sums can overflow 32 bits
+			constexpr size_t RUN{ 5552 };
+
+			uint32_t a{ 1 };
+			uint32_t b{ 0 };
+			for (size_t offset{ 0 }; offset < data.size(); offset += RUN)
+			{
+				size_t const end{ std::min(offset + RUN, data.size()) };
+				for (size_t i{ offset }; i < end; ++i)
+				{
+					a += data[i];
+					b += a;
+				}
+				a %= MOD;
+				b %= MOD;
+			}
+			return (b << 16) | a;
+		}
+
+		void AppendBigEndian(std::vector<uint8_t>& out, uint32_t value)
+		{
+			out.push_back(static_cast<uint8_t>(value >> 24));
+			out.push_back(static_cast<uint8_t>(value >> 16));
+			out.push_back(static_cast<uint8_t>(value >> 8));
+			out.push_back(static_cast<uint8_t>(value));
+		}
+
+		// Deflate packs its bits starting at the least significant bit of every byte
+		class BitWriter final
+		{
+		public:
+			explicit BitWriter(std::vector<uint8_t>& out) :
+				m_Out{ out }
+			{
+			}
+
+			// Param uint32_t, uint32_t value and how many of its low bits to write, least significant first
+			void Write(uint32_t value, uint32_t bits)
+			{
+				m_Buffer |= static_cast<uint64_t>(value) << m_BitCount;
+				m_BitCount += bits;
+				while (m_BitCount >= 8)
+				{
+					m_Out.push_back(static_cast<uint8_t>(m_Buffer));
+					m_Buffer >>= 8;
+					m_BitCount -= 8;
+				}
+			}
+
+			// Huffman codes are defined most significant bit first
+			void WriteCode(uint32_t code, uint32_t bits)
+			{
+				uint32_t reversed{ 0 };
+				for (uint32_t i{ 0 }; i < bits; ++i)
+				{
+					reversed = (reversed << 1) | ((code >> i) & 1);
+				}
+				Write(reversed, bits);
+			}
+
+			void Flush()
+			{
+				if (m_BitCount)
+				{
+					m_Out.push_back(static_cast<uint8_t>(m_Buffer));
+				}
+				m_Buffer = 0;
+				m_BitCount = 0;
+			}
+
+		private:
+			std::vector<uint8_t>& m_Out;
+			uint64_t m_Buffer{ 0 };
+			uint32_t m_BitCount{ 0 };
+		};
+
+		// Fixed Huffman code of a literal / length symbol
+		void WriteLiteralLength(BitWriter& writer, uint16_t symbol)
+		{
+			if (symbol < 144)
+			{
+				writer.WriteCode(0x30 + symbol, 8);
+			}
+			else if (symbol < 256)
+			{
+				writer.WriteCode(0x190 + (symbol - 144), 9);
+			}
+			else if (symbol < 280)
+			{
+				writer.WriteCode(symbol - 256, 7);
+			}
+			else
+			{
+				writer.WriteCode(0xC0 + (symbol - 280), 8);
+			}
+		}
+
+		void WriteMatch(BitWriter& writer, uint32_t length, uint32_t distance)
+		{
+			size_t const lengthCode{ static_cast<size_t>(std::upper_bound(LENGTH_BASE.begin(), LENGTH_BASE.end(), length) - LENGTH_BASE.begin()) - 1 };
+			WriteLiteralLength(writer, static_cast<uint16_t>(257 + lengthCode));
+			writer.Write(length - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+
+			size_t const distanceCode{ static_cast<size_t>(std::upper_bound(DISTANCE_BASE.begin(), DISTANCE_BASE.end(), distance) - DISTANCE_BASE.begin()) - 1 };
+			// Fixed distance codes are all 5 bits
+			writer.WriteCode(static_cast<uint32_t>(distanceCode), 5);
+			writer.Write(distance - DISTANCE_BASE[distanceCode], DISTANCE_EXTRA[distanceCode]);
+		}
+
+		[[nodiscard]] uint32_t HashAt(uint8_t const* pData) noexcept
+		{
+			uint32_t const value{ pData[0] | (static_cast<uint32_t>(pData[1]) << 8) | (static_cast<uint32_t>(pData[2]) << 16) };
+			return (value * 2654435761u) >> (32 - HASH_BITS);
+		}
+
+		// Param std::span raw data
+		// Return std::vector zlib stream of a single fixed Huffman block
+		[[nodiscard]] std::vector<uint8_t> Compress(std::span<uint8_t const> data)
+		{
+			std::vector<uint8_t> out{ };
+			out.reserve(data.size() / 4 + 64);
+
+			// zlib header: deflate with a 32KB window, fastest compression level, check bits
+			out.push_back(0x78);
+			out.push_back(0x01);
+
+			BitWriter writer{ out };
+			// Final block, fixed Huffman codes
+			writer.Write(1, 1);
+			writer.Write(1, 2);
+
+			// Most recent position of every hash and, per window position, the one before it with the same hash
+			std::vector<uint32_t> head(size_t{ 1 } << HASH_BITS, NO_POSITION);
+			std::vector<uint32_t> previous(WINDOW_SIZE, NO_POSITION);
+
+			uint32_t const size{ static_cast<uint32_t>(data.size()) };
+			auto const insert{ [&](uint32_t position)
+			{
+				if (position + MIN_MATCH <= size)
+				{
+					uint32_t const hash{ HashAt(data.data() + position) };
+					previous[position & (WINDOW_SIZE - 1)] = head[hash];
+					head[hash] = position;
+				}
+			} };
+
+			uint32_t position{ 0 };
+			while (position < size)
+			{
+				uint32_t bestLength{ 0 };
+				uint32_t bestDistance{ 0 };
+
+				if (position + MIN_MATCH <= size)
+				{
+					uint32_t const maxLength{ std::min(MAX_MATCH, size - position) };
+					uint32_t candidate{ head[HashAt(data.data() + position)] };
+					for (uint32_t chain{ 0 }; chain < MAX_CHAIN && candidate != NO_POSITION && position - candidate <= WINDOW_SIZE; ++chain)
+					{
+						uint32_t length{ 0 };
+						while (length < maxLength && data[candidate + length] == data[position + length])
+						{
+							++length;
+						}
+
+						if (length > bestLength)
+						{
+							bestLength = length;
+							bestDistance = position - candidate;
+							if (length == maxLength)
+							{
+								break;
+							}
+						}
+
+						uint32_t const older{ previous[candidate & (WINDOW_SIZE - 1)] };
+						// The slot is reused once the window moved past it
+						if (older == NO_POSITION || older >= candidate)
+						{
+							break;
+						}
+						candidate = older;
+					}
+				}
+
+				if (bestLength >= MIN_MATCH)
+				{
+					WriteMatch(writer, bestLength, bestDistance);
+					for (uint32_t i{ 0 }; i < bestLength; ++i)
+					{
+						insert(position + i);
+					}
+					position += bestLength;
+				}
+				else
+				{
+					WriteLiteralLength(writer, data[position]);
+					insert(position);
+					++position;
+				}
+			}
+
+			WriteLiteralLength(writer, END_OF_BLOCK);
+			writer.Flush();
+
+			AppendBigEndian(out, Adler32(data));
+			return out;
+		}
+
+		void AppendChunk(std::vector<uint8_t>& out, char const (&type)[5], std::span<uint8_t const> data)
+		{
+			AppendBigEndian(out, static_cast<uint32_t>(data.size()));
+
+			size_t const typeOffset{ out.size() };
+			out.insert(out.end(), type, type + 4);
+			out.insert(out.end(), data.begin(), data.end());
+
+			// Covers the type and the data, not the length
+			AppendBigEndian(out, CRC32(out.data() + typeOffset, out.size() - typeOffset));
+		}
+	}
+
+	std::vector<uint8_t> EncodePNG(std::span<uint32_t const> pixels, uint32_t width, uint32_t height)
+	{
+		// Every row starts with its filter type, 0 = none, the LZ77 matches already catch the repeated pixels
+		std::vector<uint8_t> raw{ };
+		raw.reserve(static_cast<size_t>(width * 3 + 1) * height);
+		for (uint32_t y{ 0 }; y < height; ++y)
+		{
+			raw.push_back(0);
+			for (uint32_t const pixel : pixels.subspan(static_cast<size_t>(y) * width, width))
+			{
+				raw.push_back(static_cast<uint8_t>(pixel >> 16));
+				raw.push_back(static_cast<uint8_t>(pixel >> 8));
+				raw.push_back(static_cast<uint8_t>(pixel));
+			}
+		}
+
+		constexpr std::array<uint8_t, 8> SIGNATURE{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		std::vector<uint8_t> out{ SIGNATURE.begin(), SIGNATURE.end() };
+
+		std::vector<uint8_t> header{ };
+		AppendBigEndian(header, width);
+		AppendBigEndian(header, height);
+		// 8 bits per channel, truecolour, deflate, adaptive filtering, not interlaced
+		header.insert(header.end(), { 8, 2, 0, 0, 0 });
+
+		AppendChunk(out, "IHDR", header);
+		AppendChunk(out, "IDAT", Compress(raw));
+		AppendChunk(out, "IEND", { });
+		return out;
+	}
+
+	std::vector<uint8_t> EncodePPM(std::span<uint32_t const> pixels, uint32_t width, uint32_t height)
+	{
+		std::string const header{ "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n" };
+
+		std::vector<uint8_t> out{ header.begin(), header.end() };
+		out.reserve(out.size() + static_cast<size_t>(width) * height * 3);
+		for (uint32_t const pixel : pixels.first(static_cast<size_t>(width) * height))
+		{
+			out.push_back(static_cast<uint8_t>(pixel >> 16));
+			out.push_back(static_cast<uint8_t>(pixel >> 8));
+			out.push_back(static_cast<uint8_t>(pixel));
+		}
+		return out;
+	}
+
+	bool WriteFile(std::filesystem::path const& path, std::span<uint8_t const> data) noexcept
+	{
+		std::ofstream file{ path, std::ios::binary | std::ios::out | std::ios::trunc };
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		file.write(reinterpret_cast<char const*>(data.data()), static_cast<std::streamsize>(data.size()));
+		return static_cast<bool>(file);
+	}
+}
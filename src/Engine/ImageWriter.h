@@ -0,0 +1,35 @@
+#ifndef NES_EMULATOR_IMAGE_WRITER
+#define NES_EMULATOR_IMAGE_WRITER
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+/* Sources used during development of the image writer:
+ * https://www.w3.org/TR/png/
+ * https://www.rfc-editor.org/rfc/rfc1950 (zlib)
+ * https://www.rfc-editor.org/rfc/rfc1951 (deflate)
+ * https://netpbm.sourceforge.net/doc/ppm.html
+ */
+
+namespace NesEm
+{
+	// Encodes ARGB8888 frames into 8 bit RGB image files, alpha is dropped
+	// PNG data is compressed with LZ77 and deflate's fixed Huffman codes, no zlib needed and plenty for emulator output which is mostly flat colours
+	namespace ImageWriter
+	{
+		// Param std::span ARGB8888 pixels, rows are tightly packed
+		// Param uint32_t, uint32_t size of the image in pixels
+		// Return std::vector the encoded file
+		[[nodiscard]] std::vector<uint8_t> EncodePNG(std::span<uint32_t const> pixels, uint32_t width, uint32_t height);
+		[[nodiscard]] std::vector<uint8_t> EncodePPM(std::span<uint32_t const> pixels, uint32_t width, uint32_t height);
+
+		// Param std::filesystem::path file to create or overwrite
+		// Param std::span encoded file
+		// Return bool could the whole file be written
+		[[nodiscard]] bool WriteFile(std::filesystem::path const& path, std::span<uint8_t const> data) noexcept;
+	}
+}
+
+#endif
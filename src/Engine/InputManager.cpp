@@ -12,6 +12,7 @@ namespace NesEm
 		// Clear last frames info
 		m_KeyCodes.clear();
 		m_KeyCodes.resize(static_cast<size_t>(InputAction::EventType::COUNT));
+		m_WindowDirty = false;
 
 		SDL_Event event{ };
 		while (SDL_PollEvent(&event))
@@ -36,6 +37,12 @@ namespace NesEm
 				{
 					m_KeyCodes[static_cast<size_t>(InputAction::EventType::KeyUp)].emplace(static_cast<uint16_t>(event.key.scancode));
 				}break;
+				case SDL_EVENT_WINDOW_EXPOSED:
+				case SDL_EVENT_WINDOW_RESIZED:
+				case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+				{
+					m_WindowDirty = true;
+				}break;
 			}
 		}
 
@@ -43,6 +50,13 @@ namespace NesEm
 
 		return true;
 	}
+	bool InputManager::IsKeyHeld(uint16_t keyboardKeyCode) const noexcept
+	{
+		int keyCount{ 0 };
+		bool const* const pKeys{ SDL_GetKeyboardState(&keyCount) };
+		return keyboardKeyCode < keyCount && pKeys[keyboardKeyCode];
+	}
+
 	void InputManager::AddAction(InputAction const& action) noexcept
 	{
 		// First add the action to our actions map if it does not exist yet
@@ -45,7 +45,12 @@ namespace NesEm
 			// Return bool Is this action executed or not
 			[[nodiscard]] bool IsActionExecuted(std::string const& actionName) const noexcept;
 
-			// A function could also be added to check executed scancodes directly if necessary in the future.
+			// Param uint16_t scancode
+			// Return bool is the key held down right now, key down events only repeat after a delay
+			[[nodiscard]] bool IsKeyHeld(uint16_t keyboardKeyCode) const noexcept;
+
+			// Return bool was the window exposed or resized during the last ProcessInput, its contents have to be presented again
+			[[nodiscard]] bool IsWindowDirty() const noexcept { return m_WindowDirty; }
 
 			InputManager(const InputManager&) = delete;
 			InputManager(InputManager&&) = delete;
@@ -72,6 +77,8 @@ namespace NesEm
 
 			// scancodes that were executed last frame
 			std::vector<std::unordered_set<uint16_t>> m_KeyCodesLast;
+
+			bool m_WindowDirty{ false };
 	};
 }
 
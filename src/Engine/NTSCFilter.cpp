@@ -0,0 +1,289 @@
+#include "NTSCFilter.h"
+
+#include "Macros.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#pragma warning (push)
+#pragma warning (disable: 4820)
+#pragma warning (disable: 4514)
+#pragma warning (disable: 4548)
+	#include <SDL3/SDL.h>
+#pragma warning (pop)
+
+#if NES_EM_SSE2
+	#include <immintrin.h>
+#endif
+
+namespace NesEm
+{
+	namespace
+	{
+		// Subcarrier phases per colour cycle and per pixel
+		constexpr int PHASES{ 12 };
+		constexpr int SAMPLES_PER_PIXEL{ 8 };
+
+		// Composite voltages of the 2C02 relative to sync
+		// https://www.nesdev.org/wiki/NTSC_video#Terminated_measurement
+		constexpr float BLACK{ 0.518f };
+		constexpr float WHITE{ 1.962f };
+		constexpr float ATTENUATION{ 0.746f };
+		constexpr std::array<float, 8> LEVELS{
+			0.350f, 0.518f, 0.962f, 1.550f, // Signal low
+			1.094f, 1.506f, 1.962f, 1.962f }; // Signal high
+
+		// Shifts the decoded hue so the palette looks like it does on a typical TV
+		constexpr float HUE_TWEAK{ 3.9f };
+
+		// Luma is averaged over one colour cycle, which cancels the subcarrier out
+		// Chroma uses a wider window, TVs only have a fraction of the luma bandwidth for it
+		constexpr int LUMA_WINDOW{ 12 };
+		constexpr int CHROMA_WINDOW{ 24 };
+
+		// Param uint32_t palette index | emphasis << 6
+		// Param int subcarrier phase the sample is taken at
+		// Return float normalized signal level, 0 = black, 1 = white
+		[[nodiscard]] float Signal(uint32_t value, int phase) noexcept
+		{
+			int const colour{ static_cast<int>(value & 0x0F) };
+			int level{ static_cast<int>((value >> 4) & 0x03) };
+			uint32_t const emphasis{ value >> 6 };
+
+			auto const inColourPhase{ [phase](int hue) { return (hue + phase) % PHASES < 6; } };
+
+			// Columns $xE / $xF are forced to black
+			if (colour > 13)
+			{
+				level = 1;
+			}
+
+			// The square wave of a colour alternates between these two levels
+			float low{ LEVELS[level] };
+			float high{ LEVELS[4 + level] };
+			if (colour == 0)
+			{
+				low = high;
+			}
+			else if (colour > 12)
+			{
+				high = low;
+			}
+
+			float signal{ inColourPhase(colour) ? high : low };
+
+			// Each emphasis bit attenuates the part of the wave that lines up with its colour
+			if (((emphasis & 0x01) && inColourPhase(0))
+				|| ((emphasis & 0x02) && inColourPhase(4))
+				|| ((emphasis & 0x04) && inColourPhase(8)))
+			{
+				signal *= ATTENUATION;
+			}
+
+			return (signal - BLACK) / (WHITE - BLACK);
+		}
+
+		// Param int offset of a sample to the centre of the output pixel, in samples
+		// Return float weight within a window of that width, 0 outside of it (not normalized)
+		[[nodiscard]] float Window(int offset, int width) noexcept
+		{
+			if (offset < -width / 2 || offset >= width / 2)
+			{
+				return 0.f;
+			}
+
+			// Hann window, centred between the two middle samples
+			return 1.f + std::cos(std::numbers::pi_v<float> * (static_cast<float>(offset) + 0.5f) / static_cast<float>(width / 2));
+		}
+	}
+
+	NTSCFilter::NTSCFilter(uint32_t sourceWidth, uint32_t sourceHeight, uint32_t threadCount) :
+		m_SourceWidth{ sourceWidth },
+		m_SourceHeight{ sourceHeight },
+		m_UseAVX2{ NES_EM_SSE2 && SDL_HasAVX2() },
+		m_Pool{ threadCount }
+	{
+		assert(sourceWidth > 0 && sourceHeight > 0);
+
+		GenerateKernels();
+
+		SDL_Log("NTSC filter %ux%u -> %ux%u on %u threads%s", m_SourceWidth, m_SourceHeight, OutputWidth(), OutputHeight(),
+			m_Pool.ThreadCount(), m_UseAVX2 ? " (AVX2)" : "");
+	}
+
+	void NTSCFilter::GenerateKernels() noexcept
+	{
+		// Normalize the windows so a flat signal decodes to its own level
+		float lumaSum{ 0.f };
+		float chromaSum{ 0.f };
+		for (int offset{ -CHROMA_WINDOW }; offset < CHROMA_WINDOW; ++offset)
+		{
+			lumaSum += (offset >= -LUMA_WINDOW / 2 && offset < LUMA_WINDOW / 2) ? 1.f : 0.f;
+			chromaSum += Window(offset, CHROMA_WINDOW);
+		}
+
+		m_Kernels.assign(static_cast<size_t>(PIXEL_VALUES) * PHASE_CLASSES * TAPS * KERNEL_SIZE, 0.f);
+
+		for (uint32_t value{ 0 }; value < PIXEL_VALUES; ++value)
+		{
+			for (uint32_t phaseClass{ 0 }; phaseClass < PHASE_CLASSES; ++phaseClass)
+			{
+				int const startPhase{ static_cast<int>(phaseClass) * (PHASES / static_cast<int>(PHASE_CLASSES)) };
+
+				std::array<float, SAMPLES_PER_PIXEL> samples{ };
+				for (int sample{ 0 }; sample < SAMPLES_PER_PIXEL; ++sample)
+				{
+					samples[sample] = Signal(value, (startPhase + sample) % PHASES);
+				}
+
+				float* const pKernel{ &m_Kernels[(static_cast<size_t>(value) * PHASE_CLASSES + phaseClass) * TAPS * KERNEL_SIZE] };
+				for (uint32_t tap{ 0 }; tap < TAPS; ++tap)
+				{
+					// Output pixel this tap adds to, relative to the source pixel
+					int const outputPixel{ static_cast<int>(TAP_CENTER) - static_cast<int>(tap) };
+
+					for (int half{ 0 }; half < 2; ++half)
+					{
+						// Every output pixel covers 4 samples, measure from the middle of them
+						int const centre{ outputPixel * SAMPLES_PER_PIXEL + half * (SAMPLES_PER_PIXEL / 2) + SAMPLES_PER_PIXEL / 4 };
+
+						float y{ 0.f };
+						float i{ 0.f };
+						float q{ 0.f };
+						for (int sample{ 0 }; sample < SAMPLES_PER_PIXEL; ++sample)
+						{
+							int const offset{ sample - centre };
+							float const signal{ samples[sample] };
+
+							if (offset >= -LUMA_WINDOW / 2 && offset < LUMA_WINDOW / 2)
+							{
+								y += signal / lumaSum;
+							}
+
+							float const angle{ std::numbers::pi_v<float> * (static_cast<float>((startPhase + sample) % PHASES) + HUE_TWEAK) / 6.f };
+							float const weight{ Window(offset, CHROMA_WINDOW) / chromaSum };
+							i += signal * weight * std::cos(angle);
+							q += signal * weight * std::sin(angle);
+						}
+
+						// YIQ -> RGB, scaled to 0 - 255, stored in ARGB8888 memory order (B G R A)
+						float* const pChannels{ pKernel + tap * KERNEL_SIZE + half * 4 };
+						pChannels[0] = 255.f * (y - 1.108545f * i + 1.709007f * q);
+						pChannels[1] = 255.f * (y - 0.274788f * i - 0.635691f * q);
+						pChannels[2] = 255.f * (y + 0.946882f * i + 0.623557f * q);
+						// Every output pixel sums exactly one centre tap
+						pChannels[3] = (tap == TAP_CENTER) ? 255.f : 0.f;
+					}
+				}
+			}
+		}
+	}
+
+	void NTSCFilter::Process(std::span<uint8_t const> indices, std::span<uint8_t const> emphasis, std::span<uint8_t const> phases, uint32_t* pDestination, int pitch) noexcept
+	{
+		assert(indices.size() >= static_cast<size_t>(m_SourceWidth) * m_SourceHeight);
+		assert(emphasis.size() >= m_SourceHeight && phases.size() >= m_SourceHeight);
+		assert(pDestination);
+		assert(pitch >= static_cast<int>(OutputWidth() * sizeof(uint32_t)));
+
+		uint64_t const start{ SDL_GetTicksNS() };
+
+		m_Indices = indices;
+		m_Emphasis = emphasis;
+		m_Phases = phases;
+		m_pDestination = pDestination;
+		m_Pitch = pitch;
+
+		m_Pool.Run(m_SourceHeight, [this](uint32_t first, uint32_t last) { ProcessBand(first, last); });
+
+		m_LastProcessTimeNs = SDL_GetTicksNS() - start;
+		m_TotalProcessTimeNs += m_LastProcessTimeNs;
+		++m_ProcessedFrames;
+	}
+
+	void NTSCFilter::ProcessBand(uint32_t first, uint32_t last) const noexcept
+	{
+		std::vector<float const*> kernels(m_SourceWidth + 2 * TAP_CENTER);
+
+		for (uint32_t y{ first }; y < last; ++y)
+		{
+			uint8_t const* const pIndices{ &m_Indices[static_cast<size_t>(y) * m_SourceWidth] };
+			uint32_t const emphasis{ static_cast<uint32_t>(m_Emphasis[y] & 0x07) << 6 };
+
+			// Consecutive pixels are 8 phases apart, so the phase class steps by 2 (mod 3) every pixel
+			// Start TAP_CENTER pixels left of the first one, 3 steps back is the same class
+			uint32_t phaseClass{ (m_Phases[y] / (PHASES / PHASE_CLASSES) + (PHASE_CLASSES - TAP_CENTER) * 2) % PHASE_CLASSES };
+
+			for (uint32_t x{ 0 }; x < kernels.size(); ++x)
+			{
+				bool const isBorder{ x < TAP_CENTER || x >= m_SourceWidth + TAP_CENTER };
+				uint32_t const value{ isBorder ? BORDER_VALUE : (pIndices[x - TAP_CENTER] | emphasis) };
+
+				kernels[x] = &m_Kernels[(static_cast<size_t>(value) * PHASE_CLASSES + phaseClass) * TAPS * KERNEL_SIZE];
+				phaseClass = (phaseClass + 2) % PHASE_CLASSES;
+			}
+
+			uint32_t* const pOut{ reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(m_pDestination) + static_cast<size_t>(y) * 2 * m_Pitch) };
+			if (m_UseAVX2)
+			{
+				DecodeScanlineAVX2(kernels.data(), pOut);
+			}
+			else
+			{
+				DecodeScanline(kernels.data(), pOut);
+			}
+
+			// Both rows of a scanline are the same
+			std::memcpy(reinterpret_cast<uint8_t*>(pOut) + m_Pitch, pOut, OutputWidth() * sizeof(uint32_t));
+		}
+	}
+
+	void NTSCFilter::DecodeScanline(float const* const* ppKernels, uint32_t* pOut) const noexcept
+	{
+		for (uint32_t x{ 0 }; x < m_SourceWidth; ++x)
+		{
+			std::array<float, KERNEL_SIZE> sum{ };
+			for (uint32_t tap{ 0 }; tap < TAPS; ++tap)
+			{
+				float const* const pKernel{ ppKernels[x + tap] + tap * KERNEL_SIZE };
+				for (uint32_t channel{ 0 }; channel < KERNEL_SIZE; ++channel)
+				{
+					sum[channel] += pKernel[channel];
+				}
+			}
+
+			std::array<uint8_t, KERNEL_SIZE> bytes{ };
+			for (uint32_t channel{ 0 }; channel < KERNEL_SIZE; ++channel)
+			{
+				bytes[channel] = static_cast<uint8_t>(std::clamp(std::lrint(sum[channel]), 0l, 255l));
+			}
+			std::memcpy(pOut + x * 2, bytes.data(), bytes.size());
+		}
+	}
+
+	NES_EM_TARGET_AVX2 void NTSCFilter::DecodeScanlineAVX2(float const* const* ppKernels, uint32_t* pOut) const noexcept
+	{
+#if NES_EM_SSE2
+		for (uint32_t x{ 0 }; x < m_SourceWidth; ++x)
+		{
+			// Both output pixels of a source pixel fit in one register
+			__m256 sum{ _mm256_loadu_ps(ppKernels[x]) };
+			for (uint32_t tap{ 1 }; tap < TAPS; ++tap)
+			{
+				sum = _mm256_add_ps(sum, _mm256_loadu_ps(ppKernels[x + tap] + tap * KERNEL_SIZE));
+			}
+
+			// Round, then saturate to 0 - 255 while packing down to bytes
+			__m256i const channels{ _mm256_cvtps_epi32(sum) };
+			__m128i const words{ _mm_packs_epi32(_mm256_castsi256_si128(channels), _mm256_extracti128_si256(channels, 1)) };
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(pOut + x * 2), _mm_packus_epi16(words, words));
+		}
+#else
+		DecodeScanline(ppKernels, pOut);
+#endif
+	}
+}
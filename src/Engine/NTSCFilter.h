@@ -0,0 +1,97 @@
+#ifndef NES_EMULATOR_NTSC_FILTER
+#define NES_EMULATOR_NTSC_FILTER
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "BandPool.h"
+
+/* Sources used during development of the NTSC filter:
+ * https://www.nesdev.org/wiki/NTSC_video
+ * https://www.slack.net/~ant/libs/ntsc.html
+ */
+
+namespace NesEm
+{
+	// Turns the PPU's palette indices into the composite signal a TV receives and decodes that back to ARGB8888,
+	// which gives the colour fringing, dot crawl and blending games were drawn for
+	// Encoding and decoding are linear, so what every pixel value contributes to its neighbouring output pixels is precomputed,
+	// the per pixel work is summing a few kernels (AVX2 when the CPU has it)
+	// Every source pixel becomes 2 output pixels wide and every scanline 2 rows tall to keep the aspect ratio
+	class NTSCFilter final
+	{
+	public:
+		// Param uint32_t, uint32_t size of the source frames in pixels
+		// Param uint32_t threads the scanlines are split over including the calling one, 0 picks an amount based on the hardware
+		NTSCFilter(uint32_t sourceWidth, uint32_t sourceHeight, uint32_t threadCount = 0);
+		~NTSCFilter() = default;
+
+		NTSCFilter(NTSCFilter const&) = delete;
+		NTSCFilter(NTSCFilter&&) = delete;
+		NTSCFilter& operator=(NTSCFilter const&) = delete;
+		NTSCFilter& operator=(NTSCFilter&&) = delete;
+
+		[[nodiscard]] uint32_t OutputWidth() const noexcept { return m_SourceWidth * 2; }
+		[[nodiscard]] uint32_t OutputHeight() const noexcept { return m_SourceHeight * 2; }
+
+		// Param std::span palette indices (0 - 63), rows are tightly packed
+		// Param std::span emphasis bits (PPUMASK bits 5 - 7) of every scanline
+		// Param std::span colour subcarrier phase of the first pixel of every scanline, in 1/12ths of a cycle (0, 4 or 8)
+		// Param uint32_t*, int destination of OutputWidth x OutputHeight pixels and the length of one of its rows in bytes
+		void Process(std::span<uint8_t const> indices, std::span<uint8_t const> emphasis, std::span<uint8_t const> phases, uint32_t* pDestination, int pitch) noexcept;
+
+		// Return uint64_t how long the last Process call took in nanoseconds
+		[[nodiscard]] uint64_t LastProcessTimeNs() const noexcept { return m_LastProcessTimeNs; }
+		// Return uint64_t average time of all Process calls so far in nanoseconds
+		[[nodiscard]] uint64_t AverageProcessTimeNs() const noexcept { return m_ProcessedFrames ? m_TotalProcessTimeNs / m_ProcessedFrames : 0; }
+
+	private:
+		// 6 bit palette index + 3 emphasis bits
+		static constexpr uint32_t PIXEL_VALUES{ 512 };
+		// A pixel lasts 8 of the 12 subcarrier phases, so it starts on phase 0, 4 or 8
+		static constexpr uint32_t PHASE_CLASSES{ 3 };
+		// Output pixels are influenced by the source pixels 2 to the left up to 2 to the right
+		static constexpr uint32_t TAPS{ 5 };
+		static constexpr uint32_t TAP_CENTER{ TAPS / 2 };
+		// 2 output pixels x B G R A
+		static constexpr uint32_t KERNEL_SIZE{ 8 };
+
+		// Blanking around the visible part of a scanline
+		static constexpr uint16_t BORDER_VALUE{ 0x0F };
+
+		uint32_t const m_SourceWidth;
+		uint32_t const m_SourceHeight;
+
+		// Contribution of a source pixel to the output pixel TAP_CENTER - tap to its right
+		// [value][phase class][tap][KERNEL_SIZE]
+		std::vector<float> m_Kernels{ };
+
+		bool const m_UseAVX2;
+
+		// Frame that is being processed
+		std::span<uint8_t const> m_Indices{ };
+		std::span<uint8_t const> m_Emphasis{ };
+		std::span<uint8_t const> m_Phases{ };
+		uint32_t* m_pDestination{ nullptr };
+		int m_Pitch{ 0 };
+
+		BandPool m_Pool;
+
+		uint64_t m_LastProcessTimeNs{ 0 };
+		uint64_t m_TotalProcessTimeNs{ 0 };
+		uint64_t m_ProcessedFrames{ 0 };
+
+		void GenerateKernels() noexcept;
+
+		// Param uint32_t, uint32_t first scanline and the one after the last
+		void ProcessBand(uint32_t first, uint32_t last) const noexcept;
+
+		// Param float const**, kernel of every source pixel of the scanline, with TAP_CENTER border pixels on either side
+		// Param uint32_t* output row
+		void DecodeScanline(float const* const* ppKernels, uint32_t* pOut) const noexcept;
+		void DecodeScanlineAVX2(float const* const* ppKernels, uint32_t* pOut) const noexcept;
+	};
+}
+
+#endif
@@ -0,0 +1,403 @@
+#include "PostProcessor.h"
+
+#include "Macros.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#pragma warning (push)
+#pragma warning (disable: 4820)
+#pragma warning (disable: 4514)
+#pragma warning (disable: 4548)
+	#include <SDL3/SDL.h>
+#pragma warning (pop)
+
+#if NES_EM_SSE2
+	#include <emmintrin.h>
+#endif
+
+/* Sources used for the edge directed filter:
+ * https://www.scale2x.it/algorithm
+ */
+
+namespace NesEm
+{
+	namespace
+	{
+		[[nodiscard]] uint32_t ClampScale(PostProcessor::Filter filter, uint32_t scale) noexcept
+		{
+			switch (filter)
+			{
+			case PostProcessor::Filter::Scanlines: return std::max(scale, 2u);
+			case PostProcessor::Filter::Edge: return std::clamp(scale, 2u, 3u);
+			default: return std::max(scale, 1u);
+			}
+		}
+
+		// Neighbourhood of one source pixel E
+		// A B C
+		// D E F
+		// G H I
+		[[nodiscard]] std::array<uint32_t, 4> Scale2xPixel(uint32_t B, uint32_t D, uint32_t E, uint32_t F, uint32_t H) noexcept
+		{
+			if (B == H || D == F)
+			{
+				return { E, E, E, E };
+			}
+
+			return {
+				D == B ? D : E, B == F ? F : E,
+				D == H ? D : E, H == F ? F : E };
+		}
+
+		[[nodiscard]] std::array<uint32_t, 9> Scale3xPixel(uint32_t A, uint32_t B, uint32_t C, uint32_t D, uint32_t E, uint32_t F, uint32_t G, uint32_t H, uint32_t I) noexcept
+		{
+			if (B == H || D == F)
+			{
+				return { E, E, E, E, E, E, E, E, E };
+			}
+
+			return {
+				D == B ? D : E,
+				((D == B && E != C) || (B == F && E != A)) ? B : E,
+				B == F ? F : E,
+				((D == B && E != G) || (D == H && E != A)) ? D : E,
+				E,
+				((B == F && E != I) || (H == F && E != C)) ? F : E,
+				D == H ? D : E,
+				((D == H && E != I) || (H == F && E != G)) ? H : E,
+				H == F ? F : E };
+		}
+
+#if NES_EM_SSE2
+		[[nodiscard]] FORCE_INLINE inline __m128i Select(__m128i mask, __m128i a, __m128i b) noexcept
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
+
+		// Writes x0 y0 z0 x1 y1 z1 ... x3 y3 z3
+		FORCE_INLINE inline void StoreInterleaved3(uint32_t* pOut, __m128i x, __m128i y, __m128i z) noexcept
+		{
+			__m128 const xyLow{ _mm_castsi128_ps(_mm_unpacklo_epi32(x, y)) };
+			__m128 const xyHigh{ _mm_castsi128_ps(_mm_unpackhi_epi32(x, y)) };
+			__m128 const yzLow{ _mm_castsi128_ps(_mm_unpacklo_epi32(y, z)) };
+			__m128 const yzHigh{ _mm_castsi128_ps(_mm_unpackhi_epi32(y, z)) };
+			__m128 const zxLow{ _mm_castsi128_ps(_mm_unpacklo_epi32(z, x)) };
+			__m128 const zxHigh{ _mm_castsi128_ps(_mm_unpackhi_epi32(z, x)) };
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut), _mm_castps_si128(_mm_shuffle_ps(xyLow, zxLow, _MM_SHUFFLE(3, 0, 1, 0))));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + 4), _mm_castps_si128(_mm_shuffle_ps(yzLow, xyHigh, _MM_SHUFFLE(1, 0, 3, 2))));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + 8), _mm_castps_si128(_mm_shuffle_ps(zxHigh, yzHigh, _MM_SHUFFLE(3, 2, 3, 0))));
+		}
+
+		[[nodiscard]] FORCE_INLINE inline __m128i Load(uint32_t const* pPixels) noexcept
+		{
+			return _mm_loadu_si128(reinterpret_cast<__m128i const*>(pPixels));
+		}
+
+		FORCE_INLINE inline void Store(uint32_t* pPixels, __m128i pixels) noexcept
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels), pixels);
+		}
+#endif
+	}
+
+	PostProcessor::PostProcessor(uint32_t sourceWidth, uint32_t sourceHeight, Filter filter, uint32_t scale, uint32_t threadCount) :
+		m_SourceWidth{ sourceWidth },
+		m_SourceHeight{ sourceHeight },
+		m_Filter{ filter },
+		m_Scale{ ClampScale(filter, scale) },
+		m_Pool{ threadCount }
+	{
+		assert(sourceWidth > 0 && sourceHeight > 0);
+
+		if (m_Filter == Filter::Scanlines)
+		{
+			// ARGB8888 pixels are stored B G R A in memory, every column of a triad lets one colour through fully
+			constexpr std::array<uint32_t, 3> GRILLE_CHANNEL{ 2, 1, 0 };
+			constexpr uint32_t ALPHA_CHANNEL{ 3 };
+
+			uint32_t const width{ OutputWidth() };
+			m_MaskWeights.resize(static_cast<size_t>(m_Scale) * width * 4);
+			for (uint32_t row{ 0 }; row < m_Scale; ++row)
+			{
+				uint32_t const rowBrightness{ (row == m_Scale - 1) ? SCANLINE_BRIGHTNESS : 256u };
+				for (uint32_t x{ 0 }; x < width; ++x)
+				{
+					for (uint32_t channel{ 0 }; channel < 4; ++channel)
+					{
+						uint32_t weight{ 256 };
+						if (channel != ALPHA_CHANNEL)
+						{
+							weight = (channel == GRILLE_CHANNEL[x % 3]) ? rowBrightness : rowBrightness * MASK_BRIGHTNESS / 256;
+						}
+						m_MaskWeights[(static_cast<size_t>(row) * width + x) * 4 + channel] = static_cast<uint16_t>(weight);
+					}
+				}
+			}
+		}
+
+		if (m_Filter == Filter::Edge)
+		{
+			m_PaddedSource.resize(static_cast<size_t>(m_SourceWidth + 2) * (m_SourceHeight + 2));
+		}
+
+		SDL_Log("Post processing %ux%u -> %ux%u on %u threads", m_SourceWidth, m_SourceHeight, OutputWidth(), OutputHeight(), m_Pool.ThreadCount());
+	}
+
+	void PostProcessor::Process(uint32_t const* pSource, uint32_t* pDestination, int pitch) noexcept
+	{
+		assert(pSource && pDestination);
+		assert(pitch >= static_cast<int>(OutputWidth() * sizeof(uint32_t)));
+
+		uint64_t const start{ SDL_GetTicksNS() };
+
+		m_pSource = pSource;
+		m_pDestination = pDestination;
+		m_Pitch = pitch;
+
+		if (m_Filter == Filter::Edge)
+		{
+			PadSource();
+		}
+
+		m_Pool.Run(m_SourceHeight, [this](uint32_t first, uint32_t last) { ProcessBand(first, last); });
+
+		m_LastProcessTimeNs = SDL_GetTicksNS() - start;
+		m_TotalProcessTimeNs += m_LastProcessTimeNs;
+		++m_ProcessedFrames;
+	}
+
+	void PostProcessor::ProcessBand(uint32_t first, uint32_t last) const noexcept
+	{
+		uint32_t* pOut{ reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(m_pDestination) + static_cast<size_t>(first) * m_Scale * m_Pitch) };
+		for (uint32_t y{ first }; y < last; ++y)
+		{
+			switch (m_Filter)
+			{
+			case Filter::Edge:
+				(m_Scale == 2) ? ScaleEdge2x(y, pOut) : ScaleEdge3x(y, pOut);
+				break;
+
+			case Filter::Scanlines:
+				ScaleNearest(y, pOut);
+				ApplyMask(pOut);
+				break;
+
+			default:
+				ScaleNearest(y, pOut);
+				break;
+			}
+
+			pOut = reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(pOut) + static_cast<size_t>(m_Scale) * m_Pitch);
+		}
+	}
+
+	void PostProcessor::PadSource() noexcept
+	{
+		uint32_t const paddedWidth{ m_SourceWidth + 2 };
+		for (uint32_t row{ 0 }; row < m_SourceHeight + 2; ++row)
+		{
+			uint32_t const sourceRow{ std::clamp(row, 1u, m_SourceHeight) - 1 };
+			uint32_t const* pIn{ m_pSource + static_cast<size_t>(sourceRow) * m_SourceWidth };
+			uint32_t* pPadded{ m_PaddedSource.data() + static_cast<size_t>(row) * paddedWidth };
+
+			pPadded[0] = pIn[0];
+			std::memcpy(pPadded + 1, pIn, m_SourceWidth * sizeof(uint32_t));
+			pPadded[m_SourceWidth + 1] = pIn[m_SourceWidth - 1];
+		}
+	}
+
+	void PostProcessor::ScaleNearest(uint32_t y, uint32_t* pOut) const noexcept
+	{
+		uint32_t const* pIn{ m_pSource + static_cast<size_t>(y) * m_SourceWidth };
+
+		uint32_t x{ 0 };
+#if NES_EM_SSE2
+		if (m_Scale == 2)
+		{
+			for (; x + 4 <= m_SourceWidth; x += 4)
+			{
+				__m128i const pixels{ Load(pIn + x) };
+				Store(pOut + x * 2, _mm_unpacklo_epi32(pixels, pixels));
+				Store(pOut + x * 2 + 4, _mm_unpackhi_epi32(pixels, pixels));
+			}
+		}
+		else if (m_Scale == 3)
+		{
+			for (; x + 4 <= m_SourceWidth; x += 4)
+			{
+				__m128i const pixels{ Load(pIn + x) };
+				Store(pOut + x * 3, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(1, 0, 0, 0)));
+				Store(pOut + x * 3 + 4, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(2, 2, 1, 1)));
+				Store(pOut + x * 3 + 8, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 3, 3, 2)));
+			}
+		}
+		else if (m_Scale % 4 == 0)
+		{
+			for (; x < m_SourceWidth; ++x)
+			{
+				__m128i const pixel{ _mm_set1_epi32(static_cast<int>(pIn[x])) };
+				for (uint32_t i{ 0 }; i < m_Scale; i += 4)
+				{
+					Store(pOut + x * m_Scale + i, pixel);
+				}
+			}
+		}
+#endif
+		for (; x < m_SourceWidth; ++x)
+		{
+			std::fill_n(pOut + x * m_Scale, m_Scale, pIn[x]);
+		}
+
+		// The other rows of the blocks are the same
+		uint32_t* pRow{ pOut };
+		for (uint32_t row{ 1 }; row < m_Scale; ++row)
+		{
+			pRow = NextRow(pRow);
+			std::memcpy(pRow, pOut, OutputWidth() * sizeof(uint32_t));
+		}
+	}
+
+	void PostProcessor::ScaleEdge2x(uint32_t y, uint32_t* pOut) const noexcept
+	{
+		uint32_t const paddedWidth{ m_SourceWidth + 2 };
+		uint32_t const* pRow{ m_PaddedSource.data() + static_cast<size_t>(y + 1) * paddedWidth + 1 };
+		uint32_t const* pAbove{ pRow - paddedWidth };
+		uint32_t const* pBelow{ pRow + paddedWidth };
+
+		uint32_t* pOut0{ pOut };
+		uint32_t* pOut1{ NextRow(pOut) };
+
+		uint32_t x{ 0 };
+#if NES_EM_SSE2
+		for (; x + 4 <= m_SourceWidth; x += 4)
+		{
+			__m128i const B{ Load(pAbove + x) };
+			__m128i const D{ Load(pRow + x - 1) };
+			__m128i const E{ Load(pRow + x) };
+			__m128i const F{ Load(pRow + x + 1) };
+			__m128i const H{ Load(pBelow + x) };
+
+			__m128i const edge{ _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(B, H), _mm_cmpeq_epi32(D, F)), _mm_cmpeq_epi32(E, E)) };
+
+			__m128i const E0{ Select(_mm_and_si128(edge, _mm_cmpeq_epi32(D, B)), D, E) };
+			__m128i const E1{ Select(_mm_and_si128(edge, _mm_cmpeq_epi32(B, F)), F, E) };
+			__m128i const E2{ Select(_mm_and_si128(edge, _mm_cmpeq_epi32(D, H)), D, E) };
+			__m128i const E3{ Select(_mm_and_si128(edge, _mm_cmpeq_epi32(H, F)), F, E) };
+
+			Store(pOut0 + x * 2, _mm_unpacklo_epi32(E0, E1));
+			Store(pOut0 + x * 2 + 4, _mm_unpackhi_epi32(E0, E1));
+			Store(pOut1 + x * 2, _mm_unpacklo_epi32(E2, E3));
+			Store(pOut1 + x * 2 + 4, _mm_unpackhi_epi32(E2, E3));
+		}
+#endif
+		for (; x < m_SourceWidth; ++x)
+		{
+			uint32_t const* pD{ pRow + x };
+			std::array<uint32_t, 4> const block{ Scale2xPixel(pAbove[x], pD[-1], pD[0], pD[1], pBelow[x]) };
+			pOut0[x * 2] = block[0];
+			pOut0[x * 2 + 1] = block[1];
+			pOut1[x * 2] = block[2];
+			pOut1[x * 2 + 1] = block[3];
+		}
+	}
+
+	void PostProcessor::ScaleEdge3x(uint32_t y, uint32_t* pOut) const noexcept
+	{
+		uint32_t const paddedWidth{ m_SourceWidth + 2 };
+		uint32_t const* pRow{ m_PaddedSource.data() + static_cast<size_t>(y + 1) * paddedWidth + 1 };
+		uint32_t const* pAbove{ pRow - paddedWidth };
+		uint32_t const* pBelow{ pRow + paddedWidth };
+
+		uint32_t* pOut0{ pOut };
+		uint32_t* pOut1{ NextRow(pOut0) };
+		uint32_t* pOut2{ NextRow(pOut1) };
+
+		uint32_t x{ 0 };
+#if NES_EM_SSE2
+		for (; x + 4 <= m_SourceWidth; x += 4)
+		{
+			__m128i const A{ Load(pAbove + x - 1) };
+			__m128i const B{ Load(pAbove + x) };
+			__m128i const C{ Load(pAbove + x + 1) };
+			__m128i const D{ Load(pRow + x - 1) };
+			__m128i const E{ Load(pRow + x) };
+			__m128i const F{ Load(pRow + x + 1) };
+			__m128i const G{ Load(pBelow + x - 1) };
+			__m128i const H{ Load(pBelow + x) };
+			__m128i const I{ Load(pBelow + x + 1) };
+
+			__m128i const edge{ _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(B, H), _mm_cmpeq_epi32(D, F)), _mm_cmpeq_epi32(E, E)) };
+
+			__m128i const DB{ _mm_and_si128(edge, _mm_cmpeq_epi32(D, B)) };
+			__m128i const BF{ _mm_and_si128(edge, _mm_cmpeq_epi32(B, F)) };
+			__m128i const DH{ _mm_and_si128(edge, _mm_cmpeq_epi32(D, H)) };
+			__m128i const HF{ _mm_and_si128(edge, _mm_cmpeq_epi32(H, F)) };
+
+			__m128i const EA{ _mm_cmpeq_epi32(E, A) };
+			__m128i const EC{ _mm_cmpeq_epi32(E, C) };
+			__m128i const EG{ _mm_cmpeq_epi32(E, G) };
+			__m128i const EI{ _mm_cmpeq_epi32(E, I) };
+
+			__m128i const E0{ Select(DB, D, E) };
+			__m128i const E1{ Select(_mm_or_si128(_mm_andnot_si128(EC, DB), _mm_andnot_si128(EA, BF)), B, E) };
+			__m128i const E2{ Select(BF, F, E) };
+			__m128i const E3{ Select(_mm_or_si128(_mm_andnot_si128(EG, DB), _mm_andnot_si128(EA, DH)), D, E) };
+			__m128i const E5{ Select(_mm_or_si128(_mm_andnot_si128(EI, BF), _mm_andnot_si128(EC, HF)), F, E) };
+			__m128i const E6{ Select(DH, D, E) };
+			__m128i const E7{ Select(_mm_or_si128(_mm_andnot_si128(EI, DH), _mm_andnot_si128(EG, HF)), H, E) };
+			__m128i const E8{ Select(HF, F, E) };
+
+			StoreInterleaved3(pOut0 + x * 3, E0, E1, E2);
+			StoreInterleaved3(pOut1 + x * 3, E3, E, E5);
+			StoreInterleaved3(pOut2 + x * 3, E6, E7, E8);
+		}
+#endif
+		for (; x < m_SourceWidth; ++x)
+		{
+			uint32_t const* pA{ pAbove + x };
+			uint32_t const* pD{ pRow + x };
+			uint32_t const* pG{ pBelow + x };
+			std::array<uint32_t, 9> const block{ Scale3xPixel(
+				pA[-1], pA[0], pA[1],
+				pD[-1], pD[0], pD[1],
+				pG[-1], pG[0], pG[1]) };
+
+			std::copy_n(block.data(), 3, pOut0 + x * 3);
+			std::copy_n(block.data() + 3, 3, pOut1 + x * 3);
+			std::copy_n(block.data() + 6, 3, pOut2 + x * 3);
+		}
+	}
+
+	void PostProcessor::ApplyMask(uint32_t* pOut) const noexcept
+	{
+		uint32_t const channels{ OutputWidth() * 4 };
+
+		uint32_t* pRow{ pOut };
+		for (uint32_t row{ 0 }; row < m_Scale; ++row, pRow = NextRow(pRow))
+		{
+			uint8_t* pBytes{ reinterpret_cast<uint8_t*>(pRow) };
+			uint16_t const* pWeights{ m_MaskWeights.data() + static_cast<size_t>(row) * channels };
+
+			uint32_t i{ 0 };
+#if NES_EM_SSE2
+			__m128i const zero{ _mm_setzero_si128() };
+			for (; i + 16 <= channels; i += 16)
+			{
+				__m128i const pixels{ _mm_loadu_si128(reinterpret_cast<__m128i const*>(pBytes + i)) };
+				__m128i const low{ _mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_loadu_si128(reinterpret_cast<__m128i const*>(pWeights + i))) };
+				__m128i const high{ _mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), _mm_loadu_si128(reinterpret_cast<__m128i const*>(pWeights + i + 8))) };
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pBytes + i), _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8)));
+			}
+#endif
+			for (; i < channels; ++i)
+			{
+				pBytes[i] = static_cast<uint8_t>((pBytes[i] * pWeights[i]) >> 8);
+			}
+		}
+	}
+}
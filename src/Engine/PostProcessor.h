@@ -0,0 +1,95 @@
+#ifndef NES_EMULATOR_POST_PROCESSOR
+#define NES_EMULATOR_POST_PROCESSOR
+
+#include <cstdint>
+#include <vector>
+
+#include "BandPool.h"
+
+namespace NesEm
+{
+	// Scales the emulator's ARGB frames up on the CPU, between the palette conversion and the frame texture
+	// The output is split in horizontal bands of source rows over a BandPool,
+	// so the cost per frame stays fixed and small no matter what the host renderer is
+	class PostProcessor final
+	{
+	public:
+		enum class Filter : uint8_t
+		{
+			Nearest, // Every source pixel becomes a scale x scale block
+			Scanlines, // Nearest, the last row of every block is darkened and an aperture grille mask is laid over the columns
+			Edge, // Scale2x / Scale3x, rounds diagonal edges off where neighbouring pixels match, only scale 2 or 3
+			COUNT
+		};
+
+		// Param uint32_t, uint32_t size of the source frames in pixels
+		// Param Filter how to scale
+		// Param uint32_t whole multiple the frames are scaled by, clamped to what the filter supports
+		// Param uint32_t threads the bands are split over including the calling one, 0 picks an amount based on the hardware
+		PostProcessor(uint32_t sourceWidth, uint32_t sourceHeight, Filter filter, uint32_t scale, uint32_t threadCount = 0);
+		~PostProcessor() = default;
+
+		PostProcessor(PostProcessor const&) = delete;
+		PostProcessor(PostProcessor&&) = delete;
+		PostProcessor& operator=(PostProcessor const&) = delete;
+		PostProcessor& operator=(PostProcessor&&) = delete;
+
+		[[nodiscard]] uint32_t OutputWidth() const noexcept { return m_SourceWidth * m_Scale; }
+		[[nodiscard]] uint32_t OutputHeight() const noexcept { return m_SourceHeight * m_Scale; }
+
+		// Param uint32_t const* source frame, rows are tightly packed
+		// Param uint32_t*, int destination of OutputWidth x OutputHeight pixels and the length of one of its rows in bytes
+		// Blocks until every band is written
+		void Process(uint32_t const* pSource, uint32_t* pDestination, int pitch) noexcept;
+
+		// Return uint64_t how long the last Process call took in nanoseconds
+		[[nodiscard]] uint64_t LastProcessTimeNs() const noexcept { return m_LastProcessTimeNs; }
+		// Return uint64_t average time of all Process calls so far in nanoseconds
+		[[nodiscard]] uint64_t AverageProcessTimeNs() const noexcept { return m_ProcessedFrames ? m_TotalProcessTimeNs / m_ProcessedFrames : 0; }
+
+	private:
+		// Brightness out of 256 of the darkened row at the bottom of every block
+		static constexpr uint16_t SCANLINE_BRIGHTNESS{ 160 };
+		// Brightness out of 256 of the two colour channels a column of the aperture grille does not let through
+		static constexpr uint16_t MASK_BRIGHTNESS{ 208 };
+
+		uint32_t const m_SourceWidth;
+		uint32_t const m_SourceHeight;
+		Filter const m_Filter;
+		uint32_t const m_Scale;
+
+		// Per channel multipliers (out of 256) for each of the scale rows in a block, in memory order of the pixels
+		std::vector<uint16_t> m_MaskWeights{ };
+		// Source frame with its edge pixels repeated one pixel outward, so the edge filter never has to bounds check its neighbours
+		std::vector<uint32_t> m_PaddedSource{ };
+
+		// Frame that is being processed
+		uint32_t const* m_pSource{ nullptr };
+		uint32_t* m_pDestination{ nullptr };
+		int m_Pitch{ 0 };
+
+		BandPool m_Pool;
+
+		uint64_t m_LastProcessTimeNs{ 0 };
+		uint64_t m_TotalProcessTimeNs{ 0 };
+		uint64_t m_ProcessedFrames{ 0 };
+
+		// Param uint32_t, uint32_t first source row and the one after the last
+		void ProcessBand(uint32_t first, uint32_t last) const noexcept;
+
+		void PadSource() noexcept;
+
+		// Param uint32_t, uint32_t* source row and the first of its scale output rows, the others follow pitch bytes apart
+		void ScaleNearest(uint32_t y, uint32_t* pOut) const noexcept;
+		void ScaleEdge2x(uint32_t y, uint32_t* pOut) const noexcept;
+		void ScaleEdge3x(uint32_t y, uint32_t* pOut) const noexcept;
+		void ApplyMask(uint32_t* pOut) const noexcept;
+
+		[[nodiscard]] uint32_t* NextRow(uint32_t* pRow) const noexcept
+		{
+			return reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(pRow) + m_Pitch);
+		}
+	};
+}
+
+#endif
@@ -1,8 +1,26 @@
 #ifndef NES_EMULATOR_RENDERER
 #define NES_EMULATOR_RENDERER
 
+#include <cstdint>
+
 namespace NesEm
 {
+	// Pixel memory of the frame texture, valid between LockFrame and UnlockFrame
+	struct FrameLock final
+	{
+		uint32_t* pPixels{ nullptr };
+		// Length of one row in bytes
+		int pitch{ 0 };
+	};
+
+	// How presenting waits for the display
+	enum class VSync : int8_t
+	{
+		Adaptive = -1, // Wait for the display, but present immediately (tearing) when a refresh was already missed
+		Off = 0,
+		On = 1
+	};
+
 	class Renderer
 	{
 	public:
@@ -14,7 +32,22 @@ namespace NesEm
 		Renderer& operator=(Renderer const&) = default;
 		Renderer& operator=(Renderer&&) = default;
 
-		virtual void Render() const = 0;
+		// Presents the frame texture, only when a different frame was uploaded since the last present or the window needs a redraw
+		// Return bool was anything presented
+		virtual bool Render() noexcept = 0;
+
+		// Param uint64_t sequence number of the frame that is about to be written
+		// Return FrameLock memory to write the frame into, pPixels is nullptr when locking failed or the texture already holds that frame
+		[[nodiscard]] virtual FrameLock LockFrame(uint64_t sequence) noexcept = 0;
+		// Uploads whatever was written since LockFrame
+		virtual void UnlockFrame() noexcept = 0;
+
+		// The next Render presents even when the frame did not change (window exposed, resized, ...)
+		virtual void Invalidate() noexcept = 0;
+
+		// Param VSync requested mode, falls back from Adaptive to On to Off when the driver does not support it
+		// Return VSync mode that is actually used
+		virtual VSync SetVSync(VSync mode) noexcept = 0;
 
 		virtual void ToggleFullScreen() noexcept = 0;
 	};
@@ -30,7 +63,13 @@ namespace NesEm
 		NullRenderer& operator=(NullRenderer const&) = default;
 		NullRenderer& operator=(NullRenderer&&) = default;
 
-		void Render() const override {}
+		bool Render() noexcept override { return false; }
+
+		[[nodiscard]] virtual FrameLock LockFrame(uint64_t) noexcept override { return {}; }
+		virtual void UnlockFrame() noexcept override {}
+
+		virtual void Invalidate() noexcept override {}
+		virtual VSync SetVSync(VSync) noexcept override { return VSync::Off; }
 
 		virtual void ToggleFullScreen() noexcept override {}
 	};
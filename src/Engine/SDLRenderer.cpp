@@ -2,7 +2,7 @@
 
 namespace NesEm
 {
-	SDLRenderer::SDLRenderer(Window const& w) :
+	SDLRenderer::SDLRenderer(Window const& w, int frameWidth, int frameHeight) :
 		m_Window{w}
 	{
 		//Clamp aspect ratio to specific size range
@@ -25,10 +25,49 @@ namespace NesEm
 			SDL_Quit();
 		}
 		SDL_Log("%s", "SDL Renderer initialized");
+
+		// Frames are written straight into the texture memory, no intermediate copy is required
+		m_pFrameTexture = SDL_CreateTexture(m_pRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, frameWidth, frameHeight);
+		SDL_assert(m_pFrameTexture);
+		if (!m_pFrameTexture)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "%s", SDL_GetError());
+			SDL_Quit();
+		}
+
+		// Keep the pixels sharp when scaling up
+		SDL_SetTextureScaleMode(m_pFrameTexture, SDL_SCALEMODE_NEAREST);
+
+		// Scale based on user monitor, by whole multiples of the frame size
+		SDL_SetRenderLogicalPresentation(m_pRenderer, frameWidth, frameHeight, SDL_LOGICAL_PRESENTATION_INTEGER_SCALE);
+		SDL_Log("%s", "SDL Frame texture initialized");
+	}
+
+	VSync SDLRenderer::SetVSync(VSync mode) noexcept
+	{
+		// Not every driver can do adaptive vsync, regular vsync is the next best thing
+		while (!SDL_SetRenderVSync(m_pRenderer, static_cast<int>(mode)))
+		{
+			SDL_Log("VSync mode %d not supported: %s", static_cast<int>(mode), SDL_GetError());
+			if (mode == VSync::Off)
+			{
+				break;
+			}
+			mode = (mode == VSync::Adaptive) ? VSync::On : VSync::Off;
+		}
+
+		m_VSync = mode;
+		SDL_Log("VSync mode %d", static_cast<int>(m_VSync));
+		return m_VSync;
 	}
 
 	SDLRenderer::~SDLRenderer()
 	{
+		if (m_pFrameTexture)
+		{
+			SDL_DestroyTexture(m_pFrameTexture);
+		}
+
 		//Destroy the renderer
 		if (m_pRenderer)
 		{
@@ -45,15 +84,52 @@ namespace NesEm
 		SDL_Quit();
 	}
 
-	void SDLRenderer::Render() const
+	bool SDLRenderer::Render() noexcept
 	{
-		//Scale based on user monitor but keep logic at same "canvas size" for game
-		//SDL_SetRenderLogicalPresentation(m_pRenderer, 1920, 1080, SDL_LOGICAL_PRESENTATION_INTEGER_SCALE);
+		// Presenting the same picture again only costs a round trip to the driver (and a wait for vsync)
+		if (m_PresentedSequence == m_UploadedSequence && !m_Invalidated)
+		{
+			return false;
+		}
 
-		SDL_SetRenderDrawColor(m_pRenderer, 0, 0, 100, 255);
+		// Clear the letterbox area
+		SDL_SetRenderDrawColor(m_pRenderer, 0, 0, 0, 255);
 		SDL_RenderClear(m_pRenderer);
 
+		SDL_RenderTexture(m_pRenderer, m_pFrameTexture, nullptr, nullptr);
+
 		SDL_RenderPresent(m_pRenderer);
+
+		m_PresentedSequence = m_UploadedSequence;
+		m_Invalidated = false;
+		return true;
+	}
+
+	FrameLock SDLRenderer::LockFrame(uint64_t sequence) noexcept
+	{
+		FrameLock lock{ };
+
+		if (sequence == m_UploadedSequence)
+		{
+			return lock;
+		}
+
+		void* pPixels{ nullptr };
+		if (!SDL_LockTexture(m_pFrameTexture, nullptr, &pPixels, &lock.pitch))
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "%s", SDL_GetError());
+			return {};
+		}
+
+		lock.pPixels = static_cast<uint32_t*>(pPixels);
+		m_LockedSequence = sequence;
+		return lock;
+	}
+
+	void SDLRenderer::UnlockFrame() noexcept
+	{
+		SDL_UnlockTexture(m_pFrameTexture);
+		m_UploadedSequence = m_LockedSequence;
 	}
 
 	void SDLRenderer::ToggleFullScreen() noexcept
@@ -68,7 +144,8 @@ namespace NesEm
 			if (!SDL_SetWindowFullscreen(m_Window.pWindow, true))
 				SDL_LogError(SDL_LOG_CATEGORY_ERROR, "%s", "Failed to enable fullscreen mode");
 		}
-		
+
+		Invalidate();
 	}
 
 }
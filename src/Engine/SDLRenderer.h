@@ -19,7 +19,9 @@ namespace NesEm
 	class SDLRenderer final : public Renderer
 	{
 	public:
-		SDLRenderer(Window const& w);
+		// Param Window the window to create and render to
+		// Param int, int size in pixels of the frames that will be uploaded
+		SDLRenderer(Window const& w, int frameWidth, int frameHeight);
 		~SDLRenderer() override;
 
 		SDLRenderer(SDLRenderer const&) = delete;
@@ -27,13 +29,31 @@ namespace NesEm
 		SDLRenderer& operator=(SDLRenderer const&) = delete;
 		SDLRenderer& operator=(SDLRenderer&&) = delete;
 
-		void Render() const override;
+		bool Render() noexcept override;
+
+		[[nodiscard]] virtual FrameLock LockFrame(uint64_t sequence) noexcept override;
+		virtual void UnlockFrame() noexcept override;
+
+		virtual void Invalidate() noexcept override { m_Invalidated = true; }
+		virtual VSync SetVSync(VSync mode) noexcept override;
 
 		virtual void ToggleFullScreen() noexcept override;
 
 	private:
 		SDLWindow m_Window;
 		SDL_Renderer* m_pRenderer{ nullptr };
+
+		// Streaming texture the emulator writes its frames into
+		SDL_Texture* m_pFrameTexture{ nullptr };
+
+		// Sequence numbers of the frame being written, the one in the texture and the one on screen
+		static constexpr uint64_t NO_FRAME{ UINT64_MAX };
+		uint64_t m_LockedSequence{ NO_FRAME };
+		uint64_t m_UploadedSequence{ NO_FRAME };
+		uint64_t m_PresentedSequence{ NO_FRAME };
+		bool m_Invalidated{ true };
+
+		VSync m_VSync{ VSync::Off };
 	};
 }
 
@@ -0,0 +1,107 @@
+#include "Timer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace NesEm
+{
+	void GameTime::SetFrameRate(uint32_t numerator, uint32_t denominator) noexcept
+	{
+		assert(numerator > 0 && denominator > 0);
+
+		m_RateNumerator = numerator;
+		m_PeriodNs = NS_PER_SECOND * denominator / numerator;
+		m_PeriodRemainder = NS_PER_SECOND * denominator % numerator;
+
+		m_DeadlineNs = SDL_GetTicksNS();
+		m_DeadlineRemainder = 0;
+		m_FrameStartNs = 0;
+	}
+
+	void GameTime::Update() noexcept
+	{
+		uint64_t const currentTime{ SDL_GetTicksNS() };
+		m_ElapsedSec = static_cast<float>(static_cast<double>(currentTime - m_LastTimeNs) / NS_PER_SECOND);
+		m_LastTimeNs = currentTime;
+	}
+
+	void GameTime::WaitForNextFrame() noexcept
+	{
+		uint64_t now{ SDL_GetTicksNS() };
+		if (now < m_DeadlineNs)
+		{
+			SDL_DelayPrecise(m_DeadlineNs - now);
+			now = SDL_GetTicksNS();
+		}
+		else if (now - m_DeadlineNs > MAX_FRAMES_BEHIND * m_PeriodNs)
+		{
+			// Stalled (window dragged, debugger, ...), the missed frames are gone
+			m_DeadlineNs = now;
+			m_DeadlineRemainder = 0;
+			m_FrameStartNs = 0;
+			++m_Resyncs;
+		}
+
+		MeasureFrame(now);
+		AdvanceDeadline();
+	}
+
+	GameTime::FrameStatistics GameTime::FrameStats() const noexcept
+	{
+		constexpr double NS_PER_MS{ 1'000'000.0 };
+
+		FrameStatistics stats{ };
+		stats.measurements = m_Measurements;
+		if (m_Measurements > 0)
+		{
+			stats.average = static_cast<float>(m_MeanNs / NS_PER_MS);
+			stats.min = static_cast<float>(static_cast<double>(m_MinNs) / NS_PER_MS);
+			stats.max = static_cast<float>(static_cast<double>(m_MaxNs) / NS_PER_MS);
+			stats.jitter = static_cast<float>(std::sqrt(m_SquaresNs / static_cast<double>(m_Measurements)) / NS_PER_MS);
+		}
+		stats.drift = static_cast<float>(static_cast<double>(m_DriftNs) / NS_PER_MS);
+		stats.maxDrift = static_cast<float>(static_cast<double>(m_MaxDriftNs) / NS_PER_MS);
+		return stats;
+	}
+
+	void GameTime::ResetFrameStats() noexcept
+	{
+		m_Measurements = 0;
+		m_MeanNs = 0.0;
+		m_SquaresNs = 0.0;
+		m_MinNs = 0;
+		m_MaxNs = 0;
+		m_MaxDriftNs = 0;
+	}
+
+	void GameTime::MeasureFrame(uint64_t startNs) noexcept
+	{
+		m_DriftNs = static_cast<int64_t>(startNs - m_DeadlineNs);
+		m_MaxDriftNs = std::max(m_MaxDriftNs, m_DriftNs);
+
+		// The first frame after a restart has nothing to be measured from
+		if (m_FrameStartNs != 0)
+		{
+			uint64_t const frameNs{ startNs - m_FrameStartNs };
+			m_MinNs = (m_Measurements == 0) ? frameNs : std::min(m_MinNs, frameNs);
+			m_MaxNs = (m_Measurements == 0) ? frameNs : std::max(m_MaxNs, frameNs);
+
+			++m_Measurements;
+			double const difference{ static_cast<double>(frameNs) - m_MeanNs };
+			m_MeanNs += difference / static_cast<double>(m_Measurements);
+			m_SquaresNs += difference * (static_cast<double>(frameNs) - m_MeanNs);
+		}
+		m_FrameStartNs = startNs;
+	}
+
+	void GameTime::AdvanceDeadline() noexcept
+	{
+		m_DeadlineNs += m_PeriodNs;
+		m_DeadlineRemainder += m_PeriodRemainder;
+		if (m_DeadlineRemainder >= m_RateNumerator)
+		{
+			++m_DeadlineNs;
+			m_DeadlineRemainder -= m_RateNumerator;
+		}
+	}
+}
@@ -9,39 +9,52 @@
 	#include <SDL3/SDL.h>
 #pragma warning (pop)
 
+#include <cstdint>
+
 namespace NesEm
 {
+	// Frame clock in whole nanoseconds (SDL_GetTicksNS)
+	// Every frame has a deadline a whole frame period after the one before, the period is an exact fraction (e.g. 50.007 Hz)
+	// whose leftover nanoseconds are carried, so a late frame never pushes the frames after it back and the long run rate is exact
 	class GameTime final : public Singleton<GameTime>
 	{
 	public:
-		[[nodiscard]] inline float ElapsedSec() const noexcept { return m_ElapsedSec; }
-		[[nodiscard]] inline float FixedTimeStep() const { return (m_MsFixedTimeStep / 1000.f); }
+		// Frame times in milliseconds, between the starts of consecutive frames, jitter is their standard deviation
+		// Drift is how far the latest frame started after its deadline, max drift the furthest any did
+		struct FrameStatistics final
+		{
+			float average{ 0.f };
+			float min{ 0.f };
+			float max{ 0.f };
+			float jitter{ 0.f };
+			float drift{ 0.f };
+			float maxDrift{ 0.f };
+			uint64_t measurements{ 0 };
+		};
 
-		[[nodiscard]] inline bool IsLag() const noexcept { return m_MsLag >= m_MsFixedTimeStep; }
-		inline void ProcessLag() noexcept { m_MsLag -= m_MsFixedTimeStep; }
+		[[nodiscard]] float ElapsedSec() const noexcept { return m_ElapsedSec; }
+		// Return uint64_t nanoseconds per frame, without the fraction
+		[[nodiscard]] uint64_t FramePeriodNs() const noexcept { return m_PeriodNs; }
 
-		inline void Update() noexcept
-		{
-			const auto currentTime = SDL_GetPerformanceCounter();
-			m_ElapsedSec = static_cast<float>((currentTime - m_LastTime) * m_SecondsPerCount);
-			if (m_ElapsedSec < 0.0f)
-				m_ElapsedSec = 0.0f;
+		// Param uint32_t, uint32_t frames per second as a fraction, e.g. Config::FRAME_RATE_NUMERATOR / FRAME_RATE_DENOMINATOR
+		// Restarts the deadlines from now
+		void SetFrameRate(uint32_t numerator, uint32_t denominator) noexcept;
 
-			m_MsLag += m_ElapsedSec * 1000.f;
-			m_LastTime = currentTime;
-		}
+		// Call once at the start of every loop iteration, measures the time since the last call
+		void Update() noexcept;
 
-		[[nodiscard]] inline auto SleepTime() const noexcept
-		{
-			const auto sleepTime = m_LastTime * m_SecondsPerCount + m_MsPerFrame - SDL_GetPerformanceCounter() * m_SecondsPerCount;
-			return (sleepTime > 0.0f) ? static_cast<uint32_t>(sleepTime) : 0u;
-		}
+		// Return bool did the next frame's deadline already pass when Update was called, a full frame behind
+		[[nodiscard]] bool IsBehind() const noexcept { return m_LastTimeNs >= m_DeadlineNs; }
 
-		void SetFPS(float fps) noexcept
-		{
-			m_MsPerFrame = 1000.f / fps;
-			m_MsFixedTimeStep = m_MsPerFrame + 3.3f; // hard coded value, based on 60 FPS may need to be adjusted in future
-		}
+		// Waits for the next frame's deadline, sleeps until shortly before it and spins the rest (SDL_DelayPrecise)
+		// Returns right away when it passed, more than MAX_FRAMES_BEHIND late restarts the deadlines from now
+		// instead of running frames back to back to catch up
+		void WaitForNextFrame() noexcept;
+
+		[[nodiscard]] FrameStatistics FrameStats() const noexcept;
+		void ResetFrameStats() noexcept;
+		// Return uint64_t times the deadlines were restarted
+		[[nodiscard]] uint64_t ResyncCount() const noexcept { return m_Resyncs; }
 
 		GameTime(const GameTime&) = delete;
 		GameTime(GameTime&&) = delete;
@@ -53,16 +66,36 @@ namespace NesEm
 		GameTime() = default;
 		~GameTime() = default;
 
-		uint64_t m_LastTime{ SDL_GetPerformanceCounter() };
+		static constexpr uint64_t NS_PER_SECOND{ 1'000'000'000 };
+		static constexpr uint64_t MAX_FRAMES_BEHIND{ 3 };
 
-		const double m_SecondsPerCount{ 1.0 / static_cast<double>(SDL_GetPerformanceFrequency()) };
+		// Frame period, m_PeriodNs + m_PeriodRemainder / m_RateNumerator nanoseconds
+		uint32_t m_RateNumerator{ 60 };
+		uint64_t m_PeriodNs{ NS_PER_SECOND / 60 };
+		uint64_t m_PeriodRemainder{ NS_PER_SECOND % 60 };
 
-		float m_MsPerFrame{ 16.7f };
-		float m_MsFixedTimeStep{ 20.f };
+		// Deadline of the next frame, m_DeadlineRemainder / m_RateNumerator nanoseconds later in fact
+		uint64_t m_DeadlineNs{ SDL_GetTicksNS() };
+		uint64_t m_DeadlineRemainder{ 0 };
 
+		uint64_t m_LastTimeNs{ SDL_GetTicksNS() };
 		float m_ElapsedSec{ 0.f };
-		float m_MsLag{ 0.f };
+
+		// Statistics, frame times as a running mean and sum of squared differences from it (Welford)
+		uint64_t m_FrameStartNs{ 0 };
+		uint64_t m_Measurements{ 0 };
+		double m_MeanNs{ 0.0 };
+		double m_SquaresNs{ 0.0 };
+		uint64_t m_MinNs{ 0 };
+		uint64_t m_MaxNs{ 0 };
+		int64_t m_DriftNs{ 0 };
+		int64_t m_MaxDriftNs{ 0 };
+		uint64_t m_Resyncs{ 0 };
+
+		// Param uint64_t when the frame started
+		void MeasureFrame(uint64_t startNs) noexcept;
+		void AdvanceDeadline() noexcept;
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
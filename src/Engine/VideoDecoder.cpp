@@ -0,0 +1,255 @@
+#include "VideoDecoder.h"
+
+#include "VideoRecorder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace NesEm
+{
+	namespace
+	{
+		[[nodiscard]] uint32_t ReadLittleEndian(uint8_t const* pData, uint32_t bytes) noexcept
+		{
+			uint32_t value{ 0 };
+			for (uint32_t i{ 0 }; i < bytes; ++i)
+			{
+				value |= static_cast<uint32_t>(pData[i]) << (i * 8);
+			}
+			return value;
+		}
+	}
+
+	VideoDecoder::VideoDecoder(std::filesystem::path const& path):
+		m_File{ path, std::ios::binary | std::ios::in }
+	{
+		if (!m_File.is_open())
+		{
+			throw std::runtime_error("Can not open video file: " + path.string());
+		}
+
+		std::array<uint8_t, VideoRecorder::HEADER_SIZE> header{ };
+		m_File.read(reinterpret_cast<char*>(header.data()), header.size());
+		if (!m_File || std::memcmp(header.data(), "NESV", 4) != 0)
+		{
+			throw std::runtime_error("Invalid video file: " + path.string());
+		}
+
+		if (ReadLittleEndian(&header[4], 2) != VideoRecorder::VERSION)
+		{
+			throw std::runtime_error("Unsupported video file version: " + path.string());
+		}
+
+		m_Width = ReadLittleEndian(&header[6], 2);
+		m_Height = ReadLittleEndian(&header[8], 2);
+		m_FrameRateNumerator = ReadLittleEndian(&header[12], 4);
+		m_FrameRateDenominator = ReadLittleEndian(&header[16], 4);
+
+		if (m_Width == 0 || m_Height == 0 || m_Width % VideoRecorder::TILE_SIZE != 0 || m_Height % VideoRecorder::TILE_SIZE != 0)
+		{
+			throw std::runtime_error("Invalid video size: " + path.string());
+		}
+
+		m_TilesX = m_Width / VideoRecorder::TILE_SIZE;
+		m_TilesY = m_Height / VideoRecorder::TILE_SIZE;
+		m_Indices.resize(static_cast<size_t>(m_Width) * m_Height);
+		m_Emphasis.resize(m_Height);
+
+		size_t const tileCount{ static_cast<size_t>(m_TilesX) * m_TilesY };
+		m_MaxPacketSize = m_Height + (tileCount + 7) / 8 + tileCount * (1 + VideoRecorder::TILE_SIZE * VideoRecorder::TILE_SIZE);
+	}
+
+	bool VideoDecoder::ReadFrame()
+	{
+		using PacketType = VideoRecorder::PacketType;
+
+		std::array<uint8_t, VideoRecorder::PACKET_HEADER_SIZE> header{ };
+		if (!m_File.read(reinterpret_cast<char*>(header.data()), header.size()))
+		{
+			return false;
+		}
+
+		auto const type{ static_cast<PacketType>(header[0]) };
+		uint8_t const flags{ header[1] };
+		uint32_t const size{ ReadLittleEndian(&header[2], 4) };
+
+		// The size comes from the file, don't let a corrupt one ask for gigabytes
+		if (size > m_MaxPacketSize)
+		{
+			throw std::runtime_error("Corrupt video file, packet of " + std::to_string(size) + " bytes after frame " + std::to_string(m_FrameCount));
+		}
+
+		m_Packet.resize(size);
+		if (!m_File.read(reinterpret_cast<char*>(m_Packet.data()), size))
+		{
+			// Cut off while recording
+			return false;
+		}
+
+		// Deltas and repeats build on a picture, a recording always starts with a keyframe
+		if (type != PacketType::Keyframe && !m_HasKeyframe)
+		{
+			return false;
+		}
+
+		size_t offset{ 0 };
+		if (flags & VideoRecorder::EMPHASIS_FLAG)
+		{
+			if (size < m_Height)
+			{
+				return false;
+			}
+			std::copy_n(m_Packet.begin(), m_Height, m_Emphasis.begin());
+			offset = m_Height;
+		}
+
+		switch (type)
+		{
+		case PacketType::Keyframe:
+			if (!DecodeTiles(offset, { }))
+			{
+				return false;
+			}
+			m_HasKeyframe = true;
+			break;
+
+		case PacketType::Delta:
+		{
+			size_t const maskSize{ (static_cast<size_t>(m_TilesX) * m_TilesY + 7) / 8 };
+			if (size < offset + maskSize)
+			{
+				return false;
+			}
+
+			if (!DecodeTiles(offset + maskSize, std::span<uint8_t const>{ m_Packet }.subspan(offset, maskSize)))
+			{
+				return false;
+			}
+		}break;
+
+		case PacketType::Repeat:
+			break;
+
+		default:
+			return false;
+		}
+
+		++m_FrameCount;
+		return true;
+	}
+
+	bool VideoDecoder::DecodeTiles(size_t offset, std::span<uint8_t const> mask) noexcept
+	{
+		using TileMode = VideoRecorder::TileMode;
+		constexpr uint32_t TILE_SIZE{ VideoRecorder::TILE_SIZE };
+
+		uint32_t const tileCount{ m_TilesX * m_TilesY };
+		for (uint32_t tile{ 0 }; tile < tileCount; ++tile)
+		{
+			// An empty mask means every tile is stored
+			if (!mask.empty() && !(mask[tile / 8] & (1 << (tile % 8))))
+			{
+				continue;
+			}
+
+			if (offset >= m_Packet.size())
+			{
+				return false;
+			}
+
+			uint8_t* const pTile{ m_Indices.data() + (static_cast<size_t>(tile / m_TilesX) * m_Width + tile % m_TilesX) * TILE_SIZE };
+			auto const mode{ static_cast<TileMode>(m_Packet[offset++]) };
+			if (mode == TileMode::Solid)
+			{
+				if (offset >= m_Packet.size())
+				{
+					return false;
+				}
+
+				uint8_t const index{ m_Packet[offset++] };
+				for (uint32_t y{ 0 }; y < TILE_SIZE; ++y)
+				{
+					std::fill_n(pTile + y * m_Width, TILE_SIZE, index);
+				}
+			}
+			else if (mode == TileMode::Raw)
+			{
+				if (offset + TILE_SIZE * TILE_SIZE > m_Packet.size())
+				{
+					return false;
+				}
+
+				for (uint32_t y{ 0 }; y < TILE_SIZE; ++y)
+				{
+					std::copy_n(m_Packet.begin() + offset, TILE_SIZE, pTile + y * m_Width);
+					offset += TILE_SIZE;
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	uint64_t ExportY4M(std::filesystem::path const& recording, std::filesystem::path const& output, std::span<uint32_t const, 64> palette)
+	{
+		VideoDecoder decoder{ recording };
+
+		std::ofstream file{ output, std::ios::binary | std::ios::out | std::ios::trunc };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Can not create file: " + output.string());
+		}
+
+		// BT.601 limited range, what players assume for standard definition video
+		std::array<std::array<uint8_t, 3>, 64> yuv{ };
+		for (size_t i{ 0 }; i < palette.size(); ++i)
+		{
+			int const r{ static_cast<int>((palette[i] >> 16) & 0xFF) };
+			int const g{ static_cast<int>((palette[i] >> 8) & 0xFF) };
+			int const b{ static_cast<int>(palette[i] & 0xFF) };
+
+			yuv[i][0] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+			yuv[i][1] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+			yuv[i][2] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+		}
+
+		// Full resolution chroma, NES pixels are sharp
+		std::string const header{ "YUV4MPEG2 W" + std::to_string(decoder.Width())
+			+ " H" + std::to_string(decoder.Height())
+			+ " F" + std::to_string(decoder.FrameRateNumerator()) + ":" + std::to_string(decoder.FrameRateDenominator())
+			+ " Ip A1:1 C444\n" };
+		file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+		size_t const planeSize{ static_cast<size_t>(decoder.Width()) * decoder.Height() };
+		std::vector<uint8_t> planes(planeSize * 3);
+
+		// Emphasis is not applied, same as the ARGB conversion the emulator displays
+		while (decoder.ReadFrame())
+		{
+			std::span<uint8_t const> const indices{ decoder.Indices() };
+			for (size_t i{ 0 }; i < planeSize; ++i)
+			{
+				std::array<uint8_t, 3> const& colour{ yuv[indices[i] & 0x3F] };
+				planes[i] = colour[0];
+				planes[planeSize + i] = colour[1];
+				planes[planeSize * 2 + i] = colour[2];
+			}
+
+			constexpr std::string_view FRAME_HEADER{ "FRAME\n" };
+			file.write(FRAME_HEADER.data(), static_cast<std::streamsize>(FRAME_HEADER.size()));
+			file.write(reinterpret_cast<char const*>(planes.data()), static_cast<std::streamsize>(planes.size()));
+		}
+
+		if (!file)
+		{
+			throw std::runtime_error("Could not write file: " + output.string());
+		}
+		return decoder.FrameCount();
+	}
+}
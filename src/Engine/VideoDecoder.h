@@ -0,0 +1,79 @@
+#ifndef NES_EMULATOR_VIDEO_DECODER
+#define NES_EMULATOR_VIDEO_DECODER
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+
+/* Sources used during development of the Y4M export:
+ * https://wiki.multimedia.cx/index.php/YUV4MPEG2
+ */
+
+namespace NesEm
+{
+	// Reads the tile delta recordings VideoRecorder writes back frame by frame
+	class VideoDecoder final
+	{
+	public:
+		// Param std::filesystem::path recording to read
+		// Throws std::runtime_error when the file can not be opened or is not a recording
+		explicit VideoDecoder(std::filesystem::path const& path);
+		~VideoDecoder() = default;
+
+		VideoDecoder(VideoDecoder const&) = delete;
+		VideoDecoder(VideoDecoder&&) = delete;
+		VideoDecoder& operator=(VideoDecoder const&) = delete;
+		VideoDecoder& operator=(VideoDecoder&&) = delete;
+
+		[[nodiscard]] uint32_t Width() const noexcept { return m_Width; }
+		[[nodiscard]] uint32_t Height() const noexcept { return m_Height; }
+		[[nodiscard]] uint32_t FrameRateNumerator() const noexcept { return m_FrameRateNumerator; }
+		[[nodiscard]] uint32_t FrameRateDenominator() const noexcept { return m_FrameRateDenominator; }
+
+		// Reconstructs the next frame
+		// Return bool was there a complete and valid frame, false at the end of the recording
+		// Throws std::runtime_error when a packet is larger than any frame encodes to, the file is corrupt
+		[[nodiscard]] bool ReadFrame();
+
+		// Return std::span palette indices of the last read frame, Width x Height
+		[[nodiscard]] std::span<uint8_t const> Indices() const noexcept { return m_Indices; }
+		// Return std::span emphasis bits of every scanline of the last read frame
+		[[nodiscard]] std::span<uint8_t const> Emphasis() const noexcept { return m_Emphasis; }
+		// Return uint64_t frames read so far
+		[[nodiscard]] uint64_t FrameCount() const noexcept { return m_FrameCount; }
+
+	private:
+		std::ifstream m_File{ };
+
+		uint32_t m_Width{ 0 };
+		uint32_t m_Height{ 0 };
+		uint32_t m_TilesX{ 0 };
+		uint32_t m_TilesY{ 0 };
+		uint32_t m_FrameRateNumerator{ 0 };
+		uint32_t m_FrameRateDenominator{ 0 };
+
+		std::vector<uint8_t> m_Indices{ };
+		std::vector<uint8_t> m_Emphasis{ };
+		std::vector<uint8_t> m_Packet{ };
+		// Payload of a frame whose tiles are all stored raw, with emphasis and tile mask, no valid packet is larger
+		size_t m_MaxPacketSize{ 0 };
+		bool m_HasKeyframe{ false };
+		uint64_t m_FrameCount{ 0 };
+
+		// Param size_t, bool read position in m_Packet and the tiles to decode
+		// Return bool did the tiles fit in the packet
+		[[nodiscard]] bool DecodeTiles(size_t offset, std::span<uint8_t const> mask) noexcept;
+	};
+
+	// Decodes a whole recording to an uncompressed YUV4MPEG2 (4:4:4) file most video tools read
+	// Param std::filesystem::path recording to read
+	// Param std::filesystem::path .y4m file to write
+	// Param std::span ARGB8888 colour of every palette index
+	// Return uint64_t frames written
+	// Throws std::runtime_error when either file can not be opened
+	uint64_t ExportY4M(std::filesystem::path const& recording, std::filesystem::path const& output, std::span<uint32_t const, 64> palette);
+}
+
+#endif
@@ -0,0 +1,279 @@
+#include "VideoRecorder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace NesEm
+{
+	namespace
+	{
+		void AppendLittleEndian(std::vector<uint8_t>& out, uint32_t value, uint32_t bytes)
+		{
+			for (uint32_t i{ 0 }; i < bytes; ++i)
+			{
+				out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+			}
+		}
+	}
+
+	VideoRecorder::VideoRecorder(std::filesystem::path const& path, uint32_t width, uint32_t height, uint32_t frameRateNumerator, uint32_t frameRateDenominator, uint32_t keyframeInterval):
+		m_Width{ width },
+		m_Height{ height },
+		m_TilesX{ width / TILE_SIZE },
+		m_TilesY{ height / TILE_SIZE },
+		m_KeyframeInterval{ std::max(keyframeInterval, 1u) }
+	{
+		assert(width % TILE_SIZE == 0 && height % TILE_SIZE == 0);
+
+		m_File.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+		if (!m_File.is_open())
+		{
+			throw std::runtime_error("Can not create video file: " + path.string());
+		}
+
+		std::vector<uint8_t> header{ 'N', 'E', 'S', 'V' };
+		AppendLittleEndian(header, VERSION, 2);
+		AppendLittleEndian(header, m_Width, 2);
+		AppendLittleEndian(header, m_Height, 2);
+		AppendLittleEndian(header, 0, 2);
+		AppendLittleEndian(header, frameRateNumerator, 4);
+		AppendLittleEndian(header, frameRateDenominator, 4);
+		assert(header.size() == HEADER_SIZE);
+		m_File.write(reinterpret_cast<char const*>(header.data()), static_cast<std::streamsize>(header.size()));
+		m_WrittenBytes = header.size();
+
+		// Swapped with the pool buffers, so it needs the same size
+		m_Previous.indices.resize(static_cast<size_t>(m_Width) * m_Height);
+		m_Previous.emphasis.resize(m_Height);
+
+		m_Buffers.resize(POOL_SIZE);
+		for (uint8_t buffer{ 0 }; buffer < POOL_SIZE; ++buffer)
+		{
+			m_Buffers[buffer].indices.resize(static_cast<size_t>(m_Width) * m_Height);
+			m_Buffers[buffer].emphasis.resize(m_Height);
+
+			// Filled before the writer starts, after that only the writer pushes
+			[[maybe_unused]] bool const pushed{ m_FreeBuffers.TryPush(buffer) };
+			assert(pushed);
+		}
+
+		m_Thread = std::thread{ &VideoRecorder::Run, this };
+	}
+
+	VideoRecorder::~VideoRecorder()
+	{
+		Job const stop{ Job::Type::Stop };
+		while (!m_Jobs.TryPush(stop))
+		{
+			std::this_thread::yield();
+		}
+		m_Jobs.Notify();
+
+		m_Thread.join();
+	}
+
+	void VideoRecorder::SubmitFrame(std::span<uint8_t const> indices, std::span<uint8_t const> emphasis, bool isNewPicture) noexcept
+	{
+		assert(indices.size() >= static_cast<size_t>(m_Width) * m_Height);
+		assert(emphasis.size() >= m_Height);
+
+		Job job{ Job::Type::Repeat };
+
+		// The writer needs a picture to repeat, so the first frame is always copied
+		if (isNewPicture || !m_HasSubmitted)
+		{
+			uint8_t buffer{ 0 };
+			if (!m_FreeBuffers.TryPop(buffer))
+			{
+				// A lossless recording can't skip frames, the writer frees a buffer as soon as it finished one
+				++m_Stalls;
+				while (!m_FreeBuffers.TryPop(buffer))
+				{
+					std::this_thread::yield();
+				}
+			}
+
+			Frame& frame{ m_Buffers[buffer] };
+			std::copy_n(indices.begin(), frame.indices.size(), frame.indices.begin());
+			std::copy_n(emphasis.begin(), frame.emphasis.size(), frame.emphasis.begin());
+
+			job = { Job::Type::Frame, buffer };
+			m_HasSubmitted = true;
+		}
+
+		// Repeats don't hold a buffer, wait when the queue is full of them
+		while (!m_Jobs.TryPush(job))
+		{
+			std::this_thread::yield();
+		}
+		m_Jobs.Notify();
+	}
+
+	void VideoRecorder::Run() noexcept
+	{
+		Job job{ };
+		while (true)
+		{
+			if (!m_Jobs.TryPop(job))
+			{
+				m_Jobs.WaitForData();
+				continue;
+			}
+
+			switch (job.type)
+			{
+			case Job::Type::Frame:
+			{
+				EncodeFrame(m_Buffers[job.buffer]);
+
+				[[maybe_unused]] bool const pushed{ m_FreeBuffers.TryPush(job.buffer) };
+				assert(pushed);
+			}break;
+
+			case Job::Type::Repeat:
+				// Keyframes are still written on time, seeking in a long static scene must not have to go back to its start
+				if (m_FramesSinceKeyframe >= m_KeyframeInterval)
+				{
+					EncodeFrame(m_Previous);
+				}
+				else
+				{
+					m_Packet.clear();
+					WritePacket(PacketType::Repeat, 0);
+					++m_FramesSinceKeyframe;
+				}
+				break;
+
+			case Job::Type::Stop:
+				m_File.flush();
+				return;
+
+			default: break;
+			}
+		}
+	}
+
+	void VideoRecorder::EncodeFrame(Frame& frame) noexcept
+	{
+		uint32_t const tileCount{ m_TilesX * m_TilesY };
+		bool const isKeyframe{ !m_HasPrevious || m_FramesSinceKeyframe >= m_KeyframeInterval };
+		bool const hasEmphasis{ isKeyframe || frame.emphasis != m_Previous.emphasis };
+
+		m_Packet.clear();
+		if (hasEmphasis)
+		{
+			m_Packet.insert(m_Packet.end(), frame.emphasis.begin(), frame.emphasis.end());
+		}
+
+		bool hasChangedTiles{ false };
+		if (isKeyframe)
+		{
+			for (uint32_t tile{ 0 }; tile < tileCount; ++tile)
+			{
+				EncodeTile(frame, tile);
+			}
+		}
+		else
+		{
+			size_t const mask{ m_Packet.size() };
+			m_Packet.resize(mask + (tileCount + 7) / 8);
+
+			for (uint32_t tile{ 0 }; tile < tileCount; ++tile)
+			{
+				if (!IsTileEqual(frame, tile))
+				{
+					m_Packet[mask + tile / 8] |= static_cast<uint8_t>(1 << (tile % 8));
+					EncodeTile(frame, tile);
+					hasChangedTiles = true;
+				}
+			}
+		}
+
+		if (isKeyframe)
+		{
+			WritePacket(PacketType::Keyframe, EMPHASIS_FLAG);
+			m_FramesSinceKeyframe = 0;
+		}
+		else if (hasChangedTiles || hasEmphasis)
+		{
+			WritePacket(PacketType::Delta, hasEmphasis ? EMPHASIS_FLAG : 0);
+		}
+		else
+		{
+			// Submitted as new, but nothing the recording holds changed
+			m_Packet.clear();
+			WritePacket(PacketType::Repeat, 0);
+		}
+		++m_FramesSinceKeyframe;
+
+		// The submitted frame becomes the reference, the pool buffer gets the old one to be overwritten
+		if (&frame != &m_Previous)
+		{
+			std::swap(frame, m_Previous);
+		}
+		m_HasPrevious = true;
+	}
+
+	void VideoRecorder::EncodeTile(Frame const& frame, uint32_t tile) noexcept
+	{
+		uint8_t const* const pTile{ frame.indices.data() + TileOffset(tile) };
+
+		bool isSolid{ true };
+		for (uint32_t y{ 0 }; y < TILE_SIZE && isSolid; ++y)
+		{
+			uint8_t const* const pRow{ pTile + y * m_Width };
+			isSolid = std::all_of(pRow, pRow + TILE_SIZE, [first{ pTile[0] }](uint8_t index) { return index == first; });
+		}
+
+		if (isSolid)
+		{
+			m_Packet.push_back(static_cast<uint8_t>(TileMode::Solid));
+			m_Packet.push_back(pTile[0]);
+			return;
+		}
+
+		m_Packet.push_back(static_cast<uint8_t>(TileMode::Raw));
+		for (uint32_t y{ 0 }; y < TILE_SIZE; ++y)
+		{
+			uint8_t const* const pRow{ pTile + y * m_Width };
+			m_Packet.insert(m_Packet.end(), pRow, pRow + TILE_SIZE);
+		}
+	}
+
+	bool VideoRecorder::IsTileEqual(Frame const& frame, uint32_t tile) const noexcept
+	{
+		size_t const offset{ TileOffset(tile) };
+		for (uint32_t y{ 0 }; y < TILE_SIZE; ++y)
+		{
+			size_t const row{ offset + y * m_Width };
+			if (std::memcmp(frame.indices.data() + row, m_Previous.indices.data() + row, TILE_SIZE) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void VideoRecorder::WritePacket(PacketType type, uint8_t flags) noexcept
+	{
+		std::array<uint8_t, PACKET_HEADER_SIZE> header{ static_cast<uint8_t>(type), flags };
+		uint32_t const size{ static_cast<uint32_t>(m_Packet.size()) };
+		for (uint32_t i{ 0 }; i < 4; ++i)
+		{
+			header[2 + i] = static_cast<uint8_t>(size >> (i * 8));
+		}
+
+		m_File.write(reinterpret_cast<char const*>(header.data()), static_cast<std::streamsize>(header.size()));
+		m_File.write(reinterpret_cast<char const*>(m_Packet.data()), static_cast<std::streamsize>(m_Packet.size()));
+		if (!m_File && !m_HasWriteError)
+		{
+			SDL_Log("%s", "Could not write to the video file, the rest of the recording is lost");
+			m_HasWriteError = true;
+		}
+
+		m_WrittenBytes.fetch_add(header.size() + m_Packet.size(), std::memory_order_relaxed);
+		m_WrittenFrames.fetch_add(1, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,147 @@
+#ifndef NES_EMULATOR_VIDEO_RECORDER
+#define NES_EMULATOR_VIDEO_RECORDER
+
+#include "SPSCRing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace NesEm
+{
+	// Lossless recording of the PPU's output (palette indices + per scanline emphasis) for long sessions
+	// Frames are cut in 8x8 tiles and only the tiles that changed since the previous frame are stored, with a full keyframe every so often
+	// Submitting a frame copies it into a pooled buffer, diffing and writing happen on a background thread
+	//
+	// File format, all values little endian:
+	//   Header: "NESV", u16 version, u16 width, u16 height, u16 reserved, u32 frame rate numerator, u32 frame rate denominator
+	//   Packet per frame: u8 type, u8 flags, u32 payload size, payload
+	//     Type: 0 keyframe (every tile), 1 delta (changed tiles), 2 repeat (same picture as the previous frame, no payload)
+	//     Flags: bit 0 the payload starts with the emphasis of every scanline (always set on keyframes)
+	//     Delta payloads have a bitmask of the changed tiles (bit 0 of byte 0 = tile 0, tiles in row order) after the emphasis
+	//     Tiles: u8 mode, 0 = 64 raw indices in row order, 1 = 1 index the whole tile is filled with
+	// A file cut off by a crash stays readable up to its last complete packet
+	class VideoRecorder final
+	{
+	public:
+		static constexpr uint32_t TILE_SIZE{ 8 };
+		static constexpr uint16_t VERSION{ 1 };
+		static constexpr uint32_t HEADER_SIZE{ 20 };
+		static constexpr uint32_t PACKET_HEADER_SIZE{ 6 };
+		static constexpr uint8_t EMPHASIS_FLAG{ 1 << 0 };
+
+		enum class PacketType : uint8_t
+		{
+			Keyframe,
+			Delta,
+			Repeat
+		};
+
+		enum class TileMode : uint8_t
+		{
+			Raw,
+			Solid
+		};
+
+		// Param std::filesystem::path file to create, an existing one is overwritten
+		// Param uint32_t, uint32_t size of the frames in pixels, multiples of TILE_SIZE
+		// Param uint32_t, uint32_t frames per second as a fraction, stored for players
+		// Param uint32_t frames between keyframes, bounds how far a decoder has to go back to seek
+		// Throws std::runtime_error when the file can not be created
+		VideoRecorder(std::filesystem::path const& path, uint32_t width, uint32_t height, uint32_t frameRateNumerator, uint32_t frameRateDenominator, uint32_t keyframeInterval = 600);
+		// Writes every queued frame and closes the file
+		~VideoRecorder();
+
+		VideoRecorder(VideoRecorder const&) = delete;
+		VideoRecorder(VideoRecorder&&) = delete;
+		VideoRecorder& operator=(VideoRecorder const&) = delete;
+		VideoRecorder& operator=(VideoRecorder&&) = delete;
+
+		// Call once for every emulated frame
+		// Param std::span palette indices, width x height
+		// Param std::span emphasis bits of every scanline
+		// Param bool does the picture differ from the previous frame, when false nothing is copied
+		// Waits for the writer only when all buffers are queued, frames are never dropped
+		void SubmitFrame(std::span<uint8_t const> indices, std::span<uint8_t const> emphasis, bool isNewPicture = true) noexcept;
+
+		// Return uint64_t frames the writer stored so far
+		[[nodiscard]] uint64_t WrittenFrameCount() const noexcept { return m_WrittenFrames.load(std::memory_order_relaxed); }
+		// Return uint64_t size of the file so far in bytes
+		[[nodiscard]] uint64_t WrittenBytes() const noexcept { return m_WrittenBytes.load(std::memory_order_relaxed); }
+		// Return uint64_t submits that had to wait for a free buffer
+		[[nodiscard]] uint64_t StallCount() const noexcept { return m_Stalls; }
+
+	private:
+		static constexpr uint32_t POOL_SIZE{ 16 };
+
+		struct Job final
+		{
+			enum class Type : uint8_t
+			{
+				Frame,
+				Repeat,
+				Stop
+			};
+
+			Type type{ Type::Stop };
+			uint8_t buffer{ 0 };
+		};
+
+		// Palette indices and the emphasis of every scanline
+		struct Frame final
+		{
+			std::vector<uint8_t> indices{ };
+			std::vector<uint8_t> emphasis{ };
+		};
+
+		uint32_t const m_Width;
+		uint32_t const m_Height;
+		uint32_t const m_TilesX;
+		uint32_t const m_TilesY;
+		uint32_t const m_KeyframeInterval;
+
+		std::vector<Frame> m_Buffers{ };
+		// Frontend -> writer
+		SPSCRing<Job, POOL_SIZE> m_Jobs{ };
+		// Writer -> frontend, buffers that can be reused
+		SPSCRing<uint8_t, POOL_SIZE> m_FreeBuffers{ };
+
+		// Frontend side
+		bool m_HasSubmitted{ false };
+		uint64_t m_Stalls{ 0 };
+
+		// Writer side
+		std::ofstream m_File{ };
+		Frame m_Previous{ };
+		bool m_HasPrevious{ false };
+		uint32_t m_FramesSinceKeyframe{ 0 };
+		// Payload of the packet being encoded
+		std::vector<uint8_t> m_Packet{ };
+		bool m_HasWriteError{ false };
+		std::atomic<uint64_t> m_WrittenFrames{ 0 };
+		std::atomic<uint64_t> m_WrittenBytes{ 0 };
+
+		std::thread m_Thread{ };
+
+		void Run() noexcept;
+
+		// Param Frame the frame to store, swapped with m_Previous afterwards
+		void EncodeFrame(Frame& frame) noexcept;
+		void EncodeTile(Frame const& frame, uint32_t tile) noexcept;
+		[[nodiscard]] bool IsTileEqual(Frame const& frame, uint32_t tile) const noexcept;
+		// Writes m_Packet as the payload
+		void WritePacket(PacketType type, uint8_t flags) noexcept;
+
+		// Return size_t index of the top left pixel of a tile
+		[[nodiscard]] size_t TileOffset(uint32_t tile) const noexcept
+		{
+			return (static_cast<size_t>(tile / m_TilesX) * m_Width + tile % m_TilesX) * TILE_SIZE;
+		}
+	};
+}
+
+#endif
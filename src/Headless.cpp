@@ -0,0 +1,514 @@
+#include "Headless.h"
+
+#include "AudioRecorder.h"
+#include "Emulator.h"
+#include "VideoDecoder.h"
+#include "VideoRecorder.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace NesEm
+{
+	namespace
+	{
+		// Held buttons of both controllers, by the frame they start at
+		using InputScript = std::map<uint64_t, std::array<uint8_t, 2>>;
+
+		// Characters of a controller in an input script, highest bit first
+		constexpr std::string_view BUTTON_ORDER{ "RLDUTSBA" };
+
+		[[nodiscard]] bool ParseNumber(std::string_view text, uint64_t& value) noexcept
+		{
+			auto const [pEnd, error] { std::from_chars(text.data(), text.data() + text.size(), value) };
+			return error == std::errc{ } && pEnd == text.data() + text.size();
+		}
+
+		[[nodiscard]] bool ParseButtons(std::string_view text, uint8_t& buttons) noexcept
+		{
+			if (text.size() != BUTTON_ORDER.size())
+			{
+				return false;
+			}
+
+			buttons = 0;
+			for (char const c : text)
+			{
+				buttons = static_cast<uint8_t>((buttons << 1) | (c != '.'));
+			}
+			return true;
+		}
+
+		// Return std::string_view next whitespace separated word of the line, empty at its end
+		[[nodiscard]] std::string_view NextWord(std::string_view& line) noexcept
+		{
+			size_t const first{ line.find_first_not_of(" \t\r") };
+			if (first == std::string_view::npos)
+			{
+				line = { };
+				return { };
+			}
+
+			line.remove_prefix(first);
+			std::string_view const word{ line.substr(0, line.find_first_of(" \t\r")) };
+			line.remove_prefix(word.size());
+			return word;
+		}
+
+		[[nodiscard]] std::optional<InputScript> LoadInputScript(std::filesystem::path const& path)
+		{
+			std::ifstream input{ path };
+			if (!input.is_open())
+			{
+				SDL_Log("Can not open input script: %s", path.string().c_str());
+				return std::nullopt;
+			}
+
+			InputScript script{ };
+			std::string line{ };
+			for (uint32_t lineNumber{ 1 }; std::getline(input, line); ++lineNumber)
+			{
+				std::string_view text{ line };
+				text = text.substr(0, text.find('#'));
+
+				std::string_view const frameText{ NextWord(text) };
+				if (frameText.empty())
+				{
+					continue;
+				}
+
+				uint64_t frame{ 0 };
+				std::array<uint8_t, 2> buttons{ };
+				std::string_view const controller1{ NextWord(text) };
+				std::string_view const controller2{ NextWord(text) };
+
+				bool const isValid{ ParseNumber(frameText, frame)
+					&& ParseButtons(controller1, buttons[0])
+					&& (controller2.empty() || ParseButtons(controller2, buttons[1]))
+					&& NextWord(text).empty() };
+
+				if (!isValid)
+				{
+					SDL_Log("Invalid line %u in input script: %s", lineNumber, line.c_str());
+					return std::nullopt;
+				}
+
+				script[frame] = buttons;
+			}
+			return script;
+		}
+
+		// Return std::filesystem::path absolute path of an existing ROM, empty when it does not exist
+		// Relative to the working directory like the other paths on the command line, the cartridge would look next to the executable
+		[[nodiscard]] std::filesystem::path ResolveROM(std::filesystem::path const& path)
+		{
+			std::filesystem::path const rom{ std::filesystem::absolute(path) };
+			if (!std::filesystem::exists(rom))
+			{
+				SDL_Log("ROM does not exist: %s", rom.string().c_str());
+				return { };
+			}
+			return rom;
+		}
+
+		// Return std::optional the script, empty without a path, std::nullopt when it can not be loaded
+		[[nodiscard]] std::optional<InputScript> LoadOptionalInputScript(std::filesystem::path const& path)
+		{
+			return path.empty() ? InputScript{ } : LoadInputScript(path);
+		}
+
+		// Feeds two bare APUs the same random register writes and status reads, one a per cycle reference caught up every cycle,
+		// the other event driven and caught up only at its IRQ deadlines and register accesses, as the scheduler does
+		// Covers what a ROM may never do: every channel, DMC samples, IRQs
+		// Param uint64_t frames of traffic
+		// Return bool did the status reads, IRQ timing, audio and raw output all match
+		[[nodiscard]] bool VerifyRegisterTraffic(std::filesystem::path const& rom, uint64_t frames)
+		{
+			// About an NTSC frame, the length doesn't matter for the comparison
+			constexpr uint64_t CYCLES_PER_FRAME{ 29781 };
+			// Every register that can be written, reading $4015 is the last choice
+			constexpr std::array<uint16_t, 22> REGISTERS
+			{
+				0x4000, 0x4001, 0x4002, 0x4003, 0x4004, 0x4005, 0x4006, 0x4007, 0x4008, 0x4009, 0x400A, 0x400B,
+				0x400C, 0x400D, 0x400E, 0x400F, 0x4010, 0x4011, 0x4012, 0x4013, 0x4015, 0x4017
+			};
+
+			// The DMC fetches its samples from the cartridge, each APU gets its own in case the mapper keeps state
+			Cartridge lockstepCart{ rom };
+			Cartridge lazyCart{ rom };
+			APU lockstep{ lockstepCart };
+			APU lazy{ lazyCart };
+			lockstep.SetPerCycleReference(true);
+			lockstep.SetRawOutputCapture(true);
+			lazy.SetRawOutputCapture(true);
+
+			// Fixed seed, a failure has to be reproducible
+			std::mt19937 random{ 0x4E45531A };
+			std::uniform_int_distribution<uint32_t> gap{ 1, 600 };
+			std::uniform_int_distribution<size_t> choice{ 0, REGISTERS.size() };
+			std::uniform_int_distribution<uint32_t> value{ 0, 0xFF };
+
+			std::vector<int16_t> lockstepSamples(Config::AUDIO_SAMPLE_RATE);
+			std::vector<int16_t> lazySamples(Config::AUDIO_SAMPLE_RATE);
+
+			uint64_t cycle{ 0 };
+			bool wasIRQAsserted{ false };
+
+			// Param uint64_t cycle to run both up to, the lockstep one a cycle at a time
+			// Return bool did the lazy APU raise its IRQs at the same cycles
+			auto const runTo{ [&](uint64_t target) -> bool
+			{
+				while (cycle < target)
+				{
+					uint64_t const sync{ std::min(lazy.NextSyncCPUCycle(), target) };
+					while (cycle < sync)
+					{
+						lockstep.CatchUp(++cycle);
+						bool const isIRQAsserted{ lockstep.IsIRQAsserted() };
+						if (isIRQAsserted && !wasIRQAsserted && cycle != sync)
+						{
+							SDL_Log("APU verification failed, IRQ at cycle %llu instead of %llu", static_cast<unsigned long long>(cycle), static_cast<unsigned long long>(sync));
+							return false;
+						}
+						wasIRQAsserted = isIRQAsserted;
+					}
+
+					lazy.CatchUp(cycle);
+					if (lazy.IsIRQAsserted() != lockstep.IsIRQAsserted())
+					{
+						SDL_Log("APU verification failed, IRQ line differs at cycle %llu", static_cast<unsigned long long>(cycle));
+						return false;
+					}
+				}
+				return true;
+			} };
+
+			for (uint64_t frame{ 0 }; frame < frames; ++frame)
+			{
+				uint64_t const frameEnd{ (frame + 1) * CYCLES_PER_FRAME };
+				for (uint64_t next{ cycle + gap(random) }; next < frameEnd; next += gap(random))
+				{
+					if (!runTo(next))
+					{
+						return false;
+					}
+
+					size_t const index{ choice(random) };
+					if (index == REGISTERS.size())
+					{
+						if (lockstep.ReadStatus() != lazy.ReadStatus())
+						{
+							SDL_Log("APU verification failed, $4015 differs at cycle %llu", static_cast<unsigned long long>(cycle));
+							return false;
+						}
+					}
+					else
+					{
+						uint8_t const byte{ static_cast<uint8_t>(value(random)) };
+						lockstep.Write(REGISTERS[index], byte);
+						lazy.Write(REGISTERS[index], byte);
+					}
+					wasIRQAsserted = lockstep.IsIRQAsserted();
+				}
+
+				if (!runTo(frameEnd))
+				{
+					return false;
+				}
+
+				lockstep.EndFrame();
+				lazy.EndFrame();
+				uint32_t const lockstepCount{ lockstep.ReadSamples(lockstepSamples) };
+				uint32_t const lazyCount{ lazy.ReadSamples(lazySamples) };
+				if (!std::ranges::equal(std::span{ lockstepSamples }.first(lockstepCount), std::span{ lazySamples }.first(lazyCount))
+					|| !std::ranges::equal(lockstep.RawOutput(), lazy.RawOutput()))
+				{
+					SDL_Log("APU verification failed, register traffic audio differs at frame %llu", static_cast<unsigned long long>(frame));
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Param InputScript buttons by frame, param uint64_t frame about to run
+		void ApplyInput(Emulator& emulator, InputScript const& script, uint64_t frame) noexcept
+		{
+			if (auto const it{ script.find(frame) }; it != script.end())
+			{
+				emulator.SetControllerButtons(0, it->second[0]);
+				emulator.SetControllerButtons(1, it->second[1]);
+			}
+		}
+	}
+
+	bool IsHeadlessRun(int argc, char* argv[]) noexcept
+	{
+		return argc >= 2 && std::string_view{ argv[1] } == HEADLESS_OPTION;
+	}
+
+	std::optional<HeadlessOptions> ParseHeadlessOptions(int argc, char* argv[])
+	{
+		if (!IsHeadlessRun(argc, argv) || argc < 4)
+		{
+			SDL_Log("%s", "Usage: --headless <rom> <frames> [--input <file>] [--hash-log <file>] [--record <file>] [--audio <file>] [--audio-raw <file>]");
+			return std::nullopt;
+		}
+
+		HeadlessOptions options{ };
+		options.rom = argv[2];
+		if (!ParseNumber(argv[3], options.frames))
+		{
+			SDL_Log("Invalid frame count: %s", argv[3]);
+			return std::nullopt;
+		}
+
+		for (int i{ 4 }; i < argc; i += 2)
+		{
+			std::string_view const option{ argv[i] };
+			if (i + 1 >= argc)
+			{
+				SDL_Log("Missing value for option: %s", argv[i]);
+				return std::nullopt;
+			}
+
+			if (option == "--input")
+			{
+				options.inputScript = argv[i + 1];
+			}
+			else if (option == "--hash-log")
+			{
+				options.hashLog = argv[i + 1];
+			}
+			else if (option == "--record")
+			{
+				options.recording = argv[i + 1];
+			}
+			else if (option == "--audio")
+			{
+				options.audio = argv[i + 1];
+			}
+			else if (option == "--audio-raw")
+			{
+				options.rawAudio = argv[i + 1];
+			}
+			else
+			{
+				SDL_Log("Unknown option: %s", argv[i]);
+				return std::nullopt;
+			}
+		}
+		return options;
+	}
+
+	int RunHeadless(HeadlessOptions const& options)
+	{
+		std::filesystem::path const rom{ ResolveROM(options.rom) };
+		if (rom.empty())
+		{
+			return 1;
+		}
+
+		std::optional<InputScript> const script{ LoadOptionalInputScript(options.inputScript) };
+		if (!script)
+		{
+			return 1;
+		}
+
+		std::ofstream file{ };
+		if (!options.hashLog.empty())
+		{
+			file.open(options.hashLog, std::ios::out | std::ios::trunc);
+			if (!file.is_open())
+			{
+				SDL_Log("Can not open hash log: %s", options.hashLog.string().c_str());
+				return 1;
+			}
+		}
+		std::ostream& log{ options.hashLog.empty() ? std::cout : file };
+
+		try
+		{
+			Emulator emulator{ rom };
+			// Every frame has to be produced to be hashed
+			emulator.SetFrameSkip(Emulator::FrameSkip::Off);
+
+			std::unique_ptr<VideoRecorder> const pRecorder{ options.recording.empty() ? nullptr
+				: std::make_unique<VideoRecorder>(options.recording, Config::SCREEN_WIDTH, Config::SCREEN_HEIGHT, Config::FRAME_RATE_NUMERATOR, Config::FRAME_RATE_DENOMINATOR) };
+			std::unique_ptr<AudioRecorder> const pAudioRecorder{ options.audio.empty() ? nullptr
+				: std::make_unique<AudioRecorder>(options.audio, Config::AUDIO_SAMPLE_RATE, AudioRecorder::FormatOf(options.audio)) };
+			std::unique_ptr<AudioRecorder> const pRawAudioRecorder{ options.rawAudio.empty() ? nullptr
+				: std::make_unique<AudioRecorder>(options.rawAudio, static_cast<uint32_t>(std::lround(Config::CPU_CLOCK_RATE)), AudioRecorder::FormatOf(options.rawAudio)) };
+			emulator.SetRawAudioCapture(pRawAudioRecorder != nullptr);
+
+			for (uint64_t frame{ 0 }; frame < options.frames; ++frame)
+			{
+				ApplyInput(emulator, *script, frame);
+				emulator.RunFrame();
+
+				if (pRecorder)
+				{
+					pRecorder->SubmitFrame(emulator.FrameIndices(), emulator.FrameEmphasis(), emulator.HasNewPicture());
+				}
+				if (pAudioRecorder)
+				{
+					pAudioRecorder->SubmitSamples(emulator.AudioSamples());
+				}
+				if (pRawAudioRecorder)
+				{
+					pRawAudioRecorder->SubmitSamples(emulator.RawAudioSamples());
+				}
+
+				std::array<char, 64> line{ };
+				int const length{ std::snprintf(line.data(), line.size(), "%llu %016llx %016llx\n",
+					static_cast<unsigned long long>(frame),
+					static_cast<unsigned long long>(emulator.FrameHash()),
+					static_cast<unsigned long long>(emulator.RAMHash())) };
+				log.write(line.data(), length);
+			}
+		}
+		catch (std::exception const& e)
+		{
+			SDL_Log("Headless run failed: %s", e.what());
+			return 1;
+		}
+
+		log.flush();
+		if (!log)
+		{
+			SDL_Log("%s", "Could not write the hash log");
+			return 1;
+		}
+
+		SDL_Log("Headless run finished, %llu frames", static_cast<unsigned long long>(options.frames));
+		return 0;
+	}
+
+	bool IsVerifyAPURun(int argc, char* argv[]) noexcept
+	{
+		return argc >= 2 && std::string_view{ argv[1] } == VERIFY_APU_OPTION;
+	}
+
+	int RunVerifyAPU(int argc, char* argv[])
+	{
+		uint64_t frames{ 0 };
+		bool const isValid{ IsVerifyAPURun(argc, argv) && (argc == 4 || (argc == 6 && std::string_view{ argv[4] } == "--input")) };
+		if (!isValid || !ParseNumber(argv[3], frames))
+		{
+			SDL_Log("%s", "Usage: --verify-apu <rom> <frames> [--input <file>]");
+			return 1;
+		}
+
+		std::filesystem::path const rom{ ResolveROM(argv[2]) };
+		if (rom.empty())
+		{
+			return 1;
+		}
+
+		std::optional<InputScript> const script{ LoadOptionalInputScript(argc == 6 ? argv[5] : std::filesystem::path{ }) };
+		if (!script)
+		{
+			return 1;
+		}
+
+		try
+		{
+			Emulator lazy{ rom };
+			Emulator lockstep{ rom };
+			lockstep.SetAPULockstep(true);
+			// Every frame has to be produced to be hashed
+			lazy.SetFrameSkip(Emulator::FrameSkip::Off);
+			lockstep.SetFrameSkip(Emulator::FrameSkip::Off);
+			lazy.SetRawAudioCapture(true);
+			lockstep.SetRawAudioCapture(true);
+
+			for (uint64_t frame{ 0 }; frame < frames; ++frame)
+			{
+				ApplyInput(lazy, *script, frame);
+				ApplyInput(lockstep, *script, frame);
+				lazy.RunFrame();
+				lockstep.RunFrame();
+
+				char const* pDifference{ nullptr };
+				if (lazy.FrameHash() != lockstep.FrameHash())
+				{
+					pDifference = "frame hash";
+				}
+				else if (lazy.RAMHash() != lockstep.RAMHash())
+				{
+					pDifference = "RAM hash";
+				}
+				else if (!std::ranges::equal(lazy.AudioSamples(), lockstep.AudioSamples()))
+				{
+					pDifference = "audio";
+				}
+				else if (!std::ranges::equal(lazy.RawAudioSamples(), lockstep.RawAudioSamples()))
+				{
+					pDifference = "raw APU output";
+				}
+
+				if (pDifference)
+				{
+					SDL_Log("APU verification failed, %s differs at frame %llu", pDifference, static_cast<unsigned long long>(frame));
+					return 1;
+				}
+			}
+		}
+		catch (std::exception const& e)
+		{
+			SDL_Log("APU verification failed: %s", e.what());
+			return 1;
+		}
+
+		try
+		{
+			if (!VerifyRegisterTraffic(rom, frames))
+			{
+				return 1;
+			}
+		}
+		catch (std::exception const& e)
+		{
+			SDL_Log("APU verification failed: %s", e.what());
+			return 1;
+		}
+
+		SDL_Log("APU verification passed, %llu frames", static_cast<unsigned long long>(frames));
+		return 0;
+	}
+
+	bool IsDecodeVideoRun(int argc, char* argv[]) noexcept
+	{
+		return argc >= 2 && std::string_view{ argv[1] } == DECODE_VIDEO_OPTION;
+	}
+
+	int RunDecodeVideo(int argc, char* argv[])
+	{
+		if (!IsDecodeVideoRun(argc, argv) || argc != 4)
+		{
+			SDL_Log("%s", "Usage: --decode-video <recording> <output.y4m>");
+			return 1;
+		}
+
+		try
+		{
+			uint64_t const frames{ ExportY4M(argv[2], argv[3], Emulator::SystemPalette()) };
+			SDL_Log("Decoded %llu frames", static_cast<unsigned long long>(frames));
+		}
+		catch (std::exception const& e)
+		{
+			SDL_Log("Decoding failed: %s", e.what());
+			return 1;
+		}
+		return 0;
+	}
+}
@@ -0,0 +1,81 @@
+#ifndef NES_EMULATOR_HEADLESS
+#define NES_EMULATOR_HEADLESS
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace NesEm
+{
+	// Runs a ROM without a window for a fixed amount of frames and logs a hash of every frame and of RAM,
+	// diffing the log against one of a known good build shows the first frame a change affected
+	//
+	// Command line: --headless <rom> <frames> [--input <file>] [--hash-log <file>] [--record <file>] [--audio <file>] [--audio-raw <file>]
+	//
+	// Input file, one line per change of the held buttons, a state is held until the next line:
+	//   <frame> <controller 1> [controller 2]
+	// Controllers are 8 characters in the order RLDUTSBA (right, left, down, up, start, select, B, A),
+	// any character other than '.' means the button is held. Everything after a '#' is a comment
+	//   0   ........
+	//   120 ....T...   # press start
+	//   122 ........
+	//
+	// Hash log, one line per frame: <frame> <frame hash> <RAM hash>, hashes as 16 hex digits
+	// Record stores the run as a tile delta video (see VideoRecorder)
+	// Audio stores the sound the frontend would play (Config::AUDIO_SAMPLE_RATE), audio raw the APU's mixed output of every cycle
+	// before it is resampled (Config::CPU_CLOCK_RATE), both bit exact 16 bit mono, a WAV file for a .wav extension, raw samples otherwise
+	constexpr std::string_view HEADLESS_OPTION{ "--headless" };
+
+	struct HeadlessOptions final
+	{
+		std::filesystem::path rom{ };
+		uint64_t frames{ 0 };
+		std::filesystem::path inputScript{ };
+		// Empty writes the log to stdout
+		std::filesystem::path hashLog{ };
+		// Empty does not record
+		std::filesystem::path recording{ };
+		// Empty does not record audio
+		std::filesystem::path audio{ };
+		std::filesystem::path rawAudio{ };
+	};
+
+	// Return bool does the command line ask for a headless run
+	[[nodiscard]] bool IsHeadlessRun(int argc, char* argv[]) noexcept;
+
+	// Return std::optional the options of a headless run, std::nullopt when the command line is invalid
+	[[nodiscard]] std::optional<HeadlessOptions> ParseHeadlessOptions(int argc, char* argv[]);
+
+	// Return int exit code for main
+	[[nodiscard]] int RunHeadless(HeadlessOptions const& options);
+
+	// Runs a ROM twice side by side, once with the usual event driven APU caught up lazily and once with a reference APU
+	// that clocks every channel's timer on every cycle and is caught up after every instruction (see Emulator::SetAPULockstep),
+	// and fails at the first frame whose frame hash, RAM hash, audio or raw APU output differ
+	// Then feeds an event driven and a reference APU the same random register traffic for as many frames, the reference caught up
+	// every cycle, and compares their status reads, IRQ timing and output, the ROM alone may leave most of the APU unused
+	// Checks that the event scheduling, the fast forwarding of idle channels and the IRQ deadlines change nothing,
+	// the sequencers, envelopes and mixer are shared and not checked against anything
+	//
+	// Command line: --verify-apu <rom> <frames> [--input <file>], input file as for --headless
+	constexpr std::string_view VERIFY_APU_OPTION{ "--verify-apu" };
+
+	// Return bool does the command line ask to verify the APU's catch-up
+	[[nodiscard]] bool IsVerifyAPURun(int argc, char* argv[]) noexcept;
+
+	// Return int exit code for main, 0 when both runs matched
+	[[nodiscard]] int RunVerifyAPU(int argc, char* argv[]);
+
+	// Converts a recording to a file video tools can read
+	// Command line: --decode-video <recording> <output.y4m>
+	constexpr std::string_view DECODE_VIDEO_OPTION{ "--decode-video" };
+
+	// Return bool does the command line ask to decode a recording
+	[[nodiscard]] bool IsDecodeVideoRun(int argc, char* argv[]) noexcept;
+
+	// Return int exit code for main
+	[[nodiscard]] int RunDecodeVideo(int argc, char* argv[]);
+}
+
+#endif
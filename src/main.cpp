@@ -1,18 +1,44 @@
 #include "ServiceLocator.h"
 #include "SDLRenderer.h"
 #include "InputManager.h"
-
-#include "Timer.h"
+#include "PostProcessor.h"
+#include "NTSCFilter.h"
+#include "FrameDumper.h"
+#include "AudioOutput.h"
 
 #include "Emulator.h"
+#include "EmulationThread.h"
+#include "Headless.h"
+#include "AudioBenchmark.h"
 
+#include <array>
 #include <thread>
+#include <vector>
 
 #include <SDL3/SDL_main.h>
 int main(int argc, char* argv[])
 {
 	using namespace NesEm;
 
+	// Regression runs and tools, no window or renderer
+	if (IsHeadlessRun(argc, argv))
+	{
+		auto const options{ ParseHeadlessOptions(argc, argv) };
+		return options ? RunHeadless(*options) : 1;
+	}
+	if (IsDecodeVideoRun(argc, argv))
+	{
+		return RunDecodeVideo(argc, argv);
+	}
+	if (IsVerifyAPURun(argc, argv))
+	{
+		return RunVerifyAPU(argc, argv);
+	}
+	if (IsAudioBenchmarkRun(argc, argv))
+	{
+		return RunAudioBenchmark(argc, argv);
+	}
+
 	Window gameWindow{ 
 		"NES Emulator",
 		1920,
@@ -27,51 +53,139 @@ int main(int argc, char* argv[])
 		16.f / 9.f,
 		16.f / 9.f
 	};
-	ServiceLocator::RegisterRenderer(std::make_unique<SDLRenderer>(gameWindow));
+
+	// Composite video look, the filter decodes at twice the resolution so the post processor only scales that up 2x
+	constexpr bool useNTSCFilter{ false };
+	std::unique_ptr<NTSCFilter> const pNTSCFilter{ useNTSCFilter ? std::make_unique<NTSCFilter>(Config::SCREEN_WIDTH, Config::SCREEN_HEIGHT) : nullptr };
+	uint32_t const frameWidth{ pNTSCFilter ? pNTSCFilter->OutputWidth() : Config::SCREEN_WIDTH };
+	uint32_t const frameHeight{ pNTSCFilter ? pNTSCFilter->OutputHeight() : Config::SCREEN_HEIGHT };
+
+	// Scaled on the CPU, 4x fills a 1080p screen and is presented 2x on a 4K one
+	PostProcessor postProcessor{ frameWidth, frameHeight, pNTSCFilter ? PostProcessor::Filter::Nearest : PostProcessor::Filter::Scanlines, pNTSCFilter ? 2u : 4u };
+	std::vector<uint32_t> emulatorFrame(static_cast<size_t>(frameWidth) * frameHeight);
+
+	ServiceLocator::RegisterRenderer(std::make_unique<SDLRenderer>(gameWindow, static_cast<int>(postProcessor.OutputWidth()), static_cast<int>(postProcessor.OutputHeight())));
 
 	Renderer& renderer{ ServiceLocator::GetRenderer() };
-	auto& time = GameTime::GetInstance();
+	// Tear rather than wait a whole refresh when a frame comes in late
+	renderer.SetVSync(VSync::Adaptive);
 	auto& input = InputManager::GetInstance();
 
-	// Setup the game time
-	time.SetFPS(50.f);
-
 	// Setup the inputmanager
 	input.AddAction({"Fullscreen", 67, InputManager::InputAction::EventType::KeyDownThisFrame });
+	input.AddAction({"Screenshot", 69, InputManager::InputAction::EventType::KeyDownThisFrame });
+	input.AddAction({"RecordFrames", 68, InputManager::InputAction::EventType::KeyDownThisFrame });
+
+	// Scancodes of controller 1's buttons, by bit (see Controller::Button): X, Z, right shift, enter and the arrow keys
+	constexpr std::array<uint16_t, 8> controllerKeys{ 27, 29, 229, 40, 82, 81, 80, 79 };
+
+	// Screenshots (F12) and frame sequences (F11) of the unfiltered emulator output, written on a background thread
+	// Sequences hold the frames the render thread got, one the emulation replaced before it was fetched shows as a gap
+	FrameDumper frameDumper{ Config::SCREEN_WIDTH, Config::SCREEN_HEIGHT, std::filesystem::path{ SDL_GetBasePath() } / "Screenshots" };
+	std::vector<uint32_t> framePixels(static_cast<size_t>(Config::SCREEN_WIDTH) * Config::SCREEN_HEIGHT);
 
 
 	// Initialize the NES emulator
 	Emulator emulator{ };
+	// Drop up to 3 frames in a row when the host can't keep up
+	emulator.SetFrameSkip(Emulator::FrameSkip::Adaptive, 3);
 
+	AudioOutput audioOutput{ Config::AUDIO_SAMPLE_RATE };
 
 	// toggle displaying fps in console window
 	constexpr bool displayFPS{ false };
-	float fpsTimer{ 0.f };
-	auto fpsCount{ 0 };
-
 
+	// Emulation runs on its own thread from here on, this one only handles input and presents what it produces
+	EmulationThread::Settings emulationSettings{ };
+	// Paced by GameTime's frame clock, frames line up with the display and dynamic rate control keeps the audio in step
+	// Pacing::Audio lets the audio device's clock pace emulation instead, the sound never glitches and nothing spins,
+	// worth it when audio matters more than smooth video, falls back to the timer without an audio device
+	emulationSettings.pacing = EmulationThread::Pacing::Timer;
+	// E.g. pin it to a core of its own and raise its priority on a busy machine
+	emulationSettings.cpu = -1;
+	emulationSettings.priority = SDL_THREAD_PRIORITY_NORMAL;
+	emulationSettings.logStatistics = displayFPS;
+	EmulationThread emulationThread{ emulator, audioOutput, emulationSettings };
+
+	uint64_t fpsStart{ SDL_GetTicksNS() };
+	uint64_t fpsCount{ 0 };
+
+	EmulationThread::Frame const* pFrame{ nullptr };
 	bool isRunning{ true };
 	while (isRunning)
 	{
-		time.Update();
-
 		isRunning = input.ProcessInput();
 		if (input.IsActionExecuted("Fullscreen"))
 		{
 			renderer.ToggleFullScreen();
 		}
+		if (input.IsWindowDirty())
+		{
+			renderer.Invalidate();
+		}
 
-		while(time.IsLag())
+		std::array<uint8_t, 2> buttons{ };
+		for (size_t button{ 0 }; button < controllerKeys.size(); ++button)
 		{
-			//Fixed Update if necessary
-			time.ProcessLag();
+			buttons[0] |= static_cast<uint8_t>(input.IsKeyHeld(controllerKeys[button]) << button);
 		}
+		emulationThread.SubmitInput(buttons);
 
-		//Update
-		emulator.Run();
+		// The previous frame stays valid when no new one came in
+		EmulationThread::Frame const* const pNewFrame{ emulationThread.FetchFrame() };
+		if (pNewFrame)
+		{
+			pFrame = pNewFrame;
+		}
 
-		//Render
-		emulator.Render();
+		if (input.IsActionExecuted("RecordFrames"))
+		{
+			if (frameDumper.IsRecordingSequence())
+			{
+				frameDumper.StopSequence();
+			}
+			else
+			{
+				frameDumper.StartSequence();
+			}
+		}
+		// Only converted to ARGB when something wants the pixels
+		bool const isRecordingFrame{ pNewFrame && frameDumper.IsRecordingSequence() };
+		bool const isScreenshot{ pFrame && input.IsActionExecuted("Screenshot") };
+		if (isRecordingFrame || isScreenshot)
+		{
+			Emulator::Render(pFrame->indices, framePixels.data(), static_cast<int>(Config::SCREEN_WIDTH * sizeof(uint32_t)));
+		}
+		if (isRecordingFrame)
+		{
+			frameDumper.SubmitFrame(framePixels);
+		}
+		if (isScreenshot)
+		{
+			static_cast<void>(frameDumper.Screenshot(framePixels));
+		}
+
+		//Render, the renderer only hands out the texture when it holds a different picture than the emulator's
+		// and only presents when it was given one (or the window needs a redraw)
+		if (pNewFrame)
+		{
+			if (auto const lock{ renderer.LockFrame(pNewFrame->sequence) }; lock.pPixels)
+			{
+				int const framePitch{ static_cast<int>(frameWidth * sizeof(uint32_t)) };
+				if (pNTSCFilter)
+				{
+					pNTSCFilter->Process(pNewFrame->indices, pNewFrame->emphasis, pNewFrame->phases, emulatorFrame.data(), framePitch);
+				}
+				else
+				{
+					Emulator::Render(pNewFrame->indices, emulatorFrame.data(), framePitch);
+				}
+
+				// The scaled frame is written straight into the texture memory
+				postProcessor.Process(emulatorFrame.data(), lock.pPixels, lock.pitch);
+				renderer.UnlockFrame();
+			}
+		}
 		renderer.Render();
 
 		//TODO
@@ -79,20 +193,35 @@ int main(int argc, char* argv[])
 				SteamAPI_RunCallbacks();
 		#endif*/
 
-		fpsTimer += time.ElapsedSec();
-		++fpsCount;
+		if (pNewFrame)
+		{
+			++fpsCount;
+		}
 		if (displayFPS)
 		{
-			if (fpsTimer >= 1.0f)
+			uint64_t const now{ SDL_GetTicksNS() };
+			if (now - fpsStart >= 1'000'000'000)
 			{
-				SDL_Log("FPS: %.1f", static_cast<float>(fpsCount) / fpsTimer);
+				SDL_Log("FPS: %.1f", static_cast<double>(fpsCount) * 1'000'000'000.0 / static_cast<double>(now - fpsStart));
+				SDL_Log("Post processing: %.3f ms", static_cast<double>(postProcessor.AverageProcessTimeNs()) / 1'000'000.0);
+				if (frameDumper.IsRecordingSequence())
+				{
+					SDL_Log("Frames written: %llu, dropped: %llu", static_cast<unsigned long long>(frameDumper.WrittenFrameCount()), static_cast<unsigned long long>(frameDumper.DroppedFrameCount()));
+				}
+				if (pNTSCFilter)
+				{
+					SDL_Log("NTSC filter: %.3f ms", static_cast<double>(pNTSCFilter->AverageProcessTimeNs()) / 1'000'000.0);
+				}
 				fpsCount = 0;
-				fpsTimer = 0.f;
+				fpsStart = now;
 			}
 		}
 
-		//Cap FPS
-		SDL_Delay(time.SleepTime());
+		// Nothing to present until the emulation finished its next frame, window events wait that long at most
+		if (!pNewFrame)
+		{
+			emulationThread.WaitForFrame();
+		}
 	}
 
     return 0;